@@ -7,17 +7,28 @@ layout(location = 2) in ivec4 bone_ids;
 layout(location = 3) in vec4 bone_weights;
 
 uniform mat4 mvp;
-const int MAX_BONES = 100;
-uniform mat4 bones[MAX_BONES];
+uniform samplerBuffer bone_buffer;
+uniform int bone_offset;
 
-void main()
+// each bone is the top three rows of its skinning matrix; the bottom row is always 0, 0, 0, 1
+vec4 bone_row(int bone, int row)
 {
-	mat4 bone_transform = bones[bone_ids[0]] * bone_weights[0];
-	bone_transform += bones[bone_ids[1]] * bone_weights[1];
-	bone_transform += bones[bone_ids[2]] * bone_weights[2];
-	bone_transform += bones[bone_ids[3]] * bone_weights[3];
+	return texelFetch(bone_buffer, (bone_offset + bone) * 3 + row);
+}
 
-	vec4 pos_model = (bone_transform * vec4(in_position, 1));
+void main()
+{
+	vec4 rows[3];
+	for (int i = 0; i < 3; i++)
+	{
+		rows[i] = bone_row(bone_ids[0], i) * bone_weights[0]
+			+ bone_row(bone_ids[1], i) * bone_weights[1]
+			+ bone_row(bone_ids[2], i) * bone_weights[2]
+			+ bone_row(bone_ids[3], i) * bone_weights[3];
+	}
+
+	vec4 position = vec4(in_position, 1);
+	vec4 pos_model = vec4(dot(rows[0], position), dot(rows[1], position), dot(rows[2], position), dot(bone_weights, vec4(1)));
 	gl_Position =  mvp * pos_model;
 }
 
@@ -47,21 +58,33 @@ out vec3 normal_viewspace;
 
 uniform mat4 mvp;
 uniform mat4 mv;
-const int MAX_BONES = 100;
-uniform mat4 bones[MAX_BONES];
+uniform samplerBuffer bone_buffer;
+uniform int bone_offset;
+
+// each bone is the top three rows of its skinning matrix; the bottom row is always 0, 0, 0, 1
+vec4 bone_row(int bone, int row)
+{
+	return texelFetch(bone_buffer, (bone_offset + bone) * 3 + row);
+}
 
 void main()
 {
-	mat4 bone_transform = bones[bone_ids[0]] * bone_weights[0];
-	bone_transform += bones[bone_ids[1]] * bone_weights[1];
-	bone_transform += bones[bone_ids[2]] * bone_weights[2];
-	bone_transform += bones[bone_ids[3]] * bone_weights[3];
+	vec4 rows[3];
+	for (int i = 0; i < 3; i++)
+	{
+		rows[i] = bone_row(bone_ids[0], i) * bone_weights[0]
+			+ bone_row(bone_ids[1], i) * bone_weights[1]
+			+ bone_row(bone_ids[2], i) * bone_weights[2]
+			+ bone_row(bone_ids[3], i) * bone_weights[3];
+	}
 
 	// Output position of the vertex, in clip space : MVP * position
-	vec4 pos_model = (bone_transform * vec4(in_position, 1));
+	vec4 position = vec4(in_position, 1);
+	vec4 pos_model = vec4(dot(rows[0], position), dot(rows[1], position), dot(rows[2], position), dot(bone_weights, vec4(1)));
 	gl_Position =  mvp * pos_model;
-	
-	normal_viewspace = (mv * (bone_transform * vec4(in_normal, 0))).xyz;
+
+	vec3 normal_model = vec3(dot(rows[0].xyz, in_normal), dot(rows[1].xyz, in_normal), dot(rows[2].xyz, in_normal));
+	normal_viewspace = (mv * vec4(normal_model, 0)).xyz;
 }
 
 #else
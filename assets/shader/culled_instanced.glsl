@@ -0,0 +1,101 @@
+#ifdef SHADOW
+
+#ifdef VERTEX
+
+layout(location = 0) in vec3 in_position;
+layout(location = 2) in mat4 in_model_matrix;
+
+uniform mat4 vp;
+
+void main()
+{
+	gl_Position = vp * in_model_matrix * vec4(in_position, 1);
+}
+
+#else
+
+out vec4 out_color;
+
+void main()
+{
+	out_color = vec4(1, 1, 1, 1);
+}
+
+#endif
+
+#else
+
+// Default technique
+
+#ifdef VERTEX
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec3 in_normal;
+layout(location = 2) in mat4 in_model_matrix;
+layout(location = 6) in vec4 in_color;
+
+out vec3 normal_viewspace;
+out vec3 pos_viewspace;
+out vec4 color;
+
+uniform mat4 vp;
+uniform mat4 v;
+
+void main()
+{
+	vec4 pos_world = in_model_matrix * vec4(in_position, 1);
+	gl_Position = vp * pos_world;
+
+	pos_viewspace = (v * pos_world).xyz;
+
+	normal_viewspace = (v * in_model_matrix * vec4(in_normal, 0)).xyz;
+
+	color = in_color;
+}
+
+#else
+
+in vec3 normal_viewspace;
+in vec3 pos_viewspace;
+in vec4 color;
+
+// Values that stay constant for the whole mesh.
+uniform vec4 diffuse_color;
+uniform vec3 cull_center;
+uniform vec3 range_center;
+uniform vec3 wall_normal;
+uniform float cull_radius;
+uniform bool cull_behind_wall;
+uniform bool frontface;
+
+#define DRONE_RADIUS 0.2f
+
+layout (location = 0) out vec4 out_color;
+layout (location = 1) out vec4 out_normal;
+
+void main()
+{
+	vec3 p = pos_viewspace - range_center;
+				
+	if (dot(p, wall_normal) > -DRONE_RADIUS + 0.01f) // is the pixel in front of the wall?
+	{
+		// in front of wall
+		vec3 p2 = pos_viewspace - cull_center;
+		if (p2.z < -(p2.x * p2.x + p2.y * p2.y)) // inside view cone
+			discard;
+	}
+	else
+	{
+		// behind wall
+		if (cull_behind_wall
+			&& dot(pos_viewspace.xy, pos_viewspace.xy) < (cull_radius * cull_radius * 0.5f * 0.5f)) // inside view cylinder
+			discard;
+	}
+
+	out_color = diffuse_color * color;
+	out_normal = vec4(normalize(normal_viewspace) * 0.5f + 0.5f, frontface);
+}
+
+#endif
+
+#endif
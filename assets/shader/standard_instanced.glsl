@@ -32,8 +32,10 @@ void main()
 layout(location = 0) in vec3 in_position;
 layout(location = 1) in vec3 in_normal;
 layout(location = 2) in mat4 in_model_matrix;
+layout(location = 6) in vec4 in_color;
 
 out vec3 normal_viewspace;
+out vec4 color;
 
 uniform mat4 vp;
 uniform mat4 v;
@@ -43,11 +45,14 @@ void main()
 	gl_Position = vp * in_model_matrix * vec4(in_position, 1);
 
 	normal_viewspace = (v * in_model_matrix * vec4(in_normal, 0)).xyz;
+
+	color = in_color;
 }
 
 #else
 
 in vec3 normal_viewspace;
+in vec4 color;
 
 // Values that stay constant for the whole mesh.
 uniform vec4 diffuse_color;
@@ -57,7 +62,7 @@ layout (location = 1) out vec4 out_normal;
 
 void main()
 {
-	out_color = diffuse_color;
+	out_color = diffuse_color * color;
 	out_normal = vec4(normalize(normal_viewspace) * 0.5 + 0.5, 1.0);
 }
 
@@ -98,7 +98,6 @@ void update(const Update& u)
 		sync_in.unlock();
 	}
 
-	sync_out.lock();
 	while (sync_out.can_read())
 	{
 		Callback cb;
@@ -181,7 +180,6 @@ void update(const Update& u)
 			}
 		}
 	}
-	sync_out.unlock();
 }
 
 b8 match(Team t, TeamMask m)
@@ -255,6 +253,7 @@ void load(AssetID id, const char* filename)
 	new (&drone_nav_mesh) DroneNavMesh();
 	drone_nav_mesh_key.~DroneNavMeshKey();
 	new (&drone_nav_mesh_key) Worker::DroneNavMeshKey();
+	astar_queue.clear(); // nodes left over from the last query point into the old mesh
 
 	if (filename)
 	{
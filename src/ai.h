@@ -188,6 +188,8 @@ namespace Worker
 		r32 travel_score;
 		r32 estimate_score;
 		DroneNavMeshNode parent;
+		s32 heap_index; // position in AstarQueue; only valid while FlagInQueue is set
+		u32 generation; // if this doesn't match DroneNavMeshKey::generation, the node is untouched by the current query
 		s8 flags;
 
 		inline void flag(Flags f, b8 v)
@@ -207,13 +209,16 @@ namespace Worker
 	struct DroneNavMeshKey
 	{
 		Chunks<Array<DroneNavMeshNodeData>> data;
+		u32 generation;
+		DroneNavMeshKey();
 		r32 priority(const DroneNavMeshNode&);
+		void heap_index(const DroneNavMeshNode&, s32);
 		void resize(const DroneNavMesh&);
 		void reset();
 		DroneNavMeshNodeData& get(const DroneNavMeshNode&);
 	};
 
-	typedef PriorityQueue<DroneNavMeshNode, DroneNavMeshKey> AstarQueue;
+	typedef IndexedPriorityQueue<DroneNavMeshNode, DroneNavMeshKey> AstarQueue;
 
 	struct DroneNavContext
 	{
@@ -232,7 +237,7 @@ namespace Worker
 	const extern r32 default_search_extents[];
 
 	extern dtNavMesh* nav_mesh;
-	extern dtNavMeshQuery* nav_mesh_query;
+	extern thread_local dtNavMeshQuery* nav_mesh_query;
 	extern dtTileCache* nav_tile_cache;
 	extern dtQueryFilter default_query_filter;
 	extern dtTileCache* nav_tile_cache;
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "types.h"
+#include "data/import_common.h"
+
+namespace VI
+{
+
+namespace AI
+{
+
+// vertex-to-vertex drone pathfinds as the AI worker ran them, for drone_astar_bench.
+// turn on RECORD_DRONE_PATHFIND in ai_worker.cpp to write one; it starts over every time a level loads.
+// layout: Header, then header.path_length chars of nav mesh path, then Records until the end of the file.
+struct DronePathfindRecording
+{
+	static const u32 magic = 0x44525044; // "DPRD"
+	static const s32 version = 1;
+
+	struct Header
+	{
+		u32 magic;
+		s32 version;
+		s32 path_length;
+	};
+
+	struct Record
+	{
+		DroneNavMeshNode start;
+		DroneNavMeshNode end;
+		s8 rule; // DroneAllow
+		s8 team; // AI::Team
+	};
+};
+
+}
+
+}
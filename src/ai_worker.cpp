@@ -5,19 +5,27 @@
 #include "recast/Detour/Include/DetourCommon.h"
 #include "mersenne/mersenne-twister.h"
 #include "game/audio.h"
+#include "settings.h"
 
 #define DEBUG_WALK 0
 #define DEBUG_DRONE 0
 #define DEBUG_AUDIO 0
+#define RECORD_DRONE_PATHFIND 0 // writes drone_pathfind.rec for drone_astar_bench
 
 #if DEBUG_WALK || DEBUG_DRONE
 #include "platform/util.h"
 #endif
 
+#if RECORD_DRONE_PATHFIND
+#include "ai_record.h"
+#endif
+
 // bias toward longer shots
 #define DRONE_PATH_BIAS 4.0f
 // bias away from enemy force fields
 #define DRONE_FORCE_FIELD_BIAS 12.0f
+#define AI_MAX_WORKERS 8
+#define AI_JOB_QUEUE_SIZE 64
 
 namespace VI
 {
@@ -34,10 +42,49 @@ dtTileCache* nav_tile_cache = nullptr;
 dtTileCacheAlloc nav_tile_allocator;
 FastLZCompressor nav_tile_compressor;
 NavMeshProcess nav_tile_mesh_process;
-dtNavMeshQuery* nav_mesh_query = nullptr;
+thread_local dtNavMeshQuery* nav_mesh_query = nullptr; // each pathfinding worker has its own
 dtQueryFilter default_query_filter = dtQueryFilter();
+thread_local u32 worker_random_state; // each pathfinding worker has its own
 const r32 default_search_extents[] = { 15, 10, 15 };
 
+#if RECORD_DRONE_PATHFIND
+FILE* drone_pathfind_record_file = nullptr;
+std::mutex drone_pathfind_record_mutex; // workers record concurrently
+
+// called by the dispatch thread while the pool is idle
+void drone_pathfind_record_open(const char* nav_path, s32 nav_path_length)
+{
+	if (drone_pathfind_record_file)
+		fclose(drone_pathfind_record_file);
+	drone_pathfind_record_file = nullptr;
+	if (nav_path_length == 0)
+		return;
+
+	drone_pathfind_record_file = fopen("drone_pathfind.rec", "wb");
+	if (!drone_pathfind_record_file)
+	{
+		fprintf(stderr, "%s\n", "Can't open drone_pathfind.rec for writing");
+		return;
+	}
+	DronePathfindRecording::Header header;
+	header.magic = DronePathfindRecording::magic;
+	header.version = DronePathfindRecording::version;
+	header.path_length = nav_path_length;
+	fwrite(&header, sizeof(header), 1, drone_pathfind_record_file);
+	fwrite(nav_path, sizeof(char), nav_path_length, drone_pathfind_record_file);
+}
+
+void drone_pathfind_record(DroneAllow rule, Team team, const DroneNavMeshNode& start_vertex, const DroneNavMeshNode& end_vertex)
+{
+	std::lock_guard<std::mutex> lock(drone_pathfind_record_mutex);
+	if (drone_pathfind_record_file)
+	{
+		DronePathfindRecording::Record record = { start_vertex, end_vertex, s8(rule), s8(team) };
+		fwrite(&record, sizeof(record), 1, drone_pathfind_record_file);
+	}
+}
+#endif
+
 dtPolyRef get_poly(const Vec3& pos, const r32* search_extents)
 {
 	dtPolyRef result;
@@ -47,6 +94,17 @@ dtPolyRef get_poly(const Vec3& pos, const r32* search_extents)
 	return result;
 }
 
+// xorshift. detour's random callback takes no context, so it reads the calling worker's own state
+r32 worker_randf_co()
+{
+	u32 x = worker_random_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	worker_random_state = x;
+	return r32(x >> 8) * (1.0f / 16777216.0f);
+}
+
 struct AstarScorer
 {
 	// calculate heuristic score for nav mesh vertex
@@ -328,8 +386,8 @@ void drone_astar(const DroneNavContext& ctx, DroneAllow rule, Team team, const D
 
 	const Vec3& start_pos = ctx.mesh.chunks[start_vertex.chunk].vertices[start_vertex.vertex];
 
-	ctx.key->reset();
 	ctx.astar_queue->clear();
+	ctx.key->reset();
 	ctx.astar_queue->push(start_vertex);
 
 	{
@@ -419,14 +477,7 @@ void drone_astar(const DroneNavContext& ctx, DroneAllow rule, Team team, const D
 							adjacent_data->travel_score = candidate_travel_score;
 
 							// update its position in the queue due to the score change
-							for (s32 j = 0; j < ctx.astar_queue->size(); j++)
-							{
-								if (ctx.astar_queue->heap[j].equals(adjacent_node))
-								{
-									ctx.astar_queue->update(j);
-									break;
-								}
-							}
+							ctx.astar_queue->update(adjacent_data->heap_index);
 						}
 					}
 					else
@@ -436,7 +487,7 @@ void drone_astar(const DroneNavContext& ctx, DroneAllow rule, Team team, const D
 						adjacent_data->parent = vertex_node;
 						adjacent_data->travel_score = candidate_travel_score;
 						adjacent_data->estimate_score = scorer->score(adjacent_pos);
-						adjacent_data->flag(DroneNavMeshNodeData::FlagVisited, true);
+						adjacent_data->flag(DroneNavMeshNodeData::FlagInQueue, true);
 						ctx.astar_queue->push(adjacent_node);
 					}
 				}
@@ -454,6 +505,9 @@ void drone_pathfind(const DroneNavContext& ctx, DroneAllow rule, Team team, cons
 	path->length = 0;
 	if (start_vertex.equals(DRONE_NAV_MESH_NODE_NONE) || end_vertex.equals(DRONE_NAV_MESH_NODE_NONE))
 		return;
+#if RECORD_DRONE_PATHFIND
+	drone_pathfind_record(rule, team, start_vertex, end_vertex);
+#endif
 	PathfindScorer scorer;
 	scorer.end_vertex = end_vertex;
 	scorer.end_pos = ctx.mesh.chunks[end_vertex.chunk].vertices[end_vertex.vertex];
@@ -738,43 +792,536 @@ void pathfind(const NavGameState& nav_game_state, AI::Team team, const Vec3& a,
 	}
 }
 
-void loop()
+// query ops (pathfinding, closest point) are read by the dispatch thread and handed to a pool of workers.
+// each worker has its own Recast query and A* scratch space over the shared read-only nav meshes.
+// ops that mutate nav data (Load, obstacles, state updates) run on the dispatch thread once the pool is idle.
+// results are written to sync_out in the same order the requests came in, since callback IDs depend on it.
+struct Job
 {
-	nav_mesh_query = dtAllocNavMeshQuery();
-	default_query_filter.setIncludeFlags(u16(-1));
-	default_query_filter.setExcludeFlags(0);
+	Op op;
+	DronePathfind drone_pathfind;
+	DroneAllow rule;
+	Team team;
+	s8 listener;
+	Vec3 a;
+	Vec3 a_normal;
+	Vec3 b;
+	Vec3 b_normal;
+	r32 value; // RandomPath range or AudioPathfind straight distance
+	u32 seed; // RandomPath random generator seed
+	LinkEntryArg<Path> callback; // only copied back out to sync_out
+	Ref<AudioEntry> audio_entry;
+	b8 done;
+
+	// results
+	Path path;
+	DronePath drone_path;
+	DronePathNode drone_point;
+	Vec3 point;
+	r32 path_length;
+};
 
-	DroneNavMesh drone_nav_mesh;
+struct WorkerState
+{
+	dtNavMeshQuery* nav_mesh_query;
 	DroneNavMeshKey drone_nav_mesh_key;
-	NavGameState nav_game_state;
-	NavGameState nav_game_state_empty;
-	AstarQueue astar_queue(&drone_nav_mesh_key);
-	Revision level_revision = 0;
+	AstarQueue astar_queue;
+
+	WorkerState()
+		: nav_mesh_query(), drone_nav_mesh_key(), astar_queue(&drone_nav_mesh_key)
+	{
+	}
+};
+
+struct JobPool
+{
+	Job jobs[AI_JOB_QUEUE_SIZE];
+	WorkerState workers[AI_MAX_WORKERS];
+	s32 worker_count;
+	u32 job_write; // next job to be filled by the dispatch thread
+	u32 job_claim; // next job to be picked up by a worker
+	u32 job_flush; // next job whose result will be written to sync_out
+	b8 quit;
+	std::mutex mutex;
+	std::condition_variable job_available;
+	std::condition_variable job_finished;
+};
+
+JobPool pool;
+DroneNavMesh drone_nav_mesh;
+NavGameState nav_game_state;
+NavGameState nav_game_state_empty;
+
+// called by the dispatch thread
+void job_read(Op op, Job* job)
+{
+	job->op = op;
+	switch (op)
+	{
+		case Op::Pathfind:
+		{
+			sync_in.read(&job->team);
+			sync_in.read(&job->a);
+			sync_in.read(&job->b);
+			sync_in.read(&job->callback);
+			break;
+		}
+		case Op::RandomPath:
+		{
+			sync_in.read(&job->a);
+			sync_in.read(&job->b);
+			sync_in.read(&job->team);
+			sync_in.read(&job->value);
+			sync_in.read(&job->callback);
+			// roll the dice here so workers don't fight over the random generator
+			job->value *= 0.75f + mersenne::randf_co() * 0.5f;
+			job->seed = u32(mersenne::rand()) | 1;
+			break;
+		}
+		case Op::ClosestWalkPoint:
+		{
+			sync_in.read(&job->a);
+			sync_in.read(&job->callback);
+			break;
+		}
+		case Op::DronePathfind:
+		{
+			sync_in.read(&job->drone_pathfind);
+			sync_in.read(&job->rule);
+			sync_in.read(&job->team);
+			sync_in.read(&job->callback);
+			sync_in.read(&job->a);
+			sync_in.read(&job->a_normal);
+			switch (job->drone_pathfind)
+			{
+				case DronePathfind::LongRange:
+				case DronePathfind::Away:
+				{
+					sync_in.read(&job->b);
+					sync_in.read(&job->b_normal);
+					break;
+				}
+				case DronePathfind::Target:
+				case DronePathfind::Spawn:
+				{
+					sync_in.read(&job->b);
+					break;
+				}
+				case DronePathfind::Random:
+				{
+					// pick the goal here so workers don't fight over the random generator
+					job->b = drone_nav_mesh.vmin +
+					Vec3
+					(
+						mersenne::randf_co() * (drone_nav_mesh.size.x * drone_nav_mesh.chunk_size),
+						mersenne::randf_co() * (drone_nav_mesh.size.y * drone_nav_mesh.chunk_size),
+						mersenne::randf_co() * (drone_nav_mesh.size.z * drone_nav_mesh.chunk_size)
+					);
+					break;
+				}
+				default:
+				{
+					vi_assert(false);
+					break;
+				}
+			}
+			break;
+		}
+		case Op::DroneClosestPoint:
+		{
+			sync_in.read(&job->callback);
+			sync_in.read(&job->team);
+			sync_in.read(&job->a);
+			break;
+		}
+		case Op::AudioPathfind:
+		{
+			sync_in.read(&job->audio_entry);
+			sync_in.read(&job->listener);
+			sync_in.read(&job->a);
+			sync_in.read(&job->b);
+			sync_in.read(&job->value);
+			break;
+		}
+		default:
+		{
+			vi_assert(false);
+			break;
+		}
+	}
+}
+
+// called on a worker thread without any locks held
+void job_execute(const DroneNavContext& ctx, const DroneNavContext& ctx_audio, Job* job)
+{
+	switch (job->op)
+	{
+		case Op::Pathfind:
+		{
+#if DEBUG_WALK
+			r64 start_time = platform::time();
+			vi_debug("%s", "Walk pathfind...");
+#endif
+			dtPolyRef start_poly = get_poly(job->a, default_search_extents);
+			dtPolyRef end_poly = get_poly(job->b, default_search_extents);
+
+			job->path.length = 0;
+			if (start_poly && end_poly)
+				pathfind(nav_game_state, job->team, job->a, job->b, start_poly, end_poly, &job->path);
+
+#if DEBUG_WALK
+			vi_debug("%d nodes in %fs", job->path.length, r32(platform::time() - start_time));
+#endif
+			break;
+		}
+		case Op::RandomPath:
+		{
+#if DEBUG_WALK
+			r64 start_time = platform::time();
+			vi_debug("%s", "Walk random path...");
+#endif
+			const Vec3& start = job->a;
+			const Vec3& patrol_point = job->b;
+			r32 range = job->value;
+
+			dtPolyRef start_poly = get_poly(start, default_search_extents);
+			dtPolyRef patrol_point_poly = get_poly(patrol_point, default_search_extents);
+
+			u32 hash_start = force_field_hash(nav_game_state, job->team, start);
+
+			worker_random_state = job->seed;
+
+			Vec3 end;
+			dtPolyRef end_poly;
+			b8 valid = false;
+			{
+				s32 tries = 0;
+				do
+				{
+					nav_mesh_query->findRandomPointAroundCircle(patrol_point_poly, (r32*)(&patrol_point), range, &default_query_filter, worker_randf_co, &end_poly, (r32*)(&end));
+					valid = force_field_hash(nav_game_state, job->team, end) == hash_start;
+					tries++;
+				} while (!valid && tries < 20);
+			}
+
+			job->path.length = 0;
+			if (start_poly && end_poly && valid)
+				pathfind(nav_game_state, job->team, start, end, start_poly, end_poly, &job->path);
+
+#if DEBUG_WALK
+			vi_debug("%d nodes in %fs", job->path.length, r32(platform::time() - start_time));
+#endif
+			break;
+		}
+		case Op::ClosestWalkPoint:
+		{
+#if DEBUG_WALK
+			r64 start_time = platform::time();
+			vi_debug("%s", "Walkable point query...");
+#endif
+			dtPolyRef poly = get_poly(job->a, default_search_extents);
+			nav_mesh_query->closestPointOnPoly(poly, (r32*)(&job->a), (r32*)(&job->point), 0);
+
+#if DEBUG_WALK
+			vi_debug("Done in %fs", r32(platform::time() - start_time));
+#endif
+			break;
+		}
+		case Op::DronePathfind:
+		{
+			DronePath* path = &job->drone_path;
+			path->length = 0;
+			switch (job->drone_pathfind)
+			{
+				case DronePathfind::LongRange:
+				{
+					drone_pathfind
+					(
+						ctx,
+						job->rule,
+						job->team,
+						drone_closest_point(drone_nav_mesh, nav_game_state, job->team, job->a, job->a_normal),
+						drone_closest_point(drone_nav_mesh, nav_game_state, job->team, job->b, job->b_normal),
+						path
+					);
+					break;
+				}
+				case DronePathfind::Target:
+				{
+					drone_pathfind_hit(ctx, job->rule, job->team, job->a, job->a_normal, job->b, path);
+					break;
+				}
+				case DronePathfind::Spawn:
+				{
+					SpawnScorer scorer;
+					scorer.mesh = &drone_nav_mesh;
+					scorer.dir = job->b;
+					scorer.start_pos = job->a;
+					scorer.start_vertex = drone_closest_point(drone_nav_mesh, nav_game_state, job->team, job->a, job->a_normal);
+
+					drone_astar(ctx, job->rule, job->team, scorer.start_vertex, &scorer, path);
+					break;
+				}
+				case DronePathfind::Random:
+				{
+					RandomScorer scorer;
+					scorer.mesh = &drone_nav_mesh;
+					scorer.start_vertex = drone_closest_point(drone_nav_mesh, nav_game_state, job->team, job->a, job->a_normal);
+					scorer.start_pos = job->a;
+					scorer.minimum_distance = job->rule == DroneAllow::Crawl ? DRONE_MAX_DISTANCE * 0.5f : DRONE_MAX_DISTANCE * 3.0f;
+					scorer.minimum_distance = vi_min(scorer.minimum_distance,
+						vi_min(drone_nav_mesh.size.x, drone_nav_mesh.size.z) * drone_nav_mesh.chunk_size * 0.5f);
+					scorer.goal = job->b;
+
+					drone_astar(ctx, job->rule, job->team, scorer.start_vertex, &scorer, path);
+					break;
+				}
+				case DronePathfind::Away:
+				{
+					AwayScorer scorer;
+					scorer.mesh = &drone_nav_mesh;
+					scorer.start_vertex = drone_closest_point(drone_nav_mesh, nav_game_state, job->team, job->a, job->a_normal);
+					scorer.away_vertex = drone_closest_point(drone_nav_mesh, nav_game_state, job->team, job->b, job->b_normal);
+					if (!scorer.away_vertex.equals(DRONE_NAV_MESH_NODE_NONE))
+					{
+						scorer.away_pos = job->b;
+						scorer.minimum_distance = job->rule == DroneAllow::Crawl ? DRONE_MAX_DISTANCE * 0.5f : DRONE_MAX_DISTANCE * 3.0f;
+						scorer.minimum_distance = vi_min(scorer.minimum_distance,
+							vi_min(drone_nav_mesh.size.x, drone_nav_mesh.size.z) * drone_nav_mesh.chunk_size * 0.5f);
+
+						drone_astar(ctx, job->rule, job->team, scorer.start_vertex, &scorer, path);
+					}
+					break;
+				}
+				default:
+				{
+					vi_assert(false);
+					break;
+				}
+			}
+			break;
+		}
+		case Op::DroneClosestPoint:
+		{
+			DronePathNode* result = &job->drone_point;
+			result->ref = drone_closest_point(drone_nav_mesh, nav_game_state, job->team, job->a);
+			result->flags = 0;
+			if (result->ref.equals(DRONE_NAV_MESH_NODE_NONE))
+			{
+				result->pos = job->a;
+				result->normal = Vec3(0, 1, 0);
+			}
+			else
+			{
+				result->pos = drone_nav_mesh.chunks[result->ref.chunk].vertices[result->ref.vertex];
+				result->normal = drone_nav_mesh.chunks[result->ref.chunk].normals[result->ref.vertex];
+			}
+			break;
+		}
+		case Op::AudioPathfind:
+		{
+			job->path_length = audio_pathfind(ctx_audio, job->a, job->b);
+			break;
+		}
+		default:
+		{
+			vi_assert(false);
+			break;
+		}
+	}
+}
+
+// called with the pool mutex held, in request order
+void job_write_result(const Job& job)
+{
+	sync_out.lock();
+	switch (job.op)
+	{
+		case Op::Pathfind:
+		case Op::RandomPath:
+		{
+			sync_out.write(Callback::Path);
+			sync_out.write(job.callback);
+			sync_out.write(job.path);
+			break;
+		}
+		case Op::ClosestWalkPoint:
+		{
+			sync_out.write(Callback::Point);
+			sync_out.write(job.callback);
+			sync_out.write(job.point);
+			break;
+		}
+		case Op::DronePathfind:
+		{
+			sync_out.write(Callback::DronePath);
+			sync_out.write(job.callback);
+			sync_out.write(job.drone_path);
+			break;
+		}
+		case Op::DroneClosestPoint:
+		{
+			sync_out.write(Callback::DronePoint);
+			sync_out.write(job.callback);
+			sync_out.write(job.drone_point);
+			break;
+		}
+		case Op::AudioPathfind:
+		{
+			sync_out.write(Callback::AudioPath);
+			sync_out.write(job.audio_entry);
+			sync_out.write(job.listener);
+			sync_out.write(job.path_length);
+			sync_out.write(job.value);
+			break;
+		}
+		default:
+		{
+			vi_assert(false);
+			break;
+		}
+	}
+	sync_out.unlock();
+}
+
+void worker_loop(WorkerState* state)
+{
+	nav_mesh_query = state->nav_mesh_query;
+
 	const DroneNavContext ctx =
 	{
 		drone_nav_mesh,
-		&drone_nav_mesh_key,
+		&state->drone_nav_mesh_key,
 		nav_game_state,
-		&astar_queue,
+		&state->astar_queue,
 		DroneNavFlagBias,
 	};
 	const DroneNavContext ctx_audio =
 	{
 		drone_nav_mesh,
-		&drone_nav_mesh_key,
+		&state->drone_nav_mesh_key,
 		nav_game_state_empty,
-		&astar_queue,
+		&state->astar_queue,
 		0,
 	};
 
+	std::unique_lock<std::mutex> lock(pool.mutex);
+	while (true)
+	{
+		while (!pool.quit && pool.job_claim == pool.job_write)
+			pool.job_available.wait(lock);
+
+		if (pool.quit)
+			break;
+
+		Job* job = &pool.jobs[pool.job_claim % AI_JOB_QUEUE_SIZE];
+		pool.job_claim++;
+
+		lock.unlock();
+		job_execute(ctx, ctx_audio, job);
+		lock.lock();
+
+		job->done = true;
+
+		// flush every finished job at the head of the queue, so callbacks go out in request order
+		while (pool.job_flush != pool.job_claim)
+		{
+			Job* head = &pool.jobs[pool.job_flush % AI_JOB_QUEUE_SIZE];
+			if (!head->done)
+				break;
+			job_write_result(*head);
+			head->done = false;
+			pool.job_flush++;
+		}
+
+		pool.job_finished.notify_all();
+	}
+}
+
+// block until every queued job has been executed and written to sync_out
+void pool_wait_idle()
+{
+	std::unique_lock<std::mutex> lock(pool.mutex);
+	while (pool.job_flush != pool.job_write)
+		pool.job_finished.wait(lock);
+}
+
+// block until there's room for at least one more job
+void pool_wait_slot()
+{
+	std::unique_lock<std::mutex> lock(pool.mutex);
+	while (pool.job_write - pool.job_flush >= AI_JOB_QUEUE_SIZE)
+		pool.job_finished.wait(lock);
+}
+
+s32 pool_worker_count()
+{
+	s32 count = Settings::ai_workers;
+	if (count == -1)
+	{
+		s32 cores = s32(std::thread::hardware_concurrency());
+#if SERVER
+		// leave room for the update and physics threads
+		count = cores - 2;
+#else
+		// clients also have render and audio work to do
+		count = cores / 4;
+#endif
+	}
+	return vi_max(1, vi_min(AI_MAX_WORKERS, count));
+}
+
+void loop()
+{
+	default_query_filter.setIncludeFlags(u16(-1));
+	default_query_filter.setExcludeFlags(0);
+
+	pool.worker_count = pool_worker_count();
+	std::thread threads[AI_MAX_WORKERS];
+	for (s32 i = 0; i < pool.worker_count; i++)
+	{
+		pool.workers[i].nav_mesh_query = dtAllocNavMeshQuery();
+		threads[i] = std::thread(worker_loop, &pool.workers[i]);
+	}
+
+	Revision level_revision = 0;
+
 	Array<u32> obstacle_recast_ids;
 
 	b8 run = true;
 	Op op;
 	while (run)
 	{
-		sync_in.lock_wait_read();
+		pool_wait_slot();
+
+		sync_in.wait_read();
 		sync_in.read(&op);
+		switch (op)
+		{
+			case Op::Pathfind:
+			case Op::RandomPath:
+			case Op::ClosestWalkPoint:
+			case Op::DronePathfind:
+			case Op::DroneClosestPoint:
+			case Op::AudioPathfind:
+			{
+				Job* job = &pool.jobs[pool.job_write % AI_JOB_QUEUE_SIZE]; // pool_wait_slot() guarantees this slot is free
+				job_read(op, job);
+				{
+					std::lock_guard<std::mutex> lock(pool.mutex);
+					pool.job_write++;
+				}
+				pool.job_available.notify_one();
+				break;
+			}
+			default:
+			{
+				// everything else touches data the workers read; wait for them to finish
+				pool_wait_idle();
+				break;
+			}
+		}
+
 		switch (op)
 		{
 			case Op::Load:
@@ -797,8 +1344,13 @@ void loop()
 					}
 					drone_nav_mesh.~DroneNavMesh();
 					new (&drone_nav_mesh) DroneNavMesh();
-					drone_nav_mesh_key.~DroneNavMeshKey();
-					new (&drone_nav_mesh_key) DroneNavMeshKey();
+					for (s32 i = 0; i < pool.worker_count; i++)
+					{
+						WorkerState* worker = &pool.workers[i];
+						worker->drone_nav_mesh_key.~DroneNavMeshKey();
+						new (&worker->drone_nav_mesh_key) DroneNavMeshKey();
+						worker->astar_queue.clear(); // nodes left over from the last query point into the old mesh
+					}
 
 					nav_game_state.clear();
 				}
@@ -816,9 +1368,12 @@ void loop()
 					sync_in.read(&path_length);
 					vi_assert(path_length <= MAX_PATH_LENGTH);
 					sync_in.read(path, path_length);
-					sync_in.unlock();
 					path[path_length] = '\0';
 
+#if RECORD_DRONE_PATHFIND
+					drone_pathfind_record_open(path, path_length);
+#endif
+
 					// unlock sync
 					{
 						level_revision++;
@@ -946,24 +1501,29 @@ void loop()
 							}
 						}
 
-						dtStatus status = nav_mesh_query->init(nav_mesh, 2048);
-						vi_assert(dtStatusSucceed(status));
+						for (s32 i = 0; i < pool.worker_count; i++)
+						{
+							dtStatus status = pool.workers[i].nav_mesh_query->init(nav_mesh, 2048);
+							vi_assert(dtStatusSucceed(status));
+						}
 					}
 
 					// drone nav mesh
 					drone_nav_mesh.read(f);
-					drone_nav_mesh_key.resize(drone_nav_mesh);
+					for (s32 i = 0; i < pool.worker_count; i++)
+						pool.workers[i].drone_nav_mesh_key.resize(drone_nav_mesh);
 				}
 
 				if (f)
 					fclose(f);
 
 				{
-					// reserve space in the A* queue
+					// reserve space in the A* queues
 					s32 vertex_count = 0;
 					for (s32 i = 0; i < drone_nav_mesh.chunks.length; i++)
 						vertex_count += drone_nav_mesh.chunks[i].adjacency.length;
-					astar_queue.reserve(vertex_count);
+					for (s32 i = 0; i < pool.worker_count; i++)
+						pool.workers[i].astar_queue.reserve(vertex_count);
 				}
 
 #if DEBUG_WALK || DEBUG_DRONE || DEBUG_AUDIO
@@ -982,7 +1542,6 @@ void loop()
 				sync_in.read(&radius);
 				r32 height;
 				sync_in.read(&height);
-				sync_in.unlock();
 
 				if (s32(id) > obstacle_recast_ids.length - 1)
 				{
@@ -1001,7 +1560,6 @@ void loop()
 			{
 				u32 id;
 				sync_in.read(&id);
-				sync_in.unlock();
 
 				if (nav_tile_cache)
 				{
@@ -1014,283 +1572,12 @@ void loop()
 				}
 				break;
 			}
-			case Op::Pathfind:
-			{
-#if DEBUG_WALK
-				r64 start_time = platform::time();
-				vi_debug("%s", "Walk pathfind...");
-#endif
-
-				AI::Team team;
-				Vec3 a;
-				Vec3 b;
-				LinkEntryArg<Path> callback;
-				sync_in.read(&team);
-				sync_in.read(&a);
-				sync_in.read(&b);
-				sync_in.read(&callback);
-				sync_in.unlock();
-
-				dtPolyRef start_poly = get_poly(a, default_search_extents);
-
-				dtPolyRef end_poly = get_poly(b, default_search_extents);
-
-				Path path;
-
-				if (start_poly && end_poly)
-					pathfind(nav_game_state, team, a, b, start_poly, end_poly, &path);
-				
-				sync_out.lock();
-				sync_out.write(Callback::Path);
-				sync_out.write(callback);
-				sync_out.write(path);
-				sync_out.unlock();
-
-#if DEBUG_WALK
-				vi_debug("%d nodes in %fs", path.length, r32(platform::time() - start_time));
-#endif
-
-				break;
-			}
-			case Op::RandomPath:
-			{
-#if DEBUG_WALK
-				r64 start_time = platform::time();
-				vi_debug("%s", "Walk random path...");
-#endif
-				Vec3 start;
-				sync_in.read(&start);
-				Vec3 patrol_point;
-				sync_in.read(&patrol_point);
-				AI::Team team;
-				sync_in.read(&team);
-				r32 range;
-				sync_in.read(&range);
-				LinkEntryArg<Path> callback;
-				sync_in.read(&callback);
-				sync_in.unlock();
-
-				dtPolyRef start_poly = get_poly(start, default_search_extents);
-				dtPolyRef patrol_point_poly = get_poly(patrol_point, default_search_extents);
-
-				u32 hash_start = force_field_hash(nav_game_state, team, start);
-
-				Vec3 end;
-				dtPolyRef end_poly;
-				b8 valid = false;
-				{
-					s32 tries = 0;
-					do
-					{
-						nav_mesh_query->findRandomPointAroundCircle(patrol_point_poly, (r32*)(&patrol_point), range * (0.75f + mersenne::randf_co() * 0.5f), &default_query_filter, mersenne::randf_co, &end_poly, (r32*)(&end));
-						valid = force_field_hash(nav_game_state, team, end) == hash_start;
-						tries++;
-					} while (!valid && tries < 20);
-				}
-
-				Path path;
-
-				if (start_poly && end_poly && valid)
-					pathfind(nav_game_state, team, start, end, start_poly, end_poly, &path);
-
-				sync_out.lock();
-				sync_out.write(Callback::Path);
-				sync_out.write(callback);
-				sync_out.write(path);
-				sync_out.unlock();
-
-#if DEBUG_WALK
-				vi_debug("%d nodes in %fs", path.length, r32(platform::time() - start_time));
-#endif
-
-				break;
-			}
-			case Op::ClosestWalkPoint:
-			{
-#if DEBUG_WALK
-				r64 start_time = platform::time();
-				vi_debug("%s", "Walkable point query...");
-#endif
-				LinkEntryArg<Path> callback;
-				Vec3 pos;
-				sync_in.read(&pos);
-				sync_in.read(&callback);
-				sync_in.unlock();
-
-				dtPolyRef poly = get_poly(pos, default_search_extents);
-				Vec3 closest;
-				nav_mesh_query->closestPointOnPoly(poly, (r32*)(&pos), (r32*)(&closest), 0);
-
-				sync_out.lock();
-				sync_out.write(Callback::Point);
-				sync_out.write(callback);
-				sync_out.write(closest);
-				sync_out.unlock();
-
-#if DEBUG_WALK
-				vi_debug("Done in %fs", r32(platform::time() - start_time));
-#endif
-				break;
-			}
-			case Op::DronePathfind:
-			{
-				DronePathfind type;
-				DroneAllow rule;
-				Team team;
-				Vec3 start;
-				Vec3 start_normal;
-				sync_in.read(&type);
-				sync_in.read(&rule);
-				sync_in.read(&team);
-				LinkEntryArg<DronePath> callback;
-				sync_in.read(&callback);
-				sync_in.read(&start);
-				sync_in.read(&start_normal);
-
-				DronePath path;
-
-				switch (type)
-				{
-					case DronePathfind::LongRange:
-					{
-						Vec3 end;
-						sync_in.read(&end);
-						Vec3 end_normal;
-						sync_in.read(&end_normal);
-						sync_in.unlock();
-						drone_pathfind
-						(
-							ctx,
-							rule,
-							team,
-							drone_closest_point(drone_nav_mesh, nav_game_state, team, start, start_normal),
-							drone_closest_point(drone_nav_mesh, nav_game_state, team, end, end_normal),
-							&path
-						);
-						break;
-					}
-					case DronePathfind::Target:
-					{
-						Vec3 end;
-						sync_in.read(&end);
-						sync_in.unlock();
-						drone_pathfind_hit(ctx, rule, team, start, start_normal, end, &path);
-						break;
-					}
-					case DronePathfind::Spawn:
-					{
-						Vec3 dir;
-						sync_in.read(&dir);
-						sync_in.unlock();
-
-						SpawnScorer scorer;
-						scorer.mesh = &drone_nav_mesh;
-						scorer.dir = dir;
-						scorer.start_pos = start;
-						scorer.start_vertex = drone_closest_point(drone_nav_mesh, nav_game_state, team, start, start_normal);
-
-						drone_astar(ctx, rule, team, scorer.start_vertex, &scorer, &path);
-						
-						break;
-					}
-					case DronePathfind::Random:
-					{
-						sync_in.unlock();
-
-						RandomScorer scorer;
-						scorer.mesh = &drone_nav_mesh;
-						scorer.start_vertex = drone_closest_point(drone_nav_mesh, nav_game_state, team, start, start_normal);
-						scorer.start_pos = start;
-						scorer.minimum_distance = rule == DroneAllow::Crawl ? DRONE_MAX_DISTANCE * 0.5f : DRONE_MAX_DISTANCE * 3.0f;
-						scorer.minimum_distance = vi_min(scorer.minimum_distance,
-							vi_min(drone_nav_mesh.size.x, drone_nav_mesh.size.z) * drone_nav_mesh.chunk_size * 0.5f);
-						scorer.goal = drone_nav_mesh.vmin +
-						Vec3
-						(
-							mersenne::randf_co() * (drone_nav_mesh.size.x * drone_nav_mesh.chunk_size),
-							mersenne::randf_co() * (drone_nav_mesh.size.y * drone_nav_mesh.chunk_size),
-							mersenne::randf_co() * (drone_nav_mesh.size.z * drone_nav_mesh.chunk_size)
-						);
-
-						drone_astar(ctx, rule, team, scorer.start_vertex, &scorer, &path);
-
-						break;
-					}
-					case DronePathfind::Away:
-					{
-						Vec3 away;
-						sync_in.read(&away);
-						Vec3 away_normal;
-						sync_in.read(&away_normal);
-						sync_in.unlock();
-
-						AwayScorer scorer;
-						scorer.mesh = &drone_nav_mesh;
-						scorer.start_vertex = drone_closest_point(drone_nav_mesh, nav_game_state, team, start, start_normal);
-						scorer.away_vertex = drone_closest_point(drone_nav_mesh, nav_game_state, team, away, away_normal);
-						if (!scorer.away_vertex.equals(DRONE_NAV_MESH_NODE_NONE))
-						{
-							scorer.away_pos = away;
-							scorer.minimum_distance = rule == DroneAllow::Crawl ? DRONE_MAX_DISTANCE * 0.5f : DRONE_MAX_DISTANCE * 3.0f;
-							scorer.minimum_distance = vi_min(scorer.minimum_distance,
-								vi_min(drone_nav_mesh.size.x, drone_nav_mesh.size.z) * drone_nav_mesh.chunk_size * 0.5f);
-
-							drone_astar(ctx, rule, team, scorer.start_vertex, &scorer, &path);
-						}
-
-						break;
-					}
-					default:
-					{
-						vi_assert(false);
-						break;
-					}
-				}
-
-				sync_out.lock();
-				sync_out.write(Callback::DronePath);
-				sync_out.write(callback);
-				sync_out.write(path);
-				sync_out.unlock();
-				break;
-			}
-			case Op::DroneClosestPoint:
-			{
-				LinkEntryArg<DronePathNode> callback;
-				sync_in.read(&callback);
-				AI::Team team;
-				sync_in.read(&team);
-				Vec3 search_pos;
-				sync_in.read(&search_pos);
-				sync_in.unlock();
-
-				DronePathNode result;
-				result.ref = drone_closest_point(drone_nav_mesh, nav_game_state, team, search_pos);
-				if (result.ref.equals(DRONE_NAV_MESH_NODE_NONE))
-				{
-					result.pos = search_pos;
-					result.normal = Vec3(0, 1, 0);
-				}
-				else
-				{
-					result.pos = drone_nav_mesh.chunks[result.ref.chunk].vertices[result.ref.vertex];
-					result.normal = drone_nav_mesh.chunks[result.ref.chunk].normals[result.ref.vertex];
-				}
-
-				sync_out.lock();
-				sync_out.write(Callback::DronePoint);
-				sync_out.write(callback);
-				sync_out.write(result);
-				sync_out.unlock();
-				break;
-			}
 			case Op::DroneMarkAdjacencyBad:
 			{
 				DroneNavMeshNode a;
 				sync_in.read(&a);
 				DroneNavMeshNode b;
 				sync_in.read(&b);
-				sync_in.unlock();
 
 				// remove b from a's adjacency list
 				DroneNavMeshAdjacency* adjacency = &drone_nav_mesh.chunks[a.chunk].adjacency[a.vertex];
@@ -1314,40 +1601,23 @@ void loop()
 				sync_in.read(&count);
 				nav_game_state.force_fields.resize(count);
 				sync_in.read(nav_game_state.force_fields.data, nav_game_state.force_fields.length);
-				sync_in.unlock();
-				break;
-			}
-			case Op::AudioPathfind:
-			{
-				Ref<AudioEntry> entry;
-				s8 listener;
-				Vec3 a;
-				Vec3 b;
-				r32 straight_distance;
-				sync_in.read(&entry);
-				sync_in.read(&listener);
-				sync_in.read(&a);
-				sync_in.read(&b);
-				sync_in.read(&straight_distance);
-				sync_in.unlock();
-
-				r32 path_length = audio_pathfind(ctx_audio, a, b);
-
-				sync_out.lock();
-				sync_out.write(Callback::AudioPath);
-				sync_out.write(entry);
-				sync_out.write(listener);
-				sync_out.write(path_length);
-				sync_out.write(straight_distance);
-				sync_out.unlock();
 				break;
 			}
 			case Op::Quit:
 			{
-				sync_in.unlock();
+#if RECORD_DRONE_PATHFIND
+				drone_pathfind_record_open(nullptr, 0); // flush and close
+#endif
 				run = false;
 				break;
 			}
+			case Op::Pathfind:
+			case Op::RandomPath:
+			case Op::ClosestWalkPoint:
+			case Op::DronePathfind:
+			case Op::DroneClosestPoint:
+			case Op::AudioPathfind:
+				break; // already handed off to the pool
 			default:
 				vi_assert(false);
 				break;
@@ -1356,10 +1626,27 @@ void loop()
 		vi_debug("AI work queue usage: %.0f%%", 100.0f * (r32(sync_in.length()) / r32(sync_in.capacity())));
 #endif
 	}
+
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		pool.quit = true;
+	}
+	pool.job_available.notify_all();
+	for (s32 i = 0; i < pool.worker_count; i++)
+	{
+		threads[i].join();
+		dtFreeNavMeshQuery(pool.workers[i].nav_mesh_query);
+		pool.workers[i].nav_mesh_query = nullptr;
+	}
 }
 
 // Drone nav mesh stuff
 
+DroneNavMeshKey::DroneNavMeshKey()
+	: data(), generation()
+{
+}
+
 void DroneNavMeshKey::resize(const DroneNavMesh& nav)
 {
 	data.chunk_size = nav.chunk_size;
@@ -1372,10 +1659,17 @@ void DroneNavMeshKey::resize(const DroneNavMesh& nav)
 		data.chunks[i].resize(nav.chunks[i].vertices.length);
 }
 
+// O(1) in the common case; node data is lazily cleared in get() the first time a query touches it
 void DroneNavMeshKey::reset()
 {
-	for (s32 i = 0; i < data.chunks.length; i++)
-		memset(data.chunks[i].data, 0, sizeof(DroneNavMeshNodeData) * data.chunks[i].length);
+	generation++;
+	if (generation == 0)
+	{
+		// wrapped around; stale stamps could now collide with the current generation
+		for (s32 i = 0; i < data.chunks.length; i++)
+			memset(data.chunks[i].data, 0, sizeof(DroneNavMeshNodeData) * data.chunks[i].length);
+		generation = 1;
+	}
 }
 
 r32 DroneNavMeshKey::priority(const DroneNavMeshNode& a)
@@ -1384,9 +1678,20 @@ r32 DroneNavMeshKey::priority(const DroneNavMeshNode& a)
 	return data.travel_score + data.estimate_score;
 }
 
+void DroneNavMeshKey::heap_index(const DroneNavMeshNode& a, s32 index)
+{
+	get(a).heap_index = index;
+}
+
 DroneNavMeshNodeData& DroneNavMeshKey::get(const DroneNavMeshNode& node)
 {
-	return data.chunks[node.chunk][node.vertex];
+	DroneNavMeshNodeData& result = data.chunks[node.chunk][node.vertex];
+	if (result.generation != generation)
+	{
+		memset(&result, 0, sizeof(result));
+		result.generation = generation;
+	}
+	return result;
 }
 
 
@@ -8,73 +8,74 @@ namespace Asset
 {
 	namespace Uniform
 	{
-		const s32 count = 62;
+		const s32 count = 63;
 		const AssetID ambient_color = 0;
-		const AssetID bones = 1;
-		const AssetID buffer_size = 2;
-		const AssetID camera_light_radius = 3;
-		const AssetID camera_light_strength = 4;
-		const AssetID cloud_alpha = 5;
-		const AssetID cloud_height_diff_scaled = 6;
-		const AssetID cloud_inv_uv_scale = 7;
-		const AssetID cloud_map = 8;
-		const AssetID cloud_uv_offset = 9;
-		const AssetID color_buffer = 10;
-		const AssetID cull_behind_wall = 11;
-		const AssetID cull_center = 12;
-		const AssetID cull_radius = 13;
-		const AssetID depth_buffer = 14;
-		const AssetID detail2_light_vp = 15;
-		const AssetID detail2_shadow_map = 16;
-		const AssetID detail_light_vp = 17;
-		const AssetID detail_shadow_map = 18;
-		const AssetID diffuse_color = 19;
-		const AssetID diffuse_map = 20;
-		const AssetID displacement = 21;
-		const AssetID fade_in = 22;
-		const AssetID far_plane = 23;
-		const AssetID fog = 24;
-		const AssetID fog_extent = 25;
-		const AssetID fog_start = 26;
-		const AssetID frontface = 27;
-		const AssetID frustum = 28;
-		const AssetID gravity = 29;
-		const AssetID inv_buffer_size = 30;
-		const AssetID inv_uv_scale = 31;
-		const AssetID lifetime = 32;
-		const AssetID light_color = 33;
-		const AssetID light_direction = 34;
-		const AssetID light_fov_dot = 35;
-		const AssetID light_pos = 36;
-		const AssetID light_radius = 37;
-		const AssetID light_vp = 38;
-		const AssetID lighting_buffer = 39;
-		const AssetID mv = 40;
-		const AssetID mvp = 41;
-		const AssetID noise_sampler = 42;
-		const AssetID normal_buffer = 43;
-		const AssetID normal_map = 44;
-		const AssetID p = 45;
-		const AssetID radius = 46;
-		const AssetID range = 47;
-		const AssetID range_center = 48;
-		const AssetID scan_line_interval = 49;
-		const AssetID shadow_map = 50;
-		const AssetID size = 51;
-		const AssetID ssao_buffer = 52;
-		const AssetID time = 53;
-		const AssetID tri_shadow_cascade = 54;
-		const AssetID type = 55;
-		const AssetID uv_offset = 56;
-		const AssetID uv_scale = 57;
-		const AssetID v = 58;
-		const AssetID viewport_scale = 59;
-		const AssetID vp = 60;
-		const AssetID wall_normal = 61;
+		const AssetID bone_buffer = 1;
+		const AssetID bone_offset = 2;
+		const AssetID buffer_size = 3;
+		const AssetID camera_light_radius = 4;
+		const AssetID camera_light_strength = 5;
+		const AssetID cloud_alpha = 6;
+		const AssetID cloud_height_diff_scaled = 7;
+		const AssetID cloud_inv_uv_scale = 8;
+		const AssetID cloud_map = 9;
+		const AssetID cloud_uv_offset = 10;
+		const AssetID color_buffer = 11;
+		const AssetID cull_behind_wall = 12;
+		const AssetID cull_center = 13;
+		const AssetID cull_radius = 14;
+		const AssetID depth_buffer = 15;
+		const AssetID detail2_light_vp = 16;
+		const AssetID detail2_shadow_map = 17;
+		const AssetID detail_light_vp = 18;
+		const AssetID detail_shadow_map = 19;
+		const AssetID diffuse_color = 20;
+		const AssetID diffuse_map = 21;
+		const AssetID displacement = 22;
+		const AssetID fade_in = 23;
+		const AssetID far_plane = 24;
+		const AssetID fog = 25;
+		const AssetID fog_extent = 26;
+		const AssetID fog_start = 27;
+		const AssetID frontface = 28;
+		const AssetID frustum = 29;
+		const AssetID gravity = 30;
+		const AssetID inv_buffer_size = 31;
+		const AssetID inv_uv_scale = 32;
+		const AssetID lifetime = 33;
+		const AssetID light_color = 34;
+		const AssetID light_direction = 35;
+		const AssetID light_fov_dot = 36;
+		const AssetID light_pos = 37;
+		const AssetID light_radius = 38;
+		const AssetID light_vp = 39;
+		const AssetID lighting_buffer = 40;
+		const AssetID mv = 41;
+		const AssetID mvp = 42;
+		const AssetID noise_sampler = 43;
+		const AssetID normal_buffer = 44;
+		const AssetID normal_map = 45;
+		const AssetID p = 46;
+		const AssetID radius = 47;
+		const AssetID range = 48;
+		const AssetID range_center = 49;
+		const AssetID scan_line_interval = 50;
+		const AssetID shadow_map = 51;
+		const AssetID size = 52;
+		const AssetID ssao_buffer = 53;
+		const AssetID time = 54;
+		const AssetID tri_shadow_cascade = 55;
+		const AssetID type = 56;
+		const AssetID uv_offset = 57;
+		const AssetID uv_scale = 58;
+		const AssetID v = 59;
+		const AssetID viewport_scale = 60;
+		const AssetID vp = 61;
+		const AssetID wall_normal = 62;
 	}
 	namespace Shader
 	{
-		const s32 count = 39;
+		const s32 count = 40;
 		const AssetID armature = 0;
 		const AssetID blit = 1;
 		const AssetID bloom_downsample = 2;
@@ -82,38 +83,39 @@ namespace Asset
 		const AssetID clouds = 4;
 		const AssetID composite = 5;
 		const AssetID culled = 6;
-		const AssetID debug_depth = 7;
-		const AssetID downsample = 8;
-		const AssetID flat = 9;
-		const AssetID flat_instanced = 10;
-		const AssetID flat_texture = 11;
-		const AssetID flat_texture_offset = 12;
-		const AssetID fresnel = 13;
-		const AssetID global_light = 14;
-		const AssetID nav_dots = 15;
-		const AssetID particle_alpha = 16;
-		const AssetID particle_eased = 17;
-		const AssetID particle_limited_size = 18;
-		const AssetID particle_rain = 19;
-		const AssetID particle_spark = 20;
-		const AssetID particle_standard = 21;
-		const AssetID particle_textured = 22;
-		const AssetID point_light = 23;
-		const AssetID scan_lines = 24;
-		const AssetID sky_decal = 25;
-		const AssetID skybox = 26;
-		const AssetID spot_light = 27;
-		const AssetID ssao = 28;
-		const AssetID ssao_blur = 29;
-		const AssetID ssao_downsample = 30;
-		const AssetID standard = 31;
-		const AssetID standard_flat = 32;
-		const AssetID standard_instanced = 33;
-		const AssetID stencil_back_faces = 34;
-		const AssetID ui = 35;
-		const AssetID ui_texture = 36;
-		const AssetID underwater = 37;
-		const AssetID water = 38;
+		const AssetID culled_instanced = 7;
+		const AssetID debug_depth = 8;
+		const AssetID downsample = 9;
+		const AssetID flat = 10;
+		const AssetID flat_instanced = 11;
+		const AssetID flat_texture = 12;
+		const AssetID flat_texture_offset = 13;
+		const AssetID fresnel = 14;
+		const AssetID global_light = 15;
+		const AssetID nav_dots = 16;
+		const AssetID particle_alpha = 17;
+		const AssetID particle_eased = 18;
+		const AssetID particle_limited_size = 19;
+		const AssetID particle_rain = 20;
+		const AssetID particle_spark = 21;
+		const AssetID particle_standard = 22;
+		const AssetID particle_textured = 23;
+		const AssetID point_light = 24;
+		const AssetID scan_lines = 25;
+		const AssetID sky_decal = 26;
+		const AssetID skybox = 27;
+		const AssetID spot_light = 28;
+		const AssetID ssao = 29;
+		const AssetID ssao_blur = 30;
+		const AssetID ssao_downsample = 31;
+		const AssetID standard = 32;
+		const AssetID standard_flat = 33;
+		const AssetID standard_instanced = 34;
+		const AssetID stencil_back_faces = 35;
+		const AssetID ui = 36;
+		const AssetID ui_texture = 37;
+		const AssetID underwater = 38;
+		const AssetID water = 39;
 	}
 }
 
@@ -927,6 +927,7 @@ const char* AssetLookup::Shader::values[] =
 	"assets/shader/clouds.glsl",
 	"assets/shader/composite.glsl",
 	"assets/shader/culled.glsl",
+	"assets/shader/culled_instanced.glsl",
 	"assets/shader/debug_depth.glsl",
 	"assets/shader/downsample.glsl",
 	"assets/shader/flat.glsl",
@@ -972,6 +973,7 @@ const char* AssetLookup::Shader::names[] =
 	"clouds",
 	"composite",
 	"culled",
+	"culled_instanced",
 	"debug_depth",
 	"downsample",
 	"flat",
@@ -1011,7 +1013,8 @@ const char* AssetLookup::Shader::names[] =
 const char* AssetLookup::Uniform::names[] =
 {
 	"ambient_color",
-	"bones",
+	"bone_buffer",
+	"bone_offset",
 	"buffer_size",
 	"camera_light_radius",
 	"camera_light_strength",
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "types.h"
+#include "vi_assert.h"
+#include "lmath.h"
+#include "data/array.h"
+#include "data/pin_array.h"
+#include "game/constants.h"
+
+// times a full forward and backward walk over a MAX_ENTITIES Bitmask at several fill rates,
+// with the old bit-at-a-time next()/prev(), the current word-at-a-time ones, and indices().
+// every walk sums the indices it visits; the sums have to match.
+
+namespace VI
+{
+
+#define BENCH_MASK_COUNT 16
+
+typedef Bitmask<MAX_ENTITIES> BenchMask;
+
+BenchMask masks[BENCH_MASK_COUNT];
+
+u32 bench_random_state = 1;
+
+// deterministic, so runs are comparable
+u32 bench_rand()
+{
+	bench_random_state = bench_random_state * 1664525u + 1013904223u;
+	return bench_random_state >> 8;
+}
+
+r64 bench_time()
+{
+	return r64(std::chrono::high_resolution_clock::now().time_since_epoch().count()) / 1000000000.0;
+}
+
+// Bitmask::next() and prev() as they were before they skipped whole words
+s32 bench_next_bitwise(const BenchMask& mask, s32 i)
+{
+	i++;
+	while (i < mask.end)
+	{
+		if (mask.get(i))
+			break;
+		i++;
+	}
+	return i;
+}
+
+s32 bench_prev_bitwise(const BenchMask& mask, s32 i)
+{
+	i--;
+	while (i >= mask.start)
+	{
+		if (mask.get(i))
+			break;
+		i--;
+	}
+	return i;
+}
+
+s64 bench_walk_bitwise(const BenchMask& mask)
+{
+	s64 sum = 0;
+	for (s32 i = mask.start; i < mask.end; i = bench_next_bitwise(mask, i))
+		sum += i;
+	for (s32 i = mask.end - 1; i >= mask.start; i = bench_prev_bitwise(mask, i))
+		sum += i;
+	return sum;
+}
+
+s64 bench_walk_words(const BenchMask& mask)
+{
+	s64 sum = 0;
+	for (s32 i = mask.start; i < mask.end; i = mask.next(i))
+		sum += i;
+	for (s32 i = mask.end - 1; i >= mask.start; i = mask.prev(i))
+		sum += i;
+	return sum;
+}
+
+s64 bench_walk_indices(const BenchMask& mask, ID* scratch)
+{
+	s64 sum = 0;
+	s32 count = mask.indices(scratch);
+	for (s32 i = 0; i < count; i++)
+		sum += scratch[i];
+	for (s32 i = count - 1; i >= 0; i--)
+		sum += scratch[i];
+	return sum;
+}
+
+s32 usage()
+{
+	fprintf(stderr, "%s", "Usage: bitmask_bench [iterations]\n");
+	return 1;
+}
+
+s32 proc(s32 argc, char* argv[])
+{
+	s32 iterations = 20000;
+	if (argc > 2)
+		return usage();
+	if (argc > 1)
+		iterations = atoi(argv[1]);
+	if (iterations <= 0)
+		return usage();
+
+	// one in n slots set. the sparse cases look like a match with a handful of players and bolts
+	// spread over a pool that has churned through its whole range
+	const s32 one_in[] = { 256, 64, 8, 2, 1 };
+	Array<ID> scratch(MAX_ENTITIES, MAX_ENTITIES);
+
+	for (s32 d = 0; d < s32(sizeof(one_in) / sizeof(one_in[0])); d++)
+	{
+		// a few different masks per density so the walks can't be hoisted out of the timing loops
+		s32 set_count = 0;
+		for (s32 m = 0; m < BENCH_MASK_COUNT; m++)
+		{
+			BenchMask* mask = &masks[m];
+			mask->clear();
+			if (one_in[d] == 1)
+			{
+				for (s32 i = 0; i < MAX_ENTITIES; i++)
+					mask->set(i, true);
+			}
+			else
+			{
+				// keep both ends set so every density walks the full range
+				mask->set(0, true);
+				mask->set(MAX_ENTITIES - 1, true);
+				for (s32 i = 1; i < MAX_ENTITIES - 1; i++)
+				{
+					if (bench_rand() % one_in[d] == 0)
+						mask->set(i, true);
+				}
+			}
+			set_count += mask->count();
+		}
+
+		s64 sum_bitwise = 0;
+		s64 sum_words = 0;
+		s64 sum_indices = 0;
+
+		r64 start = bench_time();
+		for (s32 i = 0; i < iterations; i++)
+			sum_bitwise += bench_walk_bitwise(masks[i % BENCH_MASK_COUNT]);
+		r64 time_bitwise = bench_time() - start;
+
+		start = bench_time();
+		for (s32 i = 0; i < iterations; i++)
+			sum_words += bench_walk_words(masks[i % BENCH_MASK_COUNT]);
+		r64 time_words = bench_time() - start;
+
+		start = bench_time();
+		for (s32 i = 0; i < iterations; i++)
+			sum_indices += bench_walk_indices(masks[i % BENCH_MASK_COUNT], scratch.data);
+		r64 time_indices = bench_time() - start;
+
+		if (sum_bitwise != sum_words || sum_bitwise != sum_indices)
+		{
+			fprintf(stderr, "Error: walks disagree at 1 in %d\n", one_in[d]);
+			return 1;
+		}
+
+		r64 per_walk = 1000000.0 / r64(iterations);
+		printf("%4d of %d set: bit-at-a-time %.3fus | word-at-a-time %.3fus | indices() %.3fus per walk\n",
+			set_count / BENCH_MASK_COUNT, MAX_ENTITIES, time_bitwise * per_walk, time_words * per_walk, time_indices * per_walk);
+	}
+
+	return 0;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	return VI::proc(argc, argv);
+}
@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "types.h"
+#include "vi_assert.h"
+#include "lmath.h"
+#include "data/array.h"
+#include "data/pin_array.h"
+#include "game/constants.h"
+
+// times how long the server takes to find the transforms that changed between a state frame and the client's
+// acked base frame, the first step of serialize_state_frame. compares the per-index version (union the active
+// masks, expand, look each transform up in both frames and compare) against state_frame_changed_transforms,
+// which walks both packed arrays in lockstep. both have to produce the same list.
+// the frame history is simulated: a pool of transforms where some move, some turn, some sit still,
+// and a few despawn and respawn in new slots every tick, at the server's tick rate.
+
+namespace VI
+{
+
+#define BENCH_HISTORY 64
+#define BENCH_TICK (1.0f / 60.0f)
+
+enum class BenchResolution : s8
+{
+	Low,
+	Medium,
+	High,
+	count,
+};
+
+struct BenchParent
+{
+	ID id;
+	Revision revision;
+
+	inline b8 equals(const BenchParent& other) const
+	{
+		return id == other.id && revision == other.revision;
+	}
+};
+
+// same layout as Net::TransformState
+struct BenchTransformState
+{
+	Quat rot;
+	Vec3 pos;
+	Vec3 target_local_offset;
+	Vec3 target_velocity;
+	BenchParent parent;
+	Revision revision;
+	BenchResolution resolution;
+};
+
+// the transform half of Net::StateFrame
+struct BenchFrame
+{
+	Array<BenchTransformState> transforms;
+	Bitmask<MAX_ENTITIES> transforms_active;
+	s16 transforms_word_offset[(MAX_ENTITIES + 31) / 32];
+
+	inline const BenchTransformState* transform(s32 index) const
+	{
+		if (!transforms_active.get(index))
+			return nullptr;
+		s32 word = index / 32;
+		u32 below = transforms_active.data[word] & ((1u << (index - word * 32)) - 1);
+		return &transforms[transforms_word_offset[word] + BitUtility::popcount(below)];
+	}
+
+	BenchTransformState* transform_add(s32 index)
+	{
+		vi_assert(index >= transforms_active.end);
+		s32 word = index / 32;
+		if (transforms.length == 0 || word != (transforms_active.end - 1) / 32)
+			transforms_word_offset[word] = s16(transforms.length);
+		transforms_active.set(index, true);
+		BenchTransformState* transform = transforms.add();
+		memset(transform, 0, sizeof(*transform));
+		return transform;
+	}
+
+	void clear()
+	{
+		transforms.length = 0;
+		transforms_active.clear();
+	}
+};
+
+struct BenchObject
+{
+	Quat rot;
+	Vec3 pos;
+	Vec3 velocity;
+	r32 spin;
+	BenchParent parent;
+	Revision revision;
+	BenchResolution resolution;
+	b8 active;
+};
+
+BenchObject objects[MAX_ENTITIES];
+BenchFrame frames[BENCH_HISTORY];
+
+u32 bench_random_state = 1;
+
+// deterministic, so runs are comparable
+r32 bench_randf()
+{
+	bench_random_state = bench_random_state * 1664525u + 1013904223u;
+	return r32(bench_random_state >> 8) * (1.0f / 16777216.0f);
+}
+
+r64 bench_time()
+{
+	return r64(std::chrono::high_resolution_clock::now().time_since_epoch().count()) / 1000000000.0;
+}
+
+b8 equal_states_quat(const BenchTransformState& a, const BenchTransformState& b)
+{
+	r32 tolerance_rot = 0.002f;
+	if (a.resolution == BenchResolution::Medium || b.resolution == BenchResolution::Medium)
+		tolerance_rot = 0.001f;
+	if (a.resolution == BenchResolution::High || b.resolution == BenchResolution::High)
+		tolerance_rot = 0.0001f;
+	return Quat::angle(a.rot, b.rot) < tolerance_rot;
+}
+
+r32 bench_tolerance_pos(const BenchTransformState& a, const BenchTransformState& b)
+{
+	r32 tolerance_pos = 0.008f;
+	if (a.resolution == BenchResolution::Medium || b.resolution == BenchResolution::Medium)
+		tolerance_pos = 0.002f;
+	if (a.resolution == BenchResolution::High || b.resolution == BenchResolution::High)
+		tolerance_pos = 0.001f;
+	return tolerance_pos;
+}
+
+// equal_states_transform before it moved the quaternion test last
+b8 equal_states_transform_rot_first(const BenchTransformState& a, const BenchTransformState& b)
+{
+	r32 tolerance_pos = bench_tolerance_pos(a, b);
+	if (a.revision == b.revision
+		&& a.resolution == b.resolution
+		&& a.parent.equals(b.parent)
+		&& equal_states_quat(a, b))
+	{
+		return s32(a.pos.x / tolerance_pos) == s32(b.pos.x / tolerance_pos)
+			&& s32(a.pos.y / tolerance_pos) == s32(b.pos.y / tolerance_pos)
+			&& s32(a.pos.z / tolerance_pos) == s32(b.pos.z / tolerance_pos);
+	}
+	return false;
+}
+
+// same as net.cpp
+b8 equal_states_transform(const BenchTransformState& a, const BenchTransformState& b)
+{
+	r32 tolerance_pos = bench_tolerance_pos(a, b);
+	return a.revision == b.revision
+		&& a.resolution == b.resolution
+		&& a.parent.equals(b.parent)
+		&& s32(a.pos.x / tolerance_pos) == s32(b.pos.x / tolerance_pos)
+		&& s32(a.pos.y / tolerance_pos) == s32(b.pos.y / tolerance_pos)
+		&& s32(a.pos.z / tolerance_pos) == s32(b.pos.z / tolerance_pos)
+		&& equal_states_quat(a, b);
+}
+
+// the per-index version serialize_state_frame used before state_frame_changed_transforms
+s32 bench_changed_per_index(const BenchFrame& frame, const BenchFrame& base, ID* changed)
+{
+	Bitmask<MAX_ENTITIES> candidates = frame.transforms_active;
+	candidates.add(base.transforms_active);
+	s32 candidate_count = candidates.indices(changed);
+	s32 changed_count = 0;
+	for (s32 i = 0; i < candidate_count; i++)
+	{
+		const BenchTransformState* a = frame.transform(changed[i]);
+		const BenchTransformState* b = base.transform(changed[i]);
+		if (!a || !b || !equal_states_transform_rot_first(*a, *b))
+		{
+			changed[changed_count] = changed[i];
+			changed_count++;
+		}
+	}
+	return changed_count;
+}
+
+// same as state_frame_changed_transforms in net.cpp, with a base
+s32 bench_changed_lockstep(const BenchFrame& frame, const BenchFrame& base, ID* changed)
+{
+	Bitmask<MAX_ENTITIES> changed_mask;
+	s32 start = vi_min(s32(frame.transforms_active.start), s32(base.transforms_active.start));
+	s32 end = vi_max(s32(frame.transforms_active.end), s32(base.transforms_active.end));
+	if (start < end)
+	{
+		s32 frame_packed = 0;
+		s32 base_packed = 0;
+		for (s32 word = start / 32; word < ((end - 1) / 32) + 1; word++)
+		{
+			u32 a = frame.transforms_active.data[word];
+			u32 b = base.transforms_active.data[word];
+			u32 bits = a | b;
+			while (bits)
+			{
+				u32 bit = bits & (0 - bits); // lowest set bit
+				if (!(a & bit) || !(b & bit) || !equal_states_transform(frame.transforms[frame_packed], base.transforms[base_packed]))
+					changed_mask.set(word * 32 + BitUtility::ctz(bit), true);
+				if (a & bit)
+					frame_packed++;
+				if (b & bit)
+					base_packed++;
+				bits &= bits - 1;
+			}
+		}
+	}
+	return changed_mask.indices(changed);
+}
+
+void bench_spawn(s32 index)
+{
+	BenchObject* o = &objects[index];
+	o->active = true;
+	o->revision++;
+	o->pos = Vec3((bench_randf() - 0.5f) * 120.0f, bench_randf() * 30.0f, (bench_randf() - 0.5f) * 120.0f);
+	o->rot = Quat::euler(0.0f, bench_randf() * PI * 2.0f, 0.0f);
+	r32 kind = bench_randf();
+	if (kind < 0.3f) // walking or flying
+		o->velocity = Vec3(bench_randf() - 0.5f, (bench_randf() - 0.5f) * 0.1f, bench_randf() - 0.5f) * 8.0f;
+	else
+		o->velocity = Vec3(0, 0, 0);
+	o->spin = kind > 0.2f && kind < 0.4f ? (bench_randf() - 0.5f) * 4.0f : 0.0f;
+	o->resolution = BenchResolution(s32(bench_randf() * r32(BenchResolution::count)) % s32(BenchResolution::count));
+	o->parent.id = kind > 0.9f ? ID(bench_randf() * r32(MAX_ENTITIES)) : IDNull;
+	o->parent.revision = 0;
+}
+
+s32 bench_free_slot()
+{
+	while (true)
+	{
+		s32 index = s32(bench_randf() * r32(MAX_ENTITIES)) % MAX_ENTITIES;
+		if (!objects[index].active)
+			return index;
+	}
+}
+
+void bench_tick(BenchFrame* frame)
+{
+	for (s32 i = 0; i < MAX_ENTITIES; i++)
+	{
+		BenchObject* o = &objects[i];
+		if (!o->active)
+			continue;
+		if (bench_randf() < 0.002f)
+		{
+			// despawn, and something else spawns somewhere else
+			o->active = false;
+			bench_spawn(bench_free_slot());
+			continue;
+		}
+		o->pos += o->velocity * BENCH_TICK;
+		if (o->spin != 0.0f)
+			o->rot = o->rot * Quat::euler(0.0f, o->spin * BENCH_TICK, 0.0f);
+	}
+
+	frame->clear();
+	for (s32 i = 0; i < MAX_ENTITIES; i++)
+	{
+		const BenchObject& o = objects[i];
+		if (!o.active)
+			continue;
+		BenchTransformState* t = frame->transform_add(i);
+		t->rot = o.rot;
+		t->pos = o.pos;
+		t->parent = o.parent;
+		t->revision = o.revision;
+		t->resolution = o.resolution;
+	}
+}
+
+s32 usage()
+{
+	fprintf(stderr, "%s", "Usage: change_mask_bench [transforms] [ticks] [ack lag in ticks]\n");
+	return 1;
+}
+
+s32 proc(s32 argc, char* argv[])
+{
+	s32 object_count = 600;
+	s32 tick_count = 3000;
+	s32 lag = 6;
+	if (argc > 4)
+		return usage();
+	if (argc > 1)
+		object_count = atoi(argv[1]);
+	if (argc > 2)
+		tick_count = atoi(argv[2]);
+	if (argc > 3)
+		lag = atoi(argv[3]);
+	if (object_count <= 0 || object_count > MAX_ENTITIES / 2 || tick_count <= 0 || lag <= 0 || lag >= BENCH_HISTORY)
+		return usage();
+
+	for (s32 i = 0; i < object_count; i++)
+		bench_spawn(bench_free_slot());
+
+	ID changed_per_index[MAX_ENTITIES];
+	ID changed_lockstep[MAX_ENTITIES];
+	r64 time_per_index = 0.0;
+	r64 time_lockstep = 0.0;
+	s64 changed_total = 0;
+	s32 compared = 0;
+
+	for (s32 tick = 0; tick < tick_count; tick++)
+	{
+		BenchFrame* frame = &frames[tick % BENCH_HISTORY];
+		bench_tick(frame);
+		if (tick < lag)
+			continue;
+		const BenchFrame& base = frames[(tick - lag) % BENCH_HISTORY];
+
+		r64 start = bench_time();
+		s32 count_per_index = bench_changed_per_index(*frame, base, changed_per_index);
+		time_per_index += bench_time() - start;
+
+		start = bench_time();
+		s32 count_lockstep = bench_changed_lockstep(*frame, base, changed_lockstep);
+		time_lockstep += bench_time() - start;
+
+		if (count_per_index != count_lockstep || memcmp(changed_per_index, changed_lockstep, sizeof(ID) * count_lockstep) != 0)
+		{
+			fprintf(stderr, "Error: change lists disagree on tick %d\n", tick);
+			return 1;
+		}
+		changed_total += count_lockstep;
+		compared++;
+	}
+
+	r64 per_frame = 1000000.0 / r64(compared);
+	printf("%d transforms | %d frames | base %d ticks back | %.1f changed per frame\n", object_count, compared, lag, r64(changed_total) / r64(compared));
+	printf("per-index: %.3fus | lockstep: %.3fus per frame\n", time_per_index * per_frame, time_lockstep * per_frame);
+
+	return 0;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	return VI::proc(argc, argv);
+}
@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "types.h"
+#include "vi_assert.h"
+#include "lmath.h"
+#include "data/array.h"
+#include "net_serialize.h"
+#include "game/constants.h"
+
+// packet checksum throughput: Net::crc32 against the byte-at-a-time table lookup it replaced,
+// over NET_MAX_PACKET_SIZE payloads plus a couple of smaller typical packet sizes.
+// payloads start at every offset mod 8 like packets at arbitrary addresses would, and both versions have to agree.
+
+namespace VI
+{
+
+u32 crc32_table[256];
+
+void crc32_table_init()
+{
+	for (u32 i = 0; i < 256; i++)
+	{
+		u32 c = i;
+		for (s32 k = 0; k < 8; k++)
+			c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+		crc32_table[i] = c;
+	}
+}
+
+// Net::crc32 before slice-by-8
+u32 crc32_bytewise(const u8* buffer, memory_index length, u32 value)
+{
+	value ^= 0xFFFFFFFF;
+	for (memory_index i = 0; i < length; i++)
+		value = (value >> 8) ^ crc32_table[(value ^ buffer[i]) & 0xFF];
+	return value ^ 0xFFFFFFFF;
+}
+
+u32 bench_random_state = 1;
+
+// deterministic, so runs are comparable
+u32 bench_rand()
+{
+	bench_random_state = bench_random_state * 1664525u + 1013904223u;
+	return bench_random_state >> 8;
+}
+
+r64 bench_time()
+{
+	return r64(std::chrono::high_resolution_clock::now().time_since_epoch().count()) / 1000000000.0;
+}
+
+s32 usage()
+{
+	fprintf(stderr, "%s", "Usage: crc32_bench [iterations]\n");
+	return 1;
+}
+
+s32 proc(s32 argc, char* argv[])
+{
+	s32 iterations = 200000;
+	if (argc > 2)
+		return usage();
+	if (argc > 1)
+		iterations = atoi(argv[1]);
+	if (iterations <= 0)
+		return usage();
+
+	crc32_table_init();
+
+	Array<u8> buffer(NET_MAX_PACKET_SIZE + 8, NET_MAX_PACKET_SIZE + 8);
+	for (s32 i = 0; i < buffer.length; i++)
+		buffer[i] = u8(bench_rand());
+
+	const s32 sizes[] = { 64, 512, NET_MAX_PACKET_SIZE };
+	for (s32 s = 0; s < s32(sizeof(sizes) / sizeof(sizes[0])); s++)
+	{
+		s32 size = sizes[s];
+		u32 sum_bytewise = 0;
+		u32 sum_current = 0;
+
+		r64 start = bench_time();
+		for (s32 i = 0; i < iterations; i++)
+			sum_bytewise += crc32_bytewise(&buffer[i & 7], size, u32(i));
+		r64 time_bytewise = bench_time() - start;
+
+		start = bench_time();
+		for (s32 i = 0; i < iterations; i++)
+			sum_current += Net::crc32(&buffer[i & 7], size, u32(i));
+		r64 time_current = bench_time() - start;
+
+		if (sum_bytewise != sum_current)
+		{
+			fprintf(stderr, "Error: checksums disagree on %d byte payloads\n", size);
+			return 1;
+		}
+
+		r64 megabytes = (r64(size) * r64(iterations)) / (1024.0 * 1024.0);
+		printf("%4d bytes: byte-at-a-time %.0f MB/s (%.3fus) | crc32 %.0f MB/s (%.3fus)\n", size,
+			megabytes / time_bytewise, (time_bytewise * 1000000.0) / r64(iterations),
+			megabytes / time_current, (time_current * 1000000.0) / r64(iterations));
+	}
+
+	return 0;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	return VI::proc(argc, argv);
+}
@@ -320,19 +320,32 @@ void Animator::Layer::changed_animation()
 
 void Animator::update_server(const Update& u)
 {
-	for (s32 i = 0; i < MAX_ANIMATIONS; i++)
-		layers[i].update(u.time.delta, u.time.delta, *this);
+	update_layers(u.time.delta, u.time.delta);
 	update_world_transforms();
 }
 
 void Animator::update_client_only(const Update& u)
 {
-	for (s32 i = 0; i < MAX_ANIMATIONS; i++)
-		layers[i].update(0.0f, u.time.delta, *this);
+	update_layers(0.0f, u.time.delta);
 	update_world_transforms();
 }
 
+// advances animation time and fires triggers
+void Animator::update_layers(r32 dt, r32 dt_real)
+{
+	for (s32 i = 0; i < MAX_ANIMATIONS; i++)
+		layers[i].update(dt, dt_real, *this);
+}
+
 void Animator::update_world_transforms()
+{
+	update_pose();
+	update_bindings();
+}
+
+// evaluates bone matrices from the current layer state.
+// only touches this animator, so different animators can be posed on different threads.
+void Animator::update_pose()
 {
 	if (armature == AssetNull)
 		return;
@@ -430,6 +443,14 @@ void Animator::update_world_transforms()
 		}
 	}
 
+}
+
+// moves bound transforms to their bones
+void Animator::update_bindings()
+{
+	if (armature == AssetNull)
+		return;
+
 	Mat4 transform;
 	get<Transform>()->mat(&transform);
 	for (s32 i = 0; i < bindings.length; i++)
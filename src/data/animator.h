@@ -95,7 +95,10 @@ struct Animator : public ComponentType<Animator>
 	void update_client_only(const Update&);
 	void bind(const s32, Transform*);
 	void unbind(const Transform*);
+	void update_layers(r32, r32);
 	void update_world_transforms();
+	void update_pose();
+	void update_bindings();
 	void bone_transform(const s32, Vec3*, Quat* = nullptr);
 	void to_local(const s32, Vec3*, Quat* = nullptr);
 	void to_world(const s32, Vec3*, Quat* = nullptr);
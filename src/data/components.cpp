@@ -7,22 +7,99 @@ namespace VI
 {
 
 Transform::Transform()
-	: parent(), pos(Vec3::zero), rot(Quat::identity)
+	: parent(),
+	pos(Vec3::zero),
+	rot(Quat::identity),
+	cache_abs_pos(Vec3::zero),
+	cache_abs_rot(Quat::identity),
+	cache_pos(Vec3::zero),
+	cache_rot(Quat::identity),
+	cache_parent(),
+	cache_parent_version(),
+	cache_version()
 {
 
 }
 
-void Transform::mat(Mat4* m) const
+b8 Transform::cache_frozen;
+thread_local b8 transform_cache_owner;
+
+void Transform::cache_owner()
+{
+	transform_cache_owner = true;
+}
+
+// brings every cache up to date in one serial pass.
+// after this, other threads can read transforms until cache_thaw(), as long as nobody moves one.
+void Transform::cache_freeze()
+{
+	vi_assert(!cache_frozen);
+	for (auto i = list.iterator(); !i.is_last(); i.next())
+		i.item()->cache_refresh();
+	cache_frozen = true;
+}
+
+void Transform::cache_thaw()
+{
+	vi_assert(cache_frozen);
+	cache_frozen = false;
+}
+
+// assumes the parent's cache is already up to date
+b8 Transform::cache_dirty() const
 {
-	*m = Mat4::identity;
-	const Transform* t = this;
-	while (t)
-	{ 
-		Mat4 local = Mat4(t->rot);
-		local.translation(t->pos);
-		*m = *m * local;
-		t = t->parent.ref();
+	if (pos != cache_pos
+		|| rot.w != cache_rot.w || rot.x != cache_rot.x || rot.y != cache_rot.y || rot.z != cache_rot.z)
+		return true;
+	const Transform* p = parent.ref();
+	if (p)
+		return !cache_parent.equals(parent) || cache_parent_version != p->cache_version;
+	else
+		return cache_parent.id != IDNull;
+}
+
+// refreshes parents first, so the whole chain is brought up to date in top-down order.
+// cost is a handful of compares per level when nothing moved.
+void Transform::cache_refresh() const
+{
+	if (cache_frozen)
+	{
+		vi_assert(!cache_dirty()); // something moved a transform while caches were frozen
+		return;
 	}
+	vi_assert(transform_cache_owner);
+
+	const Transform* p = parent.ref();
+	if (p)
+	{
+		p->cache_refresh();
+		if (!cache_dirty())
+			return;
+
+		cache_abs_rot = p->cache_abs_rot * rot;
+		cache_abs_pos = (p->cache_abs_rot * pos) + p->cache_abs_pos;
+		cache_parent = parent;
+		cache_parent_version = p->cache_version;
+	}
+	else
+	{
+		if (!cache_dirty())
+			return;
+
+		cache_abs_rot = rot;
+		cache_abs_pos = pos;
+		cache_parent = Ref<Transform>();
+		cache_parent_version = 0;
+	}
+	cache_pos = pos;
+	cache_rot = rot;
+	cache_version++;
+}
+
+void Transform::mat(Mat4* m) const
+{
+	cache_refresh();
+	m->make_transform(cache_abs_pos, Vec3(1), cache_abs_rot);
 }
 
 void Transform::get_bullet(btTransform* world) const
@@ -48,15 +125,9 @@ void Transform::set(const Vec3& p, const Quat& r)
 
 void Transform::absolute(Vec3* abs_pos, Quat* abs_rot) const
 {
-	*abs_rot = Quat::identity;
-	*abs_pos = Vec3::zero;
-	const Transform* t = this;
-	while (t)
-	{ 
-		*abs_rot = t->rot * *abs_rot;
-		*abs_pos = (t->rot * *abs_pos) + t->pos;
-		t = t->parent.ref();
-	}
+	cache_refresh();
+	*abs_rot = cache_abs_rot;
+	*abs_pos = cache_abs_pos;
 }
 
 void Transform::absolute(const Vec3& abs_pos, const Quat& abs_rot)
@@ -79,14 +150,8 @@ void Transform::absolute(const Vec3& abs_pos, const Quat& abs_rot)
 
 Quat Transform::absolute_rot() const
 {
-	Quat q = Quat::identity;
-	const Transform* t = this;
-	while (t)
-	{ 
-		q = t->rot * q;
-		t = t->parent.ref();
-	}
-	return q;
+	cache_refresh();
+	return cache_abs_rot;
 }
 
 void Transform::absolute_rot(const Quat& q)
@@ -99,14 +164,8 @@ void Transform::absolute_rot(const Quat& q)
 
 Vec3 Transform::absolute_pos() const
 {
-	Vec3 abs_pos = Vec3::zero;
-	const Transform* t = this;
-	while (t)
-	{ 
-		abs_pos = (t->rot * abs_pos) + t->pos;
-		t = t->parent.ref();
-	}
-	return abs_pos;
+	cache_refresh();
+	return cache_abs_pos;
 }
 
 void Transform::absolute_pos(const Vec3& p)
@@ -119,14 +178,8 @@ void Transform::absolute_pos(const Vec3& p)
 
 Vec3 Transform::to_world(const Vec3& p) const
 {
-	Vec3 abs_pos = p;
-	const Transform* t = this;
-	while (t)
-	{ 
-		abs_pos = (t->rot * abs_pos) + t->pos;
-		t = t->parent.ref();
-	}
-	return abs_pos;
+	cache_refresh();
+	return (cache_abs_rot * p) + cache_abs_pos;
 }
 
 Vec3 Transform::to_local(const Vec3& p) const
@@ -150,13 +203,9 @@ Vec3 Transform::to_local_normal(const Vec3& p) const
 
 void Transform::to_world(Vec3* p, Quat* q) const
 {
-	const Transform* t = this;
-	while (t)
-	{ 
-		*q = t->rot * *q;
-		*p = (t->rot * *p) + t->pos;
-		t = t->parent.ref();
-	}
+	cache_refresh();
+	*q = cache_abs_rot * *q;
+	*p = (cache_abs_rot * *p) + cache_abs_pos;
 }
 
 void Transform::to_local(Vec3* p, Quat* q) const
@@ -207,4 +256,4 @@ SpotLight::SpotLight()
 {
 }
 
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -13,8 +13,31 @@ struct Transform : public ComponentType<Transform>
 	Vec3 pos;
 	Quat rot;
 
+	// cached world-space pose.
+	// pos, rot and parent are written directly all over the place, so instead of setters,
+	// the cache is considered dirty whenever they differ from the values it was computed from,
+	// or when the parent's own cached pose has changed since then.
+	// the const getters refresh the cache, so every read is also a write. transforms may only be read
+	// on the thread that called cache_owner(), except between cache_freeze() and cache_thaw(),
+	// when every cache is already up to date and the getters only read.
+	static b8 cache_frozen;
+	static void cache_owner();
+	static void cache_freeze();
+	static void cache_thaw();
+
+	mutable Vec3 cache_abs_pos;
+	mutable Quat cache_abs_rot;
+	mutable Vec3 cache_pos;
+	mutable Quat cache_rot;
+	mutable Ref<Transform> cache_parent;
+	mutable u32 cache_parent_version;
+	mutable u32 cache_version; // incremented every time the cached world pose changes
+
 	Transform();
 
+	b8 cache_dirty() const;
+	void cache_refresh() const;
+
 	void awake() {}
 	void get_bullet(btTransform*) const;
 	void set_bullet(const btTransform&);
@@ -19,6 +19,31 @@ namespace BitUtility
 		const u32 e = d + (d >> 16);
 		const u32 result = e & 0x0000003f;
 		return result;
+#endif // #ifdef __GNUC__
+	}
+
+	// index of the lowest set bit. x must not be zero
+	static inline s32 ctz(u32 x)
+	{
+#ifdef __GNUC__
+		return __builtin_ctz(x);
+#else // #ifdef __GNUC__
+		return s32(popcount((x & (0 - x)) - 1));
+#endif // #ifdef __GNUC__
+	}
+
+	// number of zero bits above the highest set bit. x must not be zero
+	static inline s32 clz(u32 x)
+	{
+#ifdef __GNUC__
+		return __builtin_clz(x);
+#else // #ifdef __GNUC__
+		x |= x >> 1;
+		x |= x >> 2;
+		x |= x >> 4;
+		x |= x >> 8;
+		x |= x >> 16;
+		return s32(32 - popcount(x));
 #endif // #ifdef __GNUC__
 	}
 }
@@ -61,28 +86,78 @@ template<s16 size> struct Bitmask
 			return 0;
 	}
 
+	// returns end if there are no more set bits
 	inline s32 next(s32 i) const
 	{
 		i++;
-		while (i < end)
+		if (i >= end)
+			return i;
+		s32 word = i / (sizeof(u32) * 8);
+		s32 bit = i - (word * sizeof(u32) * 8);
+		if (data[word] & (1u << bit)) // dense masks: the next bit is usually set. skip the ctz so loops aren't bound by its latency
+			return i;
+		u32 bits = data[word] & (u32(-1) << bit);
+		while (true)
 		{
-			if (get(i))
-				break;
-			i++;
+			if (bits)
+			{
+				s32 result = s32(word * sizeof(u32) * 8) + BitUtility::ctz(bits);
+				return result < end ? result : end;
+			}
+			word++;
+			if (s32(word * sizeof(u32) * 8) >= end)
+				return end;
+			bits = data[word];
 		}
-		return i;
 	}
 
+	// returns start - 1 if there are no more set bits
 	inline s32 prev(s32 i) const
 	{
 		i--;
-		while (i >= start)
+		if (i < start)
+			return i;
+		s32 word = i / (sizeof(u32) * 8);
+		s32 bit = i - (word * sizeof(u32) * 8);
+		if (data[word] & (1u << bit)) // see next()
+			return i;
+		u32 bits = data[word] & (u32(-1) >> ((sizeof(u32) * 8 - 1) - bit));
+		while (true)
 		{
-			if (get(i))
-				break;
-			i--;
+			if (bits)
+			{
+				s32 result = s32((word + 1) * sizeof(u32) * 8 - 1) - BitUtility::clz(bits);
+				return result >= start ? result : start - 1;
+			}
+			if (s32(word * sizeof(u32) * 8) <= start)
+				return start - 1;
+			word--;
+			bits = data[word];
 		}
-		return i;
+	}
+
+	// writes the index of every set bit to out, in ascending order, and returns how many there are.
+	// out needs room for count() entries.
+	s32 indices(ID* out) const
+	{
+		s32 result = 0;
+		if (start < end)
+		{
+			s32 start_index = start / (sizeof(u32) * 8);
+			s32 end_index = ((end - 1) / (sizeof(u32) * 8)) + 1;
+			for (s32 i = start_index; i < end_index; i++)
+			{
+				u32 bits = data[i];
+				s32 base = i * (sizeof(u32) * 8);
+				while (bits)
+				{
+					out[result] = ID(base + BitUtility::ctz(bits));
+					result++;
+					bits &= bits - 1; // clear lowest set bit
+				}
+			}
+		}
+		return result;
 	}
 
 	void clear()
@@ -108,25 +183,9 @@ template<s16 size> struct Bitmask
 			data[index] &= ~mask;
 
 			if (i + 1 == end)
-			{
-				s32 j;
-				for (j = i - 1; j > start; j--)
-				{
-					if (get(j))
-						break;
-				}
-				end = s16(j + 1);
-			}
+				end = s16(prev(i) + 1);
 			if (i == start)
-			{
-				s32 j;
-				for (j = i + 1; j < end; j++)
-				{
-					if (get(j))
-						break;
-				}
-				start = s16(j);
-			}
+				start = s16(next(i));
 			if (start >= end)
 			{
 				start = size;
@@ -279,4 +338,36 @@ struct PinArray
 	}
 };
 
+// one column of per-slot data living alongside a PinArray, indexed by the same IDs.
+// lets a component keep bulky, rarely-touched state out of its own struct, so loops over the PinArray stay dense.
+// also works the other way around: a few hot fields per column (struct-of-arrays), so a loop that only touches
+// those fields streams through them instead of dragging whole components through the cache. see pin_array_bench.
+// slots are not constructed or destroyed automatically; the owner initializes its slot when it is created.
+template<typename T, s16 size>
+struct PinColumn
+{
+	union
+	{
+		char _nil[size * sizeof(T)];
+		T data[size];
+	};
+
+	PinColumn()
+		: _nil()
+	{
+	}
+
+	inline const T& operator [] (s32 i) const
+	{
+		vi_assert(i >= 0 && i < size);
+		return data[i];
+	}
+
+	inline T& operator [] (s32 i)
+	{
+		vi_assert(i >= 0 && i < size);
+		return data[i];
+	}
+};
+
 }
@@ -127,5 +127,142 @@ public:
 	}
 };
 
+// same as PriorityQueue, but the key also tracks each entry's position in the heap,
+// so update() on an arbitrary entry doesn't require a linear search.
+// Key must provide:
+//   r32 priority(const T&);
+//   void heap_index(const T&, s32); // called whenever an entry moves; -1 = removed
+template<typename T, typename Key> struct IndexedPriorityQueue
+{
+	Array<T> heap;
+	Key* key;
+
+	IndexedPriorityQueue(Key* key)
+		: key(key), heap()
+	{
+	}
+
+private:
+
+	inline void swap(s32 pos_a, s32 pos_b)
+	{
+		T temp = heap[pos_a];
+		heap[pos_a] = heap[pos_b];
+		heap[pos_b] = temp;
+		key->heap_index(heap[pos_a], pos_a);
+		key->heap_index(heap[pos_b], pos_b);
+	}
+
+	void percolate_up(s32 position)
+	{
+		while (position > 0)
+		{
+			if (key->priority(heap[position]) < key->priority(heap[(position - 1) / 2]))
+			{
+				swap(position, (position - 1) / 2);
+				position = (position - 1) / 2;
+			}
+			else
+				break;
+		}
+	}
+
+	void percolate_down(s32 position)
+	{
+		while (position * 2 + 1 < heap.length)
+		{
+			s32 child;
+			if (position * 2 + 2 < heap.length && key->priority(heap[position * 2 + 2]) < key->priority(heap[position * 2 + 1]))
+				child = position * 2 + 2;
+			else 
+				child = position * 2 + 1;
+			if (key->priority(heap[child]) < key->priority(heap[position]))
+			{
+				swap(child, position);
+				position = child;
+			}
+			else
+				break;
+		}
+	}
+
+public:
+
+	inline s32 size() const
+	{
+		return heap.length;
+	}
+
+	// doesn't touch the key; entries left over may belong to a key that has since been reset or rebuilt.
+	// the key is expected to ignore stale heap indices anyway (see DroneNavMeshNodeData::FlagInQueue)
+	void clear()
+	{
+		heap.length = 0;
+	}
+
+	void reserve(s32 size)
+	{
+		heap.reserve(size);
+	}
+
+	void push(const T& entry)
+	{
+		heap.add(entry);
+		key->heap_index(entry, heap.length - 1);
+		percolate_up(heap.length - 1);
+	}
+
+	// index = heap position reported to the key via heap_index()
+	void update(s32 index)
+	{
+		vi_assert(index >= 0 && index < heap.length);
+		percolate_up(index);
+		percolate_down(index);
+	}
+
+	void remove(s32 index)
+	{
+		vi_assert(index >= 0 && index < heap.length);
+		key->heap_index(heap[index], -1);
+		if (index < heap.length - 1)
+		{
+			heap[index] = heap[heap.length - 1];
+			key->heap_index(heap[index], index);
+			heap.length--;
+			percolate_up(index);
+			percolate_down(index);
+		}
+		else
+			heap.length--;
+	}
+
+	const T& peek() const
+	{
+		return heap[0];
+	}
+
+	T& peek()
+	{
+		return heap[0];
+	}
+
+	T pop()
+	{
+		vi_assert(heap.length > 0);
+		T result = heap[0];
+		key->heap_index(result, -1);
+		if (heap.length > 1)
+		{
+			heap[0] = heap[heap.length - 1];
+			key->heap_index(heap[0], 0);
+			heap.length--;
+			percolate_down(0);
+		}
+		else
+			heap.length--;
+		return result;
+	}
+};
+
 
 }
\ No newline at end of file
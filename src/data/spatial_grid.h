@@ -0,0 +1,234 @@
+#pragma once
+
+#include "array.h"
+#include "lmath.h"
+
+namespace VI
+{
+
+
+// uniform spatial hash over a snapshot of positions.
+// usage: clear(), add() everything, build(), then run queries while the snapshot is still valid.
+// each entry lives in the single cell containing its center; queries are expanded by the largest entry radius.
+// entries added after build() are loose: they aren't sorted into cells and every query returns them.
+// use that for things that spawn while the snapshot is live, or that move on their own.
+// queries only return candidates; callers still do their own exact test.
+struct SpatialGrid
+{
+	static const s32 bucket_count = 1024; // must be a power of two
+	static const s32 max_query_cells = 64; // past this, it's cheaper to just walk every entry
+
+	struct Coord
+	{
+		s32 x;
+		s32 y;
+		s32 z;
+
+		inline b8 equals(const Coord& other) const
+		{
+			return x == other.x && y == other.y && z == other.z;
+		}
+	};
+
+	struct Entry
+	{
+		Vec3 pos;
+		Coord cell;
+		r32 radius;
+		ID id;
+		AI::Team team;
+	};
+
+	struct Query
+	{
+		Coord min;
+		Coord max;
+		Coord cell;
+		s32 index;
+		s32 index_end;
+		s32 loose;
+		AI::TeamMask mask;
+		b8 all; // walking every entry instead of cells
+	};
+
+	Array<Entry> pending; // also holds loose entries once the grid is built
+	Array<Entry> entries; // sorted by bucket
+	s32 bucket_start[bucket_count + 1];
+	r32 cell_size;
+	r32 max_radius;
+	b8 active;
+
+	SpatialGrid(r32 cell_size = 8.0f)
+		: pending(), entries(), bucket_start(), cell_size(cell_size), max_radius(), active()
+	{
+	}
+
+	inline Coord coord(const Vec3& p) const
+	{
+		return
+		{
+			s32(floorf(p.x / cell_size)),
+			s32(floorf(p.y / cell_size)),
+			s32(floorf(p.z / cell_size)),
+		};
+	}
+
+	static inline s32 hash(const Coord& c)
+	{
+		return s32((u32(c.x) * 73856093u) ^ (u32(c.y) * 19349663u) ^ (u32(c.z) * 83492791u)) & (bucket_count - 1);
+	}
+
+	void clear()
+	{
+		pending.length = 0;
+		entries.length = 0;
+		max_radius = 0.0f;
+		active = false;
+	}
+
+	void add(ID id, const Vec3& pos, r32 radius, AI::Team team)
+	{
+		Entry* e = pending.add();
+		e->pos = pos;
+		e->cell = coord(pos);
+		e->radius = radius;
+		e->id = id;
+		e->team = team;
+		if (!active) // loose entries don't widen cell queries
+			max_radius = vi_max(max_radius, radius);
+	}
+
+	// counting sort of pending entries into buckets
+	void build()
+	{
+		memset(bucket_start, 0, sizeof(bucket_start));
+		for (s32 i = 0; i < pending.length; i++)
+			bucket_start[hash(pending[i].cell) + 1]++;
+		for (s32 i = 0; i < bucket_count; i++)
+			bucket_start[i + 1] += bucket_start[i];
+
+		entries.resize(pending.length);
+		s32 cursor[bucket_count];
+		memcpy(cursor, bucket_start, sizeof(cursor));
+		for (s32 i = 0; i < pending.length; i++)
+		{
+			const Entry& e = pending[i];
+			entries[cursor[hash(e.cell)]++] = e;
+		}
+		pending.length = 0;
+		active = true;
+	}
+
+	// candidates within the given axis-aligned box, expanded by the largest entry radius.
+	// before build(), bucket_start doesn't describe entries, so every pending entry is a candidate
+	Query box(const Vec3& bmin, const Vec3& bmax, AI::TeamMask mask = AI::TeamAll) const
+	{
+		Query q;
+		q.loose = 0;
+		q.mask = mask;
+		if (!active)
+		{
+			q.all = true;
+			q.index = 0;
+			q.index_end = 0;
+			return q;
+		}
+		q.min = coord(bmin - Vec3(max_radius));
+		q.max = coord(bmax + Vec3(max_radius));
+		s64 cells = s64(q.max.x - q.min.x + 1) * s64(q.max.y - q.min.y + 1) * s64(q.max.z - q.min.z + 1);
+		q.all = cells > max_query_cells;
+		if (q.all)
+		{
+			q.index = 0;
+			q.index_end = entries.length;
+		}
+		else
+		{
+			q.cell = q.min;
+			s32 bucket = hash(q.cell);
+			q.index = bucket_start[bucket];
+			q.index_end = bucket_start[bucket + 1];
+		}
+		return q;
+	}
+
+	Query sphere(const Vec3& pos, r32 radius, AI::TeamMask mask = AI::TeamAll) const
+	{
+		return box(pos - Vec3(radius), pos + Vec3(radius), mask);
+	}
+
+	Query segment(const Vec3& a, const Vec3& b, r32 radius, AI::TeamMask mask = AI::TeamAll) const
+	{
+		Vec3 bmin(vi_min(a.x, b.x), vi_min(a.y, b.y), vi_min(a.z, b.z));
+		Vec3 bmax(vi_max(a.x, b.x), vi_max(a.y, b.y), vi_max(a.z, b.z));
+		return box(bmin - Vec3(radius), bmax + Vec3(radius), mask);
+	}
+
+	static inline b8 match(AI::Team t, AI::TeamMask m)
+	{
+		// same as AI::match()
+		if (m == AI::TeamNone)
+			return t == AI::TeamNone;
+		else
+			return t != AI::TeamNone && (m & (1 << t));
+	}
+
+	// returns false when there are no more candidates
+	b8 next(Query* q, ID* id) const
+	{
+		while (true)
+		{
+			while (q->index < q->index_end)
+			{
+				const Entry& e = entries[q->index];
+				q->index++;
+				// different cells can share a bucket; only report entries that actually live in this cell
+				if ((q->all || e.cell.equals(q->cell)) && (q->mask == AI::TeamAll || match(e.team, q->mask)))
+				{
+					*id = e.id;
+					return true;
+				}
+			}
+
+			if (q->all)
+				break;
+
+			// advance to next cell
+			q->cell.x++;
+			if (q->cell.x > q->max.x)
+			{
+				q->cell.x = q->min.x;
+				q->cell.z++;
+				if (q->cell.z > q->max.z)
+				{
+					q->cell.z = q->min.z;
+					q->cell.y++;
+					if (q->cell.y > q->max.y)
+					{
+						q->all = true; // out of cells; index == index_end, so later calls go straight to the loose entries
+						break;
+					}
+				}
+			}
+			s32 bucket = hash(q->cell);
+			q->index = bucket_start[bucket];
+			q->index_end = bucket_start[bucket + 1];
+		}
+
+		while (q->loose < pending.length)
+		{
+			const Entry& e = pending[q->loose];
+			q->loose++;
+			if (q->mask == AI::TeamAll || match(e.team, q->mask))
+			{
+				*id = e.id;
+				return true;
+			}
+		}
+
+		return false;
+	}
+};
+
+
+}
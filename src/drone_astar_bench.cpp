@@ -0,0 +1,382 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "types.h"
+#include "vi_assert.h"
+#include "lmath.h"
+#include "data/array.h"
+#include "data/priority_queue.h"
+#include "data/import_common.h"
+#include "game/constants.h"
+#include "ai_record.h"
+
+// replays drone pathfinds recorded by the AI worker (see RECORD_DRONE_PATHFIND in ai_worker.cpp)
+// against the level's nav mesh, once with the indexed A* queue and once with the linear search it replaced.
+// both runs have to find the same paths, so this doubles as a correctness check.
+// force fields aren't part of the recording, so the force field cost is left out of both runs.
+
+namespace VI
+{
+
+#define BENCH_PATH_BIAS 4.0f // same as DRONE_PATH_BIAS in ai_worker.cpp
+
+// same as AI::Worker::DroneNavMeshNodeData
+struct BenchNodeData
+{
+	enum Flags : s8
+	{
+		FlagInQueue = (1 << 0),
+		FlagVisited = (1 << 1),
+	};
+
+	r32 travel_score;
+	r32 estimate_score;
+	DroneNavMeshNode parent;
+	s32 heap_index;
+	u32 generation;
+	s8 flags;
+};
+
+// same as AI::Worker::DroneNavMeshKey
+struct BenchKey
+{
+	Array<Array<BenchNodeData>> chunks;
+	u32 generation;
+
+	void resize(const DroneNavMesh& mesh)
+	{
+		chunks.resize(mesh.chunks.length);
+		for (s32 i = 0; i < chunks.length; i++)
+			chunks[i].resize(mesh.chunks[i].vertices.length);
+	}
+
+	void reset()
+	{
+		generation++;
+	}
+
+	BenchNodeData& get(const DroneNavMeshNode& node)
+	{
+		BenchNodeData& result = chunks[node.chunk][node.vertex];
+		if (result.generation != generation)
+		{
+			memset(&result, 0, sizeof(result));
+			result.generation = generation;
+		}
+		return result;
+	}
+
+	r32 priority(const DroneNavMeshNode& a)
+	{
+		const BenchNodeData& data = get(a);
+		return data.travel_score + data.estimate_score;
+	}
+
+	void heap_index(const DroneNavMeshNode& a, s32 index)
+	{
+		get(a).heap_index = index;
+	}
+};
+
+typedef IndexedPriorityQueue<DroneNavMeshNode, BenchKey> BenchIndexedQueue;
+typedef PriorityQueue<DroneNavMeshNode, BenchKey> BenchLinearQueue;
+
+void bench_queue_update(BenchIndexedQueue* queue, const DroneNavMeshNode& node, const BenchNodeData& data)
+{
+	queue->update(data.heap_index);
+}
+
+// what drone_astar did before the queue was indexed
+void bench_queue_update(BenchLinearQueue* queue, const DroneNavMeshNode& node, const BenchNodeData& data)
+{
+	for (s32 j = 0; j < queue->size(); j++)
+	{
+		if (queue->heap[j].equals(node))
+		{
+			queue->update(j);
+			break;
+		}
+	}
+}
+
+struct BenchResult
+{
+	s32 length; // number of nodes in the path; 0 if there isn't one
+	r32 travel_score;
+	s32 visited;
+};
+
+inline b8 bench_flags_match(b8 crawl, s8 rule)
+{
+	return s32(rule) & (crawl ? 1 : 2); // DroneAllow::Crawl, DroneAllow::Shoot
+}
+
+// same search as drone_astar with a PathfindScorer
+template<typename Queue> BenchResult bench_astar(const DroneNavMesh& mesh, BenchKey* key, Queue* queue, const AI::DronePathfindRecording::Record& record)
+{
+	BenchResult result = {};
+
+	const Vec3& end_pos = mesh.chunks[record.end.chunk].vertices[record.end.vertex];
+
+	queue->clear();
+	key->reset();
+	queue->push(record.start);
+	{
+		BenchNodeData* start_data = &key->get(record.start);
+		start_data->estimate_score = (end_pos - mesh.chunks[record.start.chunk].vertices[record.start.vertex]).length();
+		start_data->parent = DRONE_NAV_MESH_NODE_NONE;
+		start_data->flags = BenchNodeData::FlagInQueue;
+	}
+
+	while (queue->size() > 0)
+	{
+		DroneNavMeshNode vertex_node = queue->pop();
+		BenchNodeData* vertex_data = &key->get(vertex_node);
+		vertex_data->flags = s8((vertex_data->flags | BenchNodeData::FlagVisited) & ~BenchNodeData::FlagInQueue);
+		result.visited++;
+
+		if (vertex_node.equals(record.end))
+		{
+			result.travel_score = vertex_data->travel_score;
+			DroneNavMeshNode n = vertex_node;
+			while (true)
+			{
+				result.length++;
+				if (n.equals(record.start))
+					break;
+				n = key->get(n).parent;
+			}
+			break;
+		}
+
+		const Vec3& vertex_pos = mesh.chunks[vertex_node.chunk].vertices[vertex_node.vertex];
+		const DroneNavMeshAdjacency& adjacency = mesh.chunks[vertex_node.chunk].adjacency[vertex_node.vertex];
+		for (s32 i = 0; i < adjacency.neighbors.length; i++)
+		{
+			const DroneNavMeshNode adjacent_node = adjacency.neighbors[i];
+			BenchNodeData* adjacent_data = &key->get(adjacent_node);
+			if (adjacent_data->flags & BenchNodeData::FlagVisited)
+				continue;
+
+			if (!bench_flags_match(adjacency.flags & (u64(1) << i), record.rule))
+			{
+				adjacent_data->flags |= BenchNodeData::FlagVisited;
+				continue;
+			}
+
+			const Vec3& adjacent_pos = mesh.chunks[adjacent_node.chunk].vertices[adjacent_node.vertex];
+			r32 candidate_travel_score = vertex_data->travel_score + (adjacent_pos - vertex_pos).length() + BENCH_PATH_BIAS;
+
+			if (adjacent_data->flags & BenchNodeData::FlagInQueue)
+			{
+				if (candidate_travel_score < adjacent_data->travel_score)
+				{
+					adjacent_data->parent = vertex_node;
+					adjacent_data->travel_score = candidate_travel_score;
+					bench_queue_update(queue, adjacent_node, *adjacent_data);
+				}
+			}
+			else
+			{
+				adjacent_data->parent = vertex_node;
+				adjacent_data->travel_score = candidate_travel_score;
+				adjacent_data->estimate_score = (end_pos - adjacent_pos).length();
+				adjacent_data->flags |= BenchNodeData::FlagInQueue;
+				queue->push(adjacent_node);
+			}
+		}
+	}
+
+	return result;
+}
+
+// skips the minion nav mesh and reads the drone nav mesh, same as AI::load; reverb isn't needed
+b8 bench_nav_read(const char* path, DroneNavMesh* mesh)
+{
+	FILE* f = fopen(path, "rb");
+	if (!f)
+		return false;
+
+	{
+		Vec3 min;
+		s32 width;
+		s32 height;
+		fread(&min, sizeof(Vec3), 1, f);
+		fread(&width, sizeof(s32), 1, f);
+		fread(&height, sizeof(s32), 1, f);
+		s32 count = width * height;
+		for (s32 i = 0; i < count; i++)
+		{
+			s32 layer_count;
+			fread(&layer_count, sizeof(s32), 1, f);
+			for (s32 j = 0; j < layer_count; j++)
+			{
+				s32 data_size;
+				fread(&data_size, sizeof(s32), 1, f);
+				fseek(f, data_size, SEEK_CUR);
+			}
+		}
+	}
+
+	fread(&mesh->chunk_size, sizeof(r32), 1, f);
+	fread(&mesh->vmin, sizeof(Vec3), 1, f);
+	fread(&mesh->size, sizeof(DroneNavMesh::Coord), 1, f);
+	mesh->resize();
+	b8 success = true;
+	for (s32 i = 0; i < mesh->chunks.length; i++)
+	{
+		DroneNavMeshChunk* chunk = &mesh->chunks[i];
+		s32 vertex_count;
+		if (fread(&vertex_count, sizeof(s32), 1, f) != 1 || vertex_count < 0)
+		{
+			success = false;
+			break;
+		}
+		chunk->vertices.resize(vertex_count);
+		fread(chunk->vertices.data, sizeof(Vec3), vertex_count, f);
+		chunk->normals.resize(vertex_count);
+		fread(chunk->normals.data, sizeof(Vec3), vertex_count, f);
+		chunk->adjacency.resize(vertex_count);
+		if (s32(fread(chunk->adjacency.data, sizeof(DroneNavMeshAdjacency), vertex_count, f)) != vertex_count)
+		{
+			success = false;
+			break;
+		}
+	}
+	fclose(f);
+	return success;
+}
+
+b8 bench_node_valid(const DroneNavMesh& mesh, const DroneNavMeshNode& node)
+{
+	return node.chunk >= 0 && node.chunk < mesh.chunks.length
+		&& node.vertex >= 0 && node.vertex < mesh.chunks[node.chunk].vertices.length;
+}
+
+r64 bench_time()
+{
+	return r64(std::chrono::high_resolution_clock::now().time_since_epoch().count()) / 1000000000.0;
+}
+
+s32 usage()
+{
+	fprintf(stderr, "%s", "Usage: drone_astar_bench <recording> [nav mesh] [repeat]\n");
+	return 1;
+}
+
+s32 proc(s32 argc, char* argv[])
+{
+	if (argc < 2 || argc > 4)
+		return usage();
+	s32 repeat = argc > 3 ? atoi(argv[3]) : 1;
+	if (repeat <= 0)
+		return usage();
+
+	Array<AI::DronePathfindRecording::Record> records;
+	char nav_path[MAX_PATH_LENGTH + 1] = {};
+	{
+		FILE* f = fopen(argv[1], "rb");
+		AI::DronePathfindRecording::Header header;
+		if (!f
+			|| fread(&header, sizeof(header), 1, f) != 1
+			|| header.magic != AI::DronePathfindRecording::magic
+			|| header.version != AI::DronePathfindRecording::version
+			|| header.path_length < 0 || header.path_length > MAX_PATH_LENGTH
+			|| s32(fread(nav_path, sizeof(char), header.path_length, f)) != header.path_length)
+		{
+			fprintf(stderr, "Error: '%s' is missing, or isn't a drone pathfind recording from this version\n", argv[1]);
+			if (f)
+				fclose(f);
+			return 1;
+		}
+		AI::DronePathfindRecording::Record record;
+		while (fread(&record, sizeof(record), 1, f) == 1)
+			records.add(record);
+		fclose(f);
+	}
+
+	// the recorded path is relative to the game's working directory, so it can be overridden
+	const char* mesh_path = argc > 2 ? argv[2] : nav_path;
+	DroneNavMesh mesh;
+	if (!bench_nav_read(mesh_path, &mesh))
+	{
+		fprintf(stderr, "Error: can't read nav mesh '%s'\n", mesh_path);
+		return 1;
+	}
+
+	for (s32 i = 0; i < records.length; i++)
+	{
+		if (!bench_node_valid(mesh, records[i].start) || !bench_node_valid(mesh, records[i].end))
+		{
+			fprintf(stderr, "Error: query %d doesn't fit nav mesh '%s'; was it recorded on another level?\n", i, mesh_path);
+			return 1;
+		}
+	}
+
+	s32 vertex_count = 0;
+	for (s32 i = 0; i < mesh.chunks.length; i++)
+		vertex_count += mesh.chunks[i].vertices.length;
+
+	BenchKey key_indexed = {};
+	BenchKey key_linear = {};
+	key_indexed.resize(mesh);
+	key_linear.resize(mesh);
+	BenchIndexedQueue queue_indexed(&key_indexed);
+	BenchLinearQueue queue_linear(&key_linear);
+	queue_indexed.reserve(vertex_count);
+	queue_linear.reserve(vertex_count);
+
+	r64 time_indexed = 0.0;
+	r64 time_indexed_max = 0.0;
+	r64 time_linear = 0.0;
+	r64 time_linear_max = 0.0;
+	s64 visited = 0;
+	s64 found = 0;
+	s64 mismatches = 0;
+	for (s32 r = 0; r < repeat; r++)
+	{
+		for (s32 i = 0; i < records.length; i++)
+		{
+			r64 start = bench_time();
+			BenchResult indexed = bench_astar(mesh, &key_indexed, &queue_indexed, records[i]);
+			r64 elapsed = bench_time() - start;
+			time_indexed += elapsed;
+			time_indexed_max = vi_max(time_indexed_max, elapsed);
+
+			start = bench_time();
+			BenchResult linear = bench_astar(mesh, &key_linear, &queue_linear, records[i]);
+			elapsed = bench_time() - start;
+			time_linear += elapsed;
+			time_linear_max = vi_max(time_linear_max, elapsed);
+
+			if (indexed.length != linear.length || indexed.travel_score != linear.travel_score || indexed.visited != linear.visited)
+				mismatches++;
+			visited += indexed.visited;
+			if (indexed.length > 0)
+				found++;
+		}
+	}
+
+	s64 query_count = s64(records.length) * s64(repeat);
+	r64 per_query = query_count > 0 ? 1000.0 / r64(query_count) : 0.0;
+	printf("%d queries x %d | %d vertices | %lld paths found | %.1f nodes visited per query\n", records.length, repeat, vertex_count, (long long)found, query_count > 0 ? r64(visited) / r64(query_count) : 0.0);
+	printf("indexed: %.4fms per query | %.4fms max\n", time_indexed * per_query, time_indexed_max * 1000.0);
+	printf("linear: %.4fms per query | %.4fms max\n", time_linear * per_query, time_linear_max * 1000.0);
+
+	if (mismatches > 0)
+	{
+		fprintf(stderr, "Error: indexed and linear queues disagreed %lld times\n", (long long)mismatches);
+		return 1;
+	}
+
+	return 0;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	return VI::proc(argc, argv);
+}
@@ -616,7 +616,7 @@ Vec3 grenade_spawn_dir(const Vec3& dir_normalized)
 
 DroneCollisionState Drone::collision_state() const
 {
-	if (get<Health>()->active_armor_timer > 0.0f)
+	if (get<Health>()->active_armor_timer() > 0.0f)
 		return DroneCollisionState::ActiveArmor;
 	else if (UpgradeStation::drone_inside(this))
 		return DroneCollisionState::UpgradeStation; // invincible inside upgrade station
@@ -1054,7 +1054,7 @@ b8 Drone::net_msg(Net::StreamRead* p, Net::MessageSource src)
 				{
 					if ((Game::level.local || !drone->has<PlayerControlHuman>() || !drone->get<PlayerControlHuman>()->local()))
 					{
-						drone->get<Health>()->active_armor_timer = vi_max(drone->get<Health>()->active_armor_timer, ACTIVE_ARMOR_TIME * Game::session.config.ruleset.cooldown_speed());
+						drone->get<Health>()->active_armor_timer() = vi_max(drone->get<Health>()->active_armor_timer(), ACTIVE_ARMOR_TIME * Game::session.config.ruleset.cooldown_speed());
 						drone->get<Audio>()->post(AK::EVENTS::PLAY_DRONE_ACTIVE_ARMOR);
 					}
 					break;
@@ -1099,6 +1099,7 @@ void Drone::finish_flying_dashing_common()
 	last_pos = lerped_pos;
 }
 
+// linear on purpose: there are at most MAX_PLAYERS drones, and they move all through the tick, so a snapshot grid would go stale
 Drone* Drone::closest(AI::TeamMask mask, const Vec3& pos, r32* distance)
 {
 	Drone* closest = nullptr;
@@ -1163,7 +1164,7 @@ Drone::Drone()
 void Drone::awake()
 {
 	get<Animator>()->layers[0].behavior = Animator::Behavior::Loop;
-	link_arg<Entity*, &Drone::killed>(get<Health>()->killed);
+	link_arg<Entity*, &Drone::killed>(get<Health>()->killed());
 	get<Transform>()->absolute(&lerped_pos, &lerped_rotation);
 	update_offset();
 	if (Game::level.local && !weapon_model.ref())
@@ -2083,7 +2084,7 @@ b8 Drone::go(const Vec3& dir)
 				drone_sniper_effects(this, dir_normalized);
 			else if (a == Ability::ActiveArmor)
 			{
-				get<Health>()->active_armor_timer = ACTIVE_ARMOR_TIME * Game::session.config.ruleset.cooldown_speed(); // show invincibility sparkles instantly
+				get<Health>()->active_armor_timer() = ACTIVE_ARMOR_TIME * Game::session.config.ruleset.cooldown_speed(); // show invincibility sparkles instantly
 				get<Audio>()->post(AK::EVENTS::PLAY_DRONE_ACTIVE_ARMOR);
 			}
 		}
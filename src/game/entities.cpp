@@ -65,7 +65,7 @@ DroneEntity::DroneEntity(AI::Team team, const Vec3& pos)
 	create<AIAgent>()->team = team;
 	{
 		Health* health = create<Health>(DRONE_HEALTH, DRONE_HEALTH, Game::session.config.ruleset.drone_shield, Game::session.config.ruleset.drone_shield);
-		health->active_armor_timer = GRENADE_DELAY + 0.5f; // drones are invincible while spawning
+		health->active_armor_timer() = GRENADE_DELAY + 0.5f; // drones are invincible while spawning
 	}
 	create<Shield>();
 
@@ -87,13 +87,19 @@ Health::Health(s8 hp, s8 hp_max, s8 shield, s8 shield_max)
 	: hp(hp),
 	hp_max(hp_max),
 	shield(shield),
-	shield_max(shield_max),
-	changed(),
-	killed(),
-	regen_timer()
+	shield_max(shield_max)
 {
+	new (&changed_links[id()]) LinkArg<const HealthEvent&>();
+	new (&killed_links[id()]) LinkArg<Entity*>();
+	active_armor_timers[id()] = 0.0f;
+	regen_timers[id()] = 0.0f;
 }
 
+PinColumn<LinkArg<const HealthEvent&>, MAX_ENTITIES> Health::changed_links;
+PinColumn<LinkArg<Entity*>, MAX_ENTITIES> Health::killed_links;
+PinColumn<r32, MAX_ENTITIES> Health::active_armor_timers;
+PinColumn<r32, MAX_ENTITIES> Health::regen_timers;
+
 template<typename Stream> b8 serialize_health_event(Stream* p, Health* h, HealthEvent* e)
 {
 	serialize_ref(p, e->source);
@@ -121,9 +127,9 @@ b8 Health::net_msg(Net::StreamRead* p)
 	Health* h = ref.ref();
 	h->hp += e.hp;
 	h->shield += e.shield;
-	h->changed.fire(e);
+	h->changed().fire(e);
 	if (e.hp < 0 && h->hp == 0)
-		h->killed.fire(e.source.ref());
+		h->killed().fire(e.source.ref());
 
 	return true;
 }
@@ -172,7 +178,7 @@ void health_internal_apply_damage(Health* h, Entity* e, s8 damage)
 
 	if (damage_hp != 0 || damage_shield != 0)
 	{
-		h->regen_timer = SHIELD_REGEN_TIME + SHIELD_REGEN_DELAY;
+		h->regen_timer() = SHIELD_REGEN_TIME + SHIELD_REGEN_DELAY;
 
 		HealthEvent ev =
 		{
@@ -191,12 +197,12 @@ void Health::update(const Update& u)
 		// regen
 		if (shield < shield_max)
 		{
-			r32 old_timer = regen_timer;
-			regen_timer -= u.time.delta;
-			if (regen_timer < SHIELD_REGEN_TIME)
+			r32 old_timer = regen_timer();
+			regen_timer() -= u.time.delta;
+			if (regen_timer() < SHIELD_REGEN_TIME)
 			{
 				const r32 regen_interval = SHIELD_REGEN_TIME / r32(shield_max);
-				if (s32(old_timer / regen_interval) != s32(regen_timer / regen_interval))
+				if (s32(old_timer / regen_interval) != s32(regen_timer() / regen_interval))
 				{
 					HealthEvent e =
 					{
@@ -240,7 +246,7 @@ void Health::update(const Update& u)
 		}
 	}
 
-	active_armor_timer = vi_max(0.0f, active_armor_timer - u.time.delta);
+	active_armor_timer() = vi_max(0.0f, active_armor_timer() - u.time.delta);
 }
 
 b8 Health::damage_buffer_required(const Entity* src) const
@@ -323,16 +329,16 @@ s8 Health::total() const
 b8 Health::active_armor(const Net::StateFrame* state_frame) const
 {
 	if (has<ForceField>())
-		return active_armor_timer > 0.0f || (get<ForceField>()->flags & ForceField::FlagInvincible);
+		return active_armor_timer() > 0.0f || (get<ForceField>()->flags & ForceField::FlagInvincible);
 	else if (has<Drone>())
 	{
 		if (state_frame && state_frame->drones[get<Drone>()->id()].active)
 			return state_frame->drones[get<Drone>()->id()].collision_state == DroneCollisionState::ActiveArmor;
 		else
-			return active_armor_timer > 0.0f;
+			return active_armor_timer() > 0.0f;
 	}
 	else
-		return active_armor_timer > 0.0f;
+		return active_armor_timer() > 0.0f;
 }
 
 b8 Health::can_take_damage(Entity* damager, const Net::StateFrame* state_frame) const
@@ -457,7 +463,7 @@ void Shield::awake()
 		}
 	}
 
-	link_arg<const HealthEvent&, &Shield::health_changed>(get<Health>()->changed);
+	link_arg<const HealthEvent&, &Shield::health_changed>(get<Health>()->changed());
 }
 
 // not synced over network
@@ -789,7 +795,7 @@ void Battery::awake()
 	if (Game::level.mode == Game::Mode::Pvp)
 		PlayerHuman::log_add(_(strings::battery_added));
 	link_arg<const TargetEvent&, &Battery::hit>(get<Target>()->target_hit);
-	link_arg<Entity*, &Battery::killed>(get<Health>()->killed);
+	link_arg<Entity*, &Battery::killed>(get<Health>()->killed());
 	set_team_client(team);
 	if (Game::level.local && team != AI::TeamNone)
 		battery_spawn_force_field(this);
@@ -1482,7 +1488,7 @@ void Rectifier::awake()
 			parent->get<Minion>()->carrying = entity();
 	}
 	if (!has<Battery>())
-		link_arg<Entity*, &Rectifier::killed_by>(get<Health>()->killed);
+		link_arg<Entity*, &Rectifier::killed_by>(get<Health>()->killed());
 }
 
 void Rectifier::killed_by(Entity* e)
@@ -2430,7 +2436,7 @@ void MinionSpawner::awake()
 		if (parent->has<Minion>())
 			parent->get<Minion>()->carrying = entity();
 	}
-	link_arg<Entity*, &MinionSpawner::killed_by>(get<Health>()->killed);
+	link_arg<Entity*, &MinionSpawner::killed_by>(get<Health>()->killed());
 }
 
 void MinionSpawner::killed_by(Entity* e)
@@ -2497,7 +2503,7 @@ void Turret::awake()
 			parent->get<Minion>()->carrying = entity();
 	}
 	target_check_time = mersenne::randf_oo() * TURRET_TARGET_CHECK_TIME;
-	link_arg<Entity*, &Turret::killed>(get<Health>()->killed);
+	link_arg<Entity*, &Turret::killed>(get<Health>()->killed());
 }
 
 Turret::~Turret()
@@ -2704,9 +2710,55 @@ void Turret::update_all(const Update& u)
 	}
 }
 
+SpatialGrid ForceField::grid(FORCE_FIELD_RADIUS * 2.0f);
+
+// attached force fields ride along with whatever they're stuck to, and get reattached when it dies
+b8 force_field_moves(const ForceField* field)
+{
+	return (field->flags & ForceField::FlagAttached) || field->get<Transform>()->parent.id != IDNull;
+}
+
+// snapshot every force field for ForceField::inside().
+// callers must clear the grid before the end of the tick.
+void ForceField::grid_build()
+{
+	grid.clear();
+	for (auto i = list.iterator(); !i.is_last(); i.next())
+	{
+		if (!force_field_moves(i.item()))
+			grid.add(i.index, i.item()->get<Transform>()->absolute_pos(), FORCE_FIELD_RADIUS, i.item()->team);
+	}
+	grid.build();
+
+	// these go in loose, so every query checks them against their current position
+	for (auto i = list.iterator(); !i.is_last(); i.next())
+	{
+		if (force_field_moves(i.item()))
+			grid.add(i.index, i.item()->get<Transform>()->absolute_pos(), FORCE_FIELD_RADIUS, i.item()->team);
+	}
+}
+
 // returns true if the given position is inside an enemy force field
 ForceField* ForceField::inside(AI::TeamMask mask, const Vec3& pos, r32 extra_radius)
 {
+	if (grid.active)
+	{
+		// pick the lowest ID, same as walking the list
+		ForceField* result = nullptr;
+		SpatialGrid::Query query = grid.sphere(pos, extra_radius, mask);
+		ID id;
+		while (grid.next(&query, &id))
+		{
+			if (list.active(id) && (!result || id < result->id())) // could have been removed since the grid was built
+			{
+				ForceField* field = &list[id];
+				if (AI::match(field->team, mask) && field->contains(pos, extra_radius))
+					result = field;
+			}
+		}
+		return result;
+	}
+
 	for (auto i = list.iterator(); !i.is_last(); i.next())
 	{
 		if (AI::match(i.item()->team, mask) && i.item()->contains(pos, extra_radius))
@@ -2765,11 +2817,14 @@ void ForceField::awake()
 	}
 	if (!(flags & FlagPermanent))
 	{
-		link_arg<Entity*, &ForceField::killed>(get<Health>()->killed);
-		link_arg<const HealthEvent&, &ForceField::health_changed>(get<Health>()->changed);
+		link_arg<Entity*, &ForceField::killed>(get<Health>()->killed());
+		link_arg<const HealthEvent&, &ForceField::health_changed>(get<Health>()->changed());
 	}
 	get<Audio>()->entry()->flag(AudioEntry::FlagEnableForceFieldObstruction, false);
 	get<Audio>()->post(AK::EVENTS::PLAY_FORCE_FIELD_LOOP);
+
+	if (grid.active) // spawned mid-tick; goes in loose
+		grid.add(id(), get<Transform>()->absolute_pos(), FORCE_FIELD_RADIUS, team);
 }
 
 ForceField::~ForceField()
@@ -3122,11 +3177,11 @@ BoltEntity::BoltEntity(AI::Team team, PlayerManager* player, Entity* owner, Bolt
 
 	Bolt* b = create<Bolt>();
 	r32 range = type == Bolt::Type::DroneBolter ? (DRONE_MAX_DISTANCE * 2.0f) : DRONE_MAX_DISTANCE;
-	b->remaining_lifetime = (range * 0.99f) / speed;
+	b->remaining_lifetime() = (range * 0.99f) / speed;
 	b->team = team;
 	b->owner = owner;
 	b->player = player;
-	b->velocity = dir * speed;
+	b->velocity() = dir * speed;
 	b->type = type;
 }
 
@@ -3204,20 +3259,31 @@ b8 Bolt::net_msg(Net::StreamRead* p, Net::MessageSource src)
 	return true;
 }
 
+PinColumn<Vec3, MAX_ENTITIES> Bolt::velocities;
+PinColumn<Vec3, MAX_ENTITIES> Bolt::last_positions;
+PinColumn<r32, MAX_ENTITIES> Bolt::remaining_lifetimes;
+
+Bolt::Bolt()
+{
+	velocities[id()] = Vec3::zero;
+	last_positions[id()] = Vec3::zero;
+	remaining_lifetimes[id()] = 0.0f;
+}
+
 void Bolt::awake()
 {
-	last_pos = get<Transform>()->absolute_pos();
+	last_pos() = get<Transform>()->absolute_pos();
 
 	if (owner.ref() && owner.ref()->has<Turret>())
 	{
 		owner.ref()->get<Audio>()->post(AK::EVENTS::PLAY_BOLT_SPAWN); // HACK
-		EffectLight::add(last_pos, DRONE_RADIUS * 1.5f, 0.1f, EffectLight::Type::MuzzleFlash);
+		EffectLight::add(last_pos(), DRONE_RADIUS * 1.5f, 0.1f, EffectLight::Type::MuzzleFlash);
 	}
 }
 
 b8 Bolt::visible() const
 {
-	return velocity.length_squared() > 0.0f;
+	return velocity().length_squared() > 0.0f;
 }
 
 b8 Bolt::default_raycast_filter(Entity* e, AI::Team team)
@@ -3230,6 +3296,38 @@ b8 Bolt::default_raycast_filter(Entity* e, AI::Team team)
 		&& (!e->has<Turret>() || e->get<Turret>()->team != team); // ignore friendly turrets
 }
 
+// test a single target against a bolt trace; updates out_hit if this is the closest hit so far
+void bolt_raycast_target(Target* target, const Vec3& trace_start, const Vec3& trace_end, AI::Team team, Bolt::Hit* out_hit, b8(*filter)(Entity*, AI::Team), const Net::StateFrame* state_frame, r32 extra_radius, r32* closest_hit_distance_sq)
+{
+	if (!filter(target->entity(), team))
+		return;
+
+	Vec3 p;
+	if (state_frame)
+	{
+		Vec3 pos;
+		Quat rot;
+		Vec3 local_offset;
+		Net::transform_absolute(*state_frame, target->get<Transform>()->id(), &pos, &rot, &local_offset);
+		p = pos + (rot * local_offset);
+	}
+	else
+		p = target->absolute_pos();
+
+	Vec3 intersection;
+	if (LMath::ray_sphere_intersect(trace_start, trace_end, p, target->radius() + extra_radius, &intersection))
+	{
+		r32 distance_sq = (intersection - trace_start).length_squared();
+		if (distance_sq < *closest_hit_distance_sq)
+		{
+			out_hit->point = intersection;
+			out_hit->normal = Vec3::normalize(intersection - p);
+			out_hit->entity = target->entity();
+			*closest_hit_distance_sq = distance_sq;
+		}
+	}
+}
+
 b8 Bolt::raycast(const Vec3& trace_start, const Vec3& trace_end, s16 mask, AI::Team team, Hit* out_hit, b8(*filter)(Entity*, AI::Team), const Net::StateFrame* state_frame, r32 extra_radius)
 {
 	out_hit->entity = nullptr;
@@ -3248,36 +3346,22 @@ b8 Bolt::raycast(const Vec3& trace_start, const Vec3& trace_end, s16 mask, AI::T
 	}
 
 	// check target collisions
-	for (auto i = Target::list.iterator(); !i.is_last(); i.next())
+	if (Target::grid.active && !state_frame) // grid is built from current positions, not historical state frames
 	{
-		if (!filter(i.item()->entity(), team))
-			continue;
-
-		Vec3 p;
-		if (state_frame)
+		// no team mask here; the filter decides which teams to skip per component (bolts still hit friendly batteries, grenades hit friendly minions)
+		SpatialGrid::Query query = Target::grid.segment(trace_start, trace_end, extra_radius);
+		ID id;
+		while (Target::grid.next(&query, &id))
 		{
-			Vec3 pos;
-			Quat rot;
-			Vec3 local_offset;
-			Net::transform_absolute(*state_frame, i.item()->get<Transform>()->id(), &pos, &rot, &local_offset);
-			p = pos + (rot * local_offset);
-		}
-		else
-			p = i.item()->absolute_pos();
-
-		Vec3 intersection;
-		if (LMath::ray_sphere_intersect(trace_start, trace_end, p, i.item()->radius() + extra_radius, &intersection))
-		{
-			r32 distance_sq = (intersection - trace_start).length_squared();
-			if (distance_sq < closest_hit_distance_sq)
-			{
-				out_hit->point = intersection;
-				out_hit->normal = Vec3::normalize(intersection - p);
-				out_hit->entity = i.item()->entity();
-				closest_hit_distance_sq = distance_sq;
-			}
+			if (Target::list.active(id)) // could have been removed since the grid was built
+				bolt_raycast_target(&Target::list[id], trace_start, trace_end, team, out_hit, filter, state_frame, extra_radius, &closest_hit_distance_sq);
 		}
 	}
+	else
+	{
+		for (auto i = Target::list.iterator(); !i.is_last(); i.next())
+			bolt_raycast_target(i.item(), trace_start, trace_end, team, out_hit, filter, state_frame, extra_radius, &closest_hit_distance_sq);
+	}
 
 	return out_hit->entity;
 }
@@ -3285,11 +3369,11 @@ b8 Bolt::raycast(const Vec3& trace_start, const Vec3& trace_end, s16 mask, AI::T
 // returns true if the bolt hit something
 b8 Bolt::simulate(r32 dt, Hit* out_hit, const Net::StateFrame* state_frame)
 {
-	remaining_lifetime -= dt;
-	if (!state_frame && remaining_lifetime < 0.0f)
+	remaining_lifetime() -= dt;
+	if (!state_frame && remaining_lifetime() < 0.0f)
 	{
 		if (visible())
-			ParticleEffect::spawn(ParticleEffect::Type::Fizzle, get<Transform>()->absolute_pos(), Quat::look(Vec3::normalize(velocity)));
+			ParticleEffect::spawn(ParticleEffect::Type::Fizzle, get<Transform>()->absolute_pos(), Quat::look(Vec3::normalize(velocity())));
 		World::remove_deferred(entity());
 		return false;
 	}
@@ -3298,8 +3382,8 @@ b8 Bolt::simulate(r32 dt, Hit* out_hit, const Net::StateFrame* state_frame)
 		return false;
 
 	Vec3 pos = get<Transform>()->absolute_pos();
-	Vec3 next_pos = pos + velocity * dt;
-	Vec3 trace_end = next_pos + Vec3::normalize(velocity) * BOLT_LENGTH;
+	Vec3 next_pos = pos + velocity() * dt;
+	Vec3 trace_end = next_pos + Vec3::normalize(velocity()) * BOLT_LENGTH;
 
 	Glass::shatter_all(pos, trace_end);
 
@@ -3333,7 +3417,7 @@ void Bolt::update_client_all(const Update& u)
 				Vec3 pos = i.item()->get<Transform>()->absolute_pos();
 				Particles::tracers.add
 				(
-					Vec3::lerp(particle_accumulator / vi_max(0.0001f, u.time.delta), i.item()->last_pos, pos),
+					Vec3::lerp(particle_accumulator / vi_max(0.0001f, u.time.delta), i.item()->last_pos(), pos),
 					Vec3::zero,
 					0
 				);
@@ -3342,7 +3426,7 @@ void Bolt::update_client_all(const Update& u)
 	}
 
 	for (auto i = list.iterator(); !i.is_last(); i.next())
-		i.item()->last_pos = i.item()->get<Transform>()->absolute_pos();
+		i.item()->last_pos() = i.item()->get<Transform>()->absolute_pos();
 }
 
 s16 Bolt::raycast_mask(AI::Team team)
@@ -3366,8 +3450,8 @@ void Bolt::reflect(const Entity* hit_object, ReflectionType reflection_type, con
 	else // simple reflection
 		dir = (transform->absolute_rot() * Vec3(0, 0, 1.0f)).reflect(normal);
 
-	velocity = dir * speed(type, true);
-	remaining_lifetime = (DRONE_MAX_DISTANCE * 0.99f) / (1.5f * speed(type, true));
+	velocity() = dir * speed(type, true);
+	remaining_lifetime() = (DRONE_MAX_DISTANCE * 0.99f) / (1.5f * speed(type, true));
 	transform->absolute_rot(Quat::look(dir));
 	transform->absolute_pos(transform->absolute_pos() + dir * BOLT_LENGTH);
 
@@ -3399,7 +3483,7 @@ void Bolt::hit_entity(const Hit& hit, const Net::StateFrame* state_frame)
 	{
 		if (reflected && hit_object->has<Minion>())
 			destroy = false;
-		basis = Vec3::normalize(velocity);
+		basis = Vec3::normalize(velocity());
 		s8 damage;
 		switch (type)
 		{
@@ -3500,8 +3584,8 @@ void Bolt::hit_entity(const Hit& hit, const Net::StateFrame* state_frame)
 			{
 				// wait for damage buffer
 				destroy = false;
-				velocity = Vec3::zero;
-				remaining_lifetime = NET_MAX_RTT_COMPENSATION * 2.0f;
+				velocity() = Vec3::zero;
+				remaining_lifetime() = NET_MAX_RTT_COMPENSATION * 2.0f;
 			}
 			hit_object->get<Health>()->damage(entity(), damage);
 		}
@@ -3509,7 +3593,7 @@ void Bolt::hit_entity(const Hit& hit, const Net::StateFrame* state_frame)
 		if (hit_object->has<RigidBody>())
 		{
 			RigidBody* body = hit_object->get<RigidBody>();
-			body->btBody->applyImpulse(velocity * 0.1f, Vec3::zero);
+			body->btBody->applyImpulse(velocity() * 0.1f, Vec3::zero);
 			body->btBody->activate(true);
 		}
 	}
@@ -3949,7 +4033,7 @@ void ShellCasing::cleanup()
 	delete btShape;
 }
 
-Array<InstanceVertex> ShellCasing::instances;
+thread_local Array<InstanceVertex> ShellCasing::instances;
 void ShellCasing::draw_all(const RenderParams& params)
 {
 	if (!params.camera->mask || !Settings::shell_casings)
@@ -4461,7 +4545,7 @@ void Grenade::update_all(const Update& u)
 
 void Grenade::awake()
 {
-	link_arg<Entity*, &Grenade::killed_by>(get<Health>()->killed);
+	link_arg<Entity*, &Grenade::killed_by>(get<Health>()->killed());
 	link_arg<const TargetEvent&, &Grenade::hit_by>(get<Target>()->target_hit);
 }
 
@@ -4563,6 +4647,18 @@ Vec3 Target::absolute_pos() const
 	return get<Transform>()->to_world(local_offset);
 }
 
+SpatialGrid Target::grid;
+
+// snapshot every target's position for fast bolt raycasts.
+// callers must clear the grid before targets move again.
+void Target::grid_build()
+{
+	grid.clear();
+	for (auto i = list.iterator(); !i.is_last(); i.next())
+		grid.add(i.index, i.item()->absolute_pos(), i.item()->radius(), AI::entity_team(i.item()->entity()));
+	grid.build();
+}
+
 PlayerTrigger::PlayerTrigger()
 	: entered(), exited(), triggered(), radius(1.0f)
 {
@@ -4642,7 +4738,7 @@ s32 PlayerTrigger::count() const
 	return count;
 }
 
-Array<InstanceVertex> Rope::instances;
+thread_local Array<InstanceVertex> Rope::instances;
 
 // draw rope segments and bolts
 void Rope::draw_all(const RenderParams& params)
@@ -5808,7 +5904,7 @@ void Ascensions::clear()
 Array<Asteroids::Entry> Asteroids::list;
 r32 Asteroids::timer;
 r32 Asteroids::particle_accumulator;
-Array<InstanceVertex> Asteroids::instances;
+thread_local Array<InstanceVertex> Asteroids::instances;
 
 void Asteroids::update(const Update& u)
 {
@@ -5920,7 +6016,7 @@ void Asteroids::clear()
 }
 
 PinArray<Tile, MAX_ENTITIES> Tile::list;
-Array<InstanceVertex> Tile::instances;
+thread_local Array<InstanceVertex> Tile::instances;
 
 void Tile::add(const Vec3& target_pos, const Quat& target_rot, const Vec3& offset, Transform* parent, r32 anim_time)
 {
@@ -6027,7 +6123,7 @@ r32 Tile::scale() const
 }
 
 PinArray<AirWave, MAX_ENTITIES> AirWave::list;
-Array<InstanceVertex> AirWave::instances;
+thread_local Array<InstanceVertex> AirWave::instances;
 
 void AirWave::add(const Vec3& pos, const Quat& rot, r32 timestamp_offset)
 {
@@ -2,6 +2,7 @@
 
 #include "data/entity.h"
 #include "ai.h"
+#include "data/spatial_grid.h"
 #include <bullet/src/btBulletDynamicsCommon.h>
 
 namespace VI
@@ -52,11 +53,15 @@ struct Health : public ComponentType<Health>
 
 	static b8 net_msg(Net::StreamRead*);
 
-	r32 active_armor_timer;
-	r32 regen_timer;
+	// link lists are much bigger than everything else, and update loops never touch them
+	static PinColumn<LinkArg<const HealthEvent&>, MAX_ENTITIES> changed_links;
+	static PinColumn<LinkArg<Entity*>, MAX_ENTITIES> killed_links;
+
+	// timers ticked every frame by update(), stored column-wise so that loop reads them contiguously
+	static PinColumn<r32, MAX_ENTITIES> active_armor_timers;
+	static PinColumn<r32, MAX_ENTITIES> regen_timers;
+
 	Array<BufferedDamage> damage_buffer;
-	LinkArg<const HealthEvent&> changed;
-	LinkArg<Entity*> killed;
 	s8 shield;
 	s8 shield_max;
 	s8 hp;
@@ -64,6 +69,31 @@ struct Health : public ComponentType<Health>
 
 	Health(s8 = 0, s8 = 0, s8 = 0, s8 = 0);
 
+	inline LinkArg<const HealthEvent&>& changed()
+	{
+		return changed_links[id()];
+	}
+
+	inline LinkArg<Entity*>& killed()
+	{
+		return killed_links[id()];
+	}
+
+	inline r32& active_armor_timer()
+	{
+		return active_armor_timers[id()];
+	}
+
+	inline r32 active_armor_timer() const
+	{
+		return active_armor_timers[id()];
+	}
+
+	inline r32& regen_timer()
+	{
+		return regen_timers[id()];
+	}
+
 	b8 damage_buffer_required(const Entity*) const;
 	void update(const Update&);
 	void awake() {}
@@ -355,7 +385,9 @@ struct ForceField : public ComponentType<ForceField>
 	};
 
 	static r32 particle_accumulator;
+	static SpatialGrid grid; // only valid between grid_build() and grid.clear()
 
+	static void grid_build();
 	static void update_all(const Update&);
 	static ForceField* inside(AI::TeamMask, const Vec3&, r32 = 0.0f);
 	static ForceField* closest(AI::TeamMask, const Vec3&, r32*);
@@ -450,7 +482,7 @@ struct WaterEntity : public Entity
 
 struct Rope : public ComponentType<Rope>
 {
-	static Array<InstanceVertex> instances;
+	static thread_local Array<InstanceVertex> instances;
 
 	static void draw_all(const RenderParams&);
 	static void spawn(const Vec3&, const Vec3&, r32, r32 = 0.0f, b8 = true, s8 = 0);
@@ -501,16 +533,45 @@ struct Bolt : public ComponentType<Bolt>
 	static void update_client_all(const Update&);
 	static b8 default_raycast_filter(Entity*, AI::Team);
 	static b8 raycast(const Vec3&, const Vec3&, s16, AI::Team, Hit*, b8(*)(Entity*, AI::Team), const Net::StateFrame* = nullptr, r32 = 0.0f);
-	
-	Vec3 velocity;
-	Vec3 last_pos;
-	r32 remaining_lifetime;
+
+	// simulation state, stored column-wise so the per-frame bolt loops stay dense
+	static PinColumn<Vec3, MAX_ENTITIES> velocities;
+	static PinColumn<Vec3, MAX_ENTITIES> last_positions;
+	static PinColumn<r32, MAX_ENTITIES> remaining_lifetimes;
+
 	Ref<PlayerManager> player;
 	Ref<Entity> owner;
 	AI::Team team;
 	Type type;
 	b8 reflected;
 
+	Bolt();
+
+	inline Vec3& velocity()
+	{
+		return velocities[id()];
+	}
+
+	inline const Vec3& velocity() const
+	{
+		return velocities[id()];
+	}
+
+	inline Vec3& last_pos()
+	{
+		return last_positions[id()];
+	}
+
+	inline r32& remaining_lifetime()
+	{
+		return remaining_lifetimes[id()];
+	}
+
+	inline r32 remaining_lifetime() const
+	{
+		return remaining_lifetimes[id()];
+	}
+
 	void awake();
 
 	b8 visible() const; // bolts are invisible and essentially inert while they are waiting for damage buffer
@@ -605,6 +666,10 @@ struct Grenade : public ComponentType<Grenade>
 
 struct Target : public ComponentType<Target>
 {
+	static SpatialGrid grid; // only valid between grid_build() and grid.clear()
+
+	static void grid_build();
+
 	Vec3 local_offset;
 	Vec3 net_velocity;
 	LinkArg<const TargetEvent&> target_hit;
@@ -628,7 +693,7 @@ struct ShellCasing
 	};
 
 	static Array<ShellCasing> list;
-	static Array<InstanceVertex> instances;
+	static thread_local Array<InstanceVertex> instances;
 
 	static void spawn(const Vec3&, const Quat&, Type);
 	static void clear();
@@ -836,7 +901,7 @@ struct Asteroids
 	};
 
 	static Array<Entry> list;
-	static Array<InstanceVertex> instances;
+	static thread_local Array<InstanceVertex> instances;
 	static r32 timer;
 	static r32 particle_accumulator;
 
@@ -849,7 +914,7 @@ struct Asteroids
 struct Tile
 {
 	static PinArray<Tile, MAX_ENTITIES> list;
-	static Array<InstanceVertex> instances;
+	static thread_local Array<InstanceVertex> instances;
 
 	static void add(const Vec3&, const Quat&, const Vec3&, Transform*, r32 = 0.3f);
 	static void draw_alpha(const RenderParams&);
@@ -875,7 +940,7 @@ struct AirWave
 {
 	static PinArray<AirWave, MAX_ENTITIES> list;
 
-	static Array<InstanceVertex> instances;
+	static thread_local Array<InstanceVertex> instances;
 
 	static void add(const Vec3&, const Quat&, r32 = 0.0f);
 	static void draw_alpha(const RenderParams&);
@@ -64,6 +64,7 @@
 #endif
 #include "data/unicode.h"
 #include "noise.h"
+#include "task_graph.h"
 
 #define DEBUG_WALK_NAV_MESH 0
 #define DEBUG_DRONE_AI_PATH 0
@@ -77,6 +78,7 @@ namespace VI
 
 b8 Game::quit;
 b8 Game::minimize;
+b8 Game::show_render_stats;
 b8 Game::multiplayer_is_online;
 GameTime Game::time;
 GameTime Game::real_time;
@@ -428,6 +430,8 @@ const char* Game::init(LoopSync* sync)
 
 	Drone::init();
 
+	TaskGraph::init(Settings::worker_threads);
+
 	Menu::splash();
 
 	return nullptr;
@@ -754,6 +758,57 @@ void Game::auth()
 	Auth::init();
 }
 
+TaskGraph update_graph;
+Array<Ref<Animator>> animator_updates; // animators advanced this frame
+
+// advances animation time and fires animation triggers, so it runs alone.
+// every trigger fires before any animator is posed. a trigger handler reading its own animator's bones
+// gets last frame's pose, same as when each animator was updated start to finish, since triggers always
+// fired before the pose was evaluated. other animators' bones and bound transforms are now also last frame's
+// for every handler; before, they were this frame's only for animators that happened to have a lower ID.
+void animator_update_layers(const Update& u, s32, s32)
+{
+	animator_updates.length = 0;
+	for (auto i = Animator::list.iterator(); !i.is_last(); i.next())
+	{
+		if (!Game::level.local && i.item()->has<Walker>() && (!i.item()->has<PlayerControlHuman>() || !i.item()->get<PlayerControlHuman>()->local()))
+			i.item()->update_layers(0.0f, u.time.delta); // walker animations are synced over the network
+		else if (!i.item()->has<Parkour>()) // Parkour component updates the Animator on its own terms
+			i.item()->update_layers(u.time.delta, u.time.delta);
+		else
+			continue;
+		animator_updates.add(i.item());
+	}
+}
+
+void animator_update_pose(const Update& u, s32 slice, s32 slice_count)
+{
+	s32 start = (animator_updates.length * slice) / slice_count;
+	s32 end = (animator_updates.length * (slice + 1)) / slice_count;
+	for (s32 i = start; i < end; i++)
+	{
+		Animator* animator = animator_updates[i].ref();
+		if (animator)
+			animator->update_pose();
+	}
+}
+
+// unattached force fields don't move, so this only reads transforms
+void force_field_grid_build(const Update& u, s32, s32)
+{
+	ForceField::grid_build();
+}
+
+void animator_update_bindings(const Update& u, s32, s32)
+{
+	for (s32 i = 0; i < animator_updates.length; i++)
+	{
+		Animator* animator = animator_updates[i].ref();
+		if (animator)
+			animator->update_bindings();
+	}
+}
+
 void Game::update(InputState* input, const InputState* last_input)
 {
 #if !SERVER && !defined(__ORBIS__)
@@ -969,13 +1024,23 @@ void Game::update(InputState* input, const InputState* last_input)
 				i.item()->update_server(u);
 			i.item()->update_client(u);
 		}
-		for (auto i = Animator::list.iterator(); !i.is_last(); i.next())
-		{
-			if (!level.local && i.item()->has<Walker>() && (!i.item()->has<PlayerControlHuman>() || !i.item()->get<PlayerControlHuman>()->local()))
-				i.item()->update_client_only(u); // walker animations are synced over the network
-			else if (!i.item()->has<Parkour>()) // Parkour component updates the Animator on its own terms
-				i.item()->update_server(u);
-		}
+
+		update_graph.clear();
+		update_graph.add(animator_update_layers, Animator::component_mask, Animator::component_mask);
+		update_graph.execute(u);
+
+		// nothing moves a transform until the bindings are written, so the caches can be frozen and read from any thread.
+		// ForceField::inside() falls back to a linear scan until the grid is built, so earlier callers get the same answers
+		Transform::cache_freeze();
+		update_graph.clear();
+		update_graph.add(animator_update_pose, Animator::component_mask, Animator::component_mask, TaskGraph::FlagConcurrent | TaskGraph::FlagSliced);
+		update_graph.add(force_field_grid_build, ForceField::component_mask | Transform::component_mask, ForceField::component_mask, TaskGraph::FlagConcurrent);
+		update_graph.execute(u);
+		Transform::cache_thaw();
+
+		update_graph.clear();
+		update_graph.add(animator_update_bindings, Animator::component_mask | Transform::component_mask, Transform::component_mask);
+		update_graph.execute(u);
 
 		for (auto i = TramRunner::list.iterator(); !i.is_last(); i.next())
 			i.item()->update(u);
@@ -995,8 +1060,10 @@ void Game::update(InputState* input, const InputState* last_input)
 				i.item()->update_server(u);
 			for (auto i = PlayerControlAI::list.iterator(); !i.is_last(); i.next())
 				i.item()->update_server(u);
+			Target::grid_build(); // targets don't move while bolts are simulating
 			for (auto i = Bolt::list.iterator(); !i.is_last(); i.next())
 				i.item()->simulate(u.time.delta);
+			Target::grid.clear();
 			for (auto i = Flag::list.iterator(); !i.is_last(); i.next())
 				i.item()->update_server(u);
 		}
@@ -1071,6 +1138,8 @@ void Game::update(InputState* input, const InputState* last_input)
 		if (level.rain > 0.0f)
 			Rain::spawn(u, level.rain);
 #endif
+
+		ForceField::grid.clear();
 	}
 	else
 	{
@@ -1115,6 +1184,7 @@ void Game::config_apply()
 
 void Game::term()
 {
+	TaskGraph::term();
 	Net::term();
 	Audio::term();
 #if !SERVER && !defined(__ORBIS__)
@@ -1637,6 +1707,8 @@ void Game::execute(const char* cmd)
 {
 	if (strcmp(cmd, "netstat") == 0)
 		Net::show_stats = !Net::show_stats;
+	else if (strcmp(cmd, "renderstat") == 0)
+		Game::show_render_stats = !Game::show_render_stats;
 #if !SERVER
 	else if (strstr(cmd, "replay") == cmd)
 	{
@@ -219,6 +219,7 @@ struct Game
 	static b8 cancel_event_eaten[MAX_GAMEPADS];
 	static b8 quit;
 	static b8 minimize;
+	static b8 show_render_stats;
 	static b8 multiplayer_is_online;
 	static Net::Master::AuthType auth_type;
 	static const char* language;
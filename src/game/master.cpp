@@ -147,6 +147,8 @@ void Messenger::update(r64 timestamp, Sock::Handle* sock, s32 max_outgoing)
 	else
 	{
 		r64 timestamp_cutoff = timestamp - NET_MASTER_RESEND_INTERVAL;
+		Sock::Datagram resends[NET_MAX_DATAGRAM_BATCH];
+		s32 resend_count = 0;
 		for (s32 i = 0; i < outgoing.length; i++)
 		{
 			OutgoingPacket* packet = &outgoing[i];
@@ -160,9 +162,20 @@ void Messenger::update(r64 timestamp, Sock::Handle* sock, s32 max_outgoing)
 				}
 #endif
 				packet->timestamp = timestamp;
-				Sock::udp_send(sock, packet->addr, packet->data.data.data, packet->data.bytes_written());
+				Sock::Datagram* resend = &resends[resend_count];
+				resend->address = packet->addr;
+				resend->data = packet->data.data.data;
+				resend->size = packet->data.bytes_written();
+				resend_count++;
+				if (resend_count == NET_MAX_DATAGRAM_BATCH)
+				{
+					Sock::udp_send_batch(sock, resends, resend_count);
+					resend_count = 0;
+				}
 			}
 		}
+		if (resend_count > 0)
+			Sock::udp_send_batch(sock, resends, resend_count);
 	}
 }
 
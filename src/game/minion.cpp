@@ -66,7 +66,7 @@ MinionEntity::MinionEntity(const Vec3& pos, const Quat& quat, AI::Team team, Pla
 void Minion::awake()
 {
 	link_arg<const TargetEvent&, &Minion::hit_by>(get<Target>()->target_hit);
-	link_arg<Entity*, &Minion::killed>(get<Health>()->killed);
+	link_arg<Entity*, &Minion::killed>(get<Health>()->killed());
 	target_timer = 100000.0f; // force target recalculation
 
 	Animator* animator = get<Animator>();
@@ -737,7 +737,7 @@ void Minion::update_server(const Update& u)
 			}
 			else if (get<Walker>()->support.ref() && get<Walker>()->dir.length_squared() > 0.0f)
 			{
-				r32 net_speed = vi_max(get<Walker>()->net_speed, WALK_SPEED * 0.5f);
+				r32 net_speed = vi_max(get<Walker>()->net_speed(), WALK_SPEED * 0.5f);
 				layer->speed = (net_speed / get<Walker>()->speed) * 1.2f;
 				layer->play(Asset::Animation::character_walk);
 			}
@@ -267,8 +267,8 @@ void Parkour::awake()
 	link<&Parkour::claw_sound>(animator->trigger(Asset::Animation::character_terminal_enter, 1.5f));
 	link<&Parkour::claw_sound>(animator->trigger(Asset::Animation::character_terminal_exit, 2.5f));
 	link<&Parkour::pickup_animation_complete>(animator->trigger(Asset::Animation::character_pickup, 2.5f));
-	link_arg<r32, &Parkour::land>(get<Walker>()->land);
-	link_arg<Entity*, &Parkour::killed>(get<Health>()->killed);
+	link_arg<r32, &Parkour::land>(get<Walker>()->land());
+	link_arg<Entity*, &Parkour::killed>(get<Health>()->killed());
 	last_angle_horizontal = get<Walker>()->target_rotation;
 }
 
@@ -299,7 +299,7 @@ void Parkour::land(r32 velocity_diff)
 		else if (velocity_diff < LANDING_VELOCITY_HARD)
 		{
 			fsm.transition(ParkourState::HardLanding);
-			get<Walker>()->max_speed = get<Walker>()->speed = get<Walker>()->net_speed = 0.0f;
+			get<Walker>()->max_speed = get<Walker>()->speed = get<Walker>()->net_speed() = 0.0f;
 			get<RigidBody>()->btBody->setLinearVelocity(Vec3(0, get<RigidBody>()->btBody->getLinearVelocity().getY(), 0));
 			get<Animator>()->layers[1].play(Asset::Animation::character_land_hard);
 			ParkourNet::send_effect(this, ParkourNet::EffectType::LandHard);
@@ -728,7 +728,7 @@ void Parkour::update_server(const Update& u)
 		if (blend == 1.0f)
 		{
 			fsm.transition(ParkourState::Normal);
-			get<RigidBody>()->btBody->setLinearVelocity(Quat::euler(0, get<Walker>()->target_rotation, 0) * Vec3(0, 0, get<Walker>()->net_speed));
+			get<RigidBody>()->btBody->setLinearVelocity(Quat::euler(0, get<Walker>()->target_rotation, 0) * Vec3(0, 0, get<Walker>()->net_speed()));
 			EffectLight::add(grapple_pos + Vec3(0, -0.1f, 0), (WALKER_MINION_RADIUS * 2.0f) - 0.2f, 0.35f, EffectLight::Type::MuzzleFlash);
 			EffectLight::add(grapple_pos, GRENADE_RANGE * 0.5f, 0.75f, EffectLight::Type::Shockwave);
 		}
@@ -742,7 +742,7 @@ void Parkour::update_server(const Update& u)
 		{
 			// done
 			fsm.transition(ParkourState::Normal);
-			get<RigidBody>()->btBody->setLinearVelocity(Quat::euler(0, get<Walker>()->target_rotation, 0) * Vec3(0, 0, get<Walker>()->net_speed));
+			get<RigidBody>()->btBody->setLinearVelocity(Quat::euler(0, get<Walker>()->target_rotation, 0) * Vec3(0, 0, get<Walker>()->net_speed()));
 		}
 		else
 		{
@@ -913,7 +913,7 @@ void Parkour::update_server(const Update& u)
 			last_support = get<Walker>()->support;
 			last_support_wall_run_state = ParkourWallRunState::None;
 			relative_support_pos = last_support.ref()->get<Transform>()->to_local(get<Walker>()->base_pos());
-			lean_target = get<Walker>()->net_speed * angular_velocity * (0.75f / 180.0f) / vi_max(0.0001f, u.time.delta);
+			lean_target = get<Walker>()->net_speed() * angular_velocity * (0.75f / 180.0f) / vi_max(0.0001f, u.time.delta);
 		}
 		else
 			allow_run = true;
@@ -930,7 +930,7 @@ void Parkour::update_server(const Update& u)
 	// update breath sound
 	if (Game::session.type == SessionType::Story)
 	{
-		if ((fsm.current != ParkourState::Normal || get<Walker>()->net_speed >= RUN_SPEED)
+		if ((fsm.current != ParkourState::Normal || get<Walker>()->net_speed() >= RUN_SPEED)
 			&& fsm.current != ParkourState::Climb)
 			breathing = vi_min(5.0f, breathing + u.time.delta * (1.0f / 1.0f));
 		else
@@ -970,7 +970,7 @@ void Parkour::update_server(const Update& u)
 			// walking/running
 
 			// set animation speed
-			r32 net_speed = vi_max(get<Walker>()->net_speed, WALK_SPEED * 0.5f);
+			r32 net_speed = vi_max(get<Walker>()->net_speed(), WALK_SPEED * 0.5f);
 			layer0->speed = (net_speed > WALK_SPEED ? ANIMATION_SPEED_MULTIPLIER * LMath::lerpf((net_speed - WALK_SPEED) / RUN_SPEED, 0.75f, 1.0f) : 1.1f * (net_speed / WALK_SPEED));
 
 			// choose animation
@@ -1886,7 +1886,7 @@ b8 Parkour::try_wall_run(ParkourWallRunState s, const Vec3& wall_direction)
 
 			if (add_velocity)
 			{
-				r32 speed = vi_max(get<Walker>()->net_speed, MIN_WALLRUN_SPEED + 1.0f);
+				r32 speed = vi_max(get<Walker>()->net_speed(), MIN_WALLRUN_SPEED + 1.0f);
 				velocity_flattened.y = 0.0f;
 				r32 flattened_speed = velocity_flattened.length();
 				if (flattened_speed > 0.01f)
@@ -1985,8 +1985,7 @@ Upgrade PlayerHuman::upgrade_selected() const
 b8 player_determine_visibility(PlayerCommon* me, PlayerCommon* other_player)
 {
 	// make sure we can see this guy
-	const PlayerManager::Visibility& visibility = PlayerManager::visibility[PlayerManager::visibility_hash(me->manager.ref(), other_player->manager.ref())];
-	return visibility.value;
+	return PlayerManager::visible(me->manager.ref(), other_player->manager.ref());
 }
 
 void player_draw_flag(const RenderParams& params, const Flag* flag)
@@ -2882,7 +2881,7 @@ PlayerCommon::PlayerCommon(PlayerManager* m)
 
 void PlayerCommon::awake()
 {
-	link_arg<const HealthEvent&, &PlayerCommon::health_changed>(get<Health>()->changed);
+	link_arg<const HealthEvent&, &PlayerCommon::health_changed>(get<Health>()->changed());
 	manager.ref()->instance = entity();
 }
 
@@ -2931,8 +2930,7 @@ Entity* PlayerCommon::incoming_attacker() const
 	PlayerManager* manager = get<PlayerCommon>()->manager.ref();
 	for (auto i = PlayerCommon::list.iterator(); !i.is_last(); i.next())
 	{
-		const PlayerManager::Visibility& visibility = PlayerManager::visibility[PlayerManager::visibility_hash(manager, i.item()->manager.ref())];
-		if (visibility.value)
+		if (PlayerManager::visible(manager, i.item()->manager.ref()))
 		{
 			// determine if they're attacking us
 			if (i.item()->get<Drone>()->state() != Drone::State::Crawl
@@ -3493,8 +3491,8 @@ void PlayerControlHuman::awake()
 	player.ref()->killed_by = nullptr;
 	player.ref()->spawn_animation_timer = TRANSITION_TIME * 0.5f;
 
-	link_arg<const HealthEvent&, &PlayerControlHuman::health_changed>(get<Health>()->changed);
-	link_arg<Entity*, &PlayerControlHuman::killed>(get<Health>()->killed);
+	link_arg<const HealthEvent&, &PlayerControlHuman::health_changed>(get<Health>()->changed());
+	link_arg<Entity*, &PlayerControlHuman::killed>(get<Health>()->killed());
 
 	if (has<Drone>())
 	{
@@ -3510,7 +3508,7 @@ void PlayerControlHuman::awake()
 	else
 	{
 		last_pos = get<Transform>()->absolute_pos();
-		link_arg<r32, &PlayerControlHuman::parkour_landed>(get<Walker>()->land);
+		link_arg<r32, &PlayerControlHuman::parkour_landed>(get<Walker>()->land());
 		link<&PlayerControlHuman::terminal_enter_animation_callback>(get<Animator>()->trigger(Asset::Animation::character_terminal_enter, 2.5f));
 		link<&PlayerControlHuman::interact_animation_callback>(get<Animator>()->trigger(Asset::Animation::character_interact, 3.8f));
 		link<&PlayerControlHuman::interact_animation_callback>(get<Animator>()->trigger(Asset::Animation::character_terminal_exit, 4.0f));
@@ -302,6 +302,56 @@ UpgradeInfo UpgradeInfo::list[s32(Upgrade::count)] =
 	},
 };
 
+// cached occlusion result for an unordered pair of players.
+// CollisionAudio only contains static level geometry, so the ray only needs to be re-cast when one of the endpoints moves.
+struct VisibilityRay
+{
+	Vec3 a;
+	Vec3 b;
+	Ref<Entity> entity_a;
+	Ref<Entity> entity_b;
+	b8 occluded;
+};
+
+#define VISIBILITY_RAY_THRESHOLD 0.25f
+
+VisibilityRay visibility_rays[MAX_PLAYERS * MAX_PLAYERS]; // indexed by lower player ID * MAX_PLAYERS + higher player ID
+
+void visibility_reset()
+{
+	for (s32 i = 0; i < MAX_PLAYERS; i++)
+		PlayerManager::visibility[i] = 0;
+	for (s32 i = 0; i < MAX_PLAYERS * MAX_PLAYERS; i++)
+	{
+		visibility_rays[i].entity_a = nullptr;
+		visibility_rays[i].entity_b = nullptr;
+	}
+}
+
+b8 visibility_occluded(btCollisionWorld::ClosestRayResultCallback* ray_callback, s32 a, Entity* a_entity, const Vec3& a_pos, s32 b, Entity* b_entity, const Vec3& b_pos)
+{
+	VisibilityRay* ray = &visibility_rays[a * MAX_PLAYERS + b];
+	if (ray->entity_a.ref() != a_entity
+		|| ray->entity_b.ref() != b_entity
+		|| (ray->a - a_pos).length_squared() > VISIBILITY_RAY_THRESHOLD * VISIBILITY_RAY_THRESHOLD
+		|| (ray->b - b_pos).length_squared() > VISIBILITY_RAY_THRESHOLD * VISIBILITY_RAY_THRESHOLD)
+	{
+		ray->a = a_pos;
+		ray->b = b_pos;
+		ray->entity_a = a_entity;
+		ray->entity_b = b_entity;
+
+		// reuse the same callback for every ray this frame
+		ray_callback->m_rayFromWorld = a_pos;
+		ray_callback->m_rayToWorld = b_pos;
+		ray_callback->m_closestHitFraction = 1.0f;
+		ray_callback->m_collisionObject = nullptr;
+		Physics::raycast(ray_callback, CollisionAudio);
+		ray->occluded = ray_callback->hasHit();
+	}
+	return ray->occluded;
+}
+
 void Team::awake_all()
 {
 	game_over_real_time = 0.0f;
@@ -321,8 +371,7 @@ void Team::awake_all()
 	battery_spawn_delay = Game::level.has_feature(Game::FeatureLevel::All) ? 0.0f : BATTERY_SPAWN_DELAY;
 	winner = nullptr;
 	score_summary.length = 0;
-	for (s32 i = 0; i < MAX_PLAYERS * MAX_PLAYERS; i++)
-		PlayerManager::visibility[i].value = false;
+	visibility_reset();
 }
 
 s32 Team::teams_with_active_players()
@@ -494,26 +543,6 @@ Team* Team::with_most_energy_collected()
 	return result;
 }
 
-b8 visibility_check(Entity* i, Entity* j, r32 i_range)
-{
-	Vec3 start = i->get<Transform>()->absolute_pos();
-	Vec3 end = j->get<Transform>()->absolute_pos();
-	Vec3 diff = end - start;
-
-	r32 dist_sq = diff.length_squared();
-	if (btFuzzyZero(dist_sq))
-		return true;
-	else if (dist_sq < i_range * i_range)
-	{
-		btCollisionWorld::ClosestRayResultCallback ray_callback(start, end);
-		Physics::raycast(&ray_callback, CollisionAudio);
-		if (!ray_callback.hasHit())
-			return true;
-	}
-
-	return false;
-}
-
 // determine which rectifiers can see the given player
 void get_rectifier_visibility(b8 visibility[MAX_TEAMS], Entity* player_entity)
 {
@@ -541,35 +570,80 @@ void get_rectifier_visibility(b8 visibility[MAX_TEAMS], Entity* player_entity)
 void update_visibility(const Update& u)
 {
 	// update player visibility
+	// occlusion is computed once per unordered pair; only the range check depends on which player is looking
+	Entity* entities[MAX_PLAYERS] = {};
+	Vec3 positions[MAX_PLAYERS];
+	r32 ranges[MAX_PLAYERS];
+	u16 rows[MAX_PLAYERS];
 	for (auto i = PlayerManager::list.iterator(); !i.is_last(); i.next())
 	{
-		Entity* i_entity = i.item()->instance.ref();
-
-		if (!i_entity)
-			continue;
+		Entity* entity = i.item()->instance.ref();
+		if (entity)
+		{
+			entities[i.index] = entity;
+			positions[i.index] = entity->get<Transform>()->absolute_pos();
+			ranges[i.index] = entity->has<Drone>() ? entity->get<Drone>()->range() : DRONE_MAX_DISTANCE;
+			rows[i.index] = 0;
+		}
+		else // players without an entity keep their old row
+			rows[i.index] = PlayerManager::visibility[i.index];
+	}
 
-		Team* i_team = i.item()->team.ref();
+	btCollisionWorld::ClosestRayResultCallback ray_callback(Vec3::zero, Vec3::zero);
 
-		r32 i_range = i_entity->has<Drone>() ? i_entity->get<Drone>()->range() : DRONE_MAX_DISTANCE;
+	for (auto i = PlayerManager::list.iterator(); !i.is_last(); i.next())
+	{
+		s32 a = i.index;
+		Entity* a_entity = entities[a];
+		Team* a_team = i.item()->team.ref();
 
-		for (auto j = PlayerManager::list.iterator(); !j.is_last(); j.next())
+		for (auto j = i; !j.is_last(); j.next())
 		{
-			Team* j_team = j.item()->team.ref();
-
-			PlayerManager::Visibility* visibility = &PlayerManager::visibility[PlayerManager::visibility_hash(i.item(), j.item())];
+			s32 b = j.index;
+			Entity* b_entity = entities[b];
 
-			if (i_team == j_team)
-				visibility->value = true;
-			else
+			b8 a_sees_b;
+			b8 b_sees_a;
+			if (a_team == j.item()->team.ref())
+			{
+				a_sees_b = true;
+				b_sees_a = true;
+			}
+			else if (a_entity && b_entity)
 			{
-				Entity* j_entity = j.item()->instance.ref();
-				if (j_entity)
-					visibility->value = visibility_check(i_entity, j_entity, i_range);
+				r32 dist_sq = (positions[b] - positions[a]).length_squared();
+				if (btFuzzyZero(dist_sq))
+				{
+					a_sees_b = true;
+					b_sees_a = true;
+				}
 				else
-					visibility->value = false;
+				{
+					a_sees_b = dist_sq < ranges[a] * ranges[a];
+					b_sees_a = dist_sq < ranges[b] * ranges[b];
+					if ((a_sees_b || b_sees_a)
+						&& visibility_occluded(&ray_callback, a, a_entity, positions[a], b, b_entity, positions[b]))
+					{
+						a_sees_b = false;
+						b_sees_a = false;
+					}
+				}
 			}
+			else
+			{
+				a_sees_b = false;
+				b_sees_a = false;
+			}
+
+			if (a_entity && a_sees_b)
+				rows[a] |= u16(1 << b);
+			if (b_entity && b_sees_a)
+				rows[b] |= u16(1 << a);
 		}
 	}
+
+	for (auto i = PlayerManager::list.iterator(); !i.is_last(); i.next())
+		PlayerManager::visibility[i.index] = rows[i.index];
 }
 
 namespace TeamNet
@@ -1221,7 +1295,7 @@ SpawnPoint* Team::get_spawn_point() const
 	return nullptr;
 }
 
-PlayerManager::Visibility PlayerManager::visibility[MAX_PLAYERS * MAX_PLAYERS];
+u16 PlayerManager::visibility[MAX_PLAYERS];
 
 PlayerManager::PlayerManager(Team* team, const char* u)
 	: spawn_timer(Game::session.config.ruleset.spawn_delay),
@@ -1355,9 +1429,9 @@ b8 PlayerManager::ability_valid(Ability ability) const
 	return true;
 }
 
-s32 PlayerManager::visibility_hash(const PlayerManager* drone_a, const PlayerManager* drone_b)
+b8 PlayerManager::visible(const PlayerManager* drone_a, const PlayerManager* drone_b)
 {
-	return drone_a->id() * MAX_PLAYERS + drone_b->id();
+	return visibility[drone_a->id()] & (1 << drone_b->id());
 }
 
 namespace PlayerManagerNet
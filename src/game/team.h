@@ -187,11 +187,6 @@ struct PlayerManager : public ComponentType<PlayerManager>
 		count,
 	};
 
-	struct Visibility
-	{
-		b8 value;
-	};
-
 	enum Flags : s8
 	{
 		FlagScoreAccepted = 1 << 0,
@@ -201,8 +196,9 @@ struct PlayerManager : public ComponentType<PlayerManager>
 		FlagParkourReady = 1 << 4,
 	};
 
-	static s32 visibility_hash(const PlayerManager*, const PlayerManager*);
-	static Visibility visibility[MAX_PLAYERS * MAX_PLAYERS];
+	static u16 visibility[MAX_PLAYERS]; // bit b of row a is set if player a can see player b
+
+	static b8 visible(const PlayerManager*, const PlayerManager*);
 
 	static void update_all(const Update&);
 	static b8 net_msg(Net::StreamRead*, PlayerManager*, Message, Net::MessageSource);
@@ -33,13 +33,17 @@ Walker::Walker(r32 rot)
 	rotation(rot),
 	target_rotation(rot),
 	auto_rotate(true),
-	enabled(true),
-	land(),
-	net_speed_timer(),
-	net_speed()
+	enabled(true)
 {
+	new (&land_links[id()]) LinkArg<r32>();
+	net_speeds[id()] = 0.0f;
+	net_speed_timers[id()] = 0.0f;
 }
 
+PinColumn<LinkArg<r32>, MAX_ENTITIES> Walker::land_links;
+PinColumn<r32, MAX_ENTITIES> Walker::net_speeds;
+PinColumn<r32, MAX_ENTITIES> Walker::net_speed_timers;
+
 void Walker::awake()
 {
 	// NOTE: RigidBody must come before Walker in component_ids.cpp
@@ -154,17 +158,17 @@ Vec3 Walker::get_support_velocity(const Vec3& absolute_pos, const btCollisionObj
 void update_net_speed(const Update& u, Walker* w, const Vec3& v, const Vec3& support_velocity, const Vec3& z)
 {
 	r32 new_net_speed = vi_min(w->max_speed, (v - support_velocity).dot(z));
-	if (new_net_speed > w->net_speed - 0.1f)
+	if (new_net_speed > w->net_speed() - 0.1f)
 	{
-		w->net_speed_timer = 0.0f;
-		if (new_net_speed > w->net_speed)
-			w->net_speed = new_net_speed;
+		w->net_speed_timer() = 0.0f;
+		if (new_net_speed > w->net_speed())
+			w->net_speed() = new_net_speed;
 	}
 	else
 	{
-		w->net_speed_timer += u.time.delta;
-		if (w->net_speed_timer > 0.5f)
-			w->net_speed = new_net_speed;
+		w->net_speed_timer() += u.time.delta;
+		if (w->net_speed_timer() > 0.5f)
+			w->net_speed() = new_net_speed;
 	}
 }
 
@@ -211,7 +215,7 @@ void Walker::update_server(const Update& u)
 #if !SERVER
 				if (velocity_diff < expected_vertical_speed - 0.5f)
 				{
-					land.fire(velocity_diff - expected_vertical_speed);
+					land().fire(velocity_diff - expected_vertical_speed);
 					velocity = body->getLinearVelocity(); // event handlers may modify velocity
 				}
 #endif
@@ -278,7 +282,7 @@ void Walker::update_server(const Update& u)
 					if (z.y > 0.0f)
 						acceleration += z.y * ACCEL2 * 2.0f;
 
-					r32 target_speed = vi_max(net_speed, speed) * movement_length;
+					r32 target_speed = vi_max(net_speed(), speed) * movement_length;
 					if (net_z_speed > target_speed)
 					{
 						// decelerate
@@ -329,7 +333,7 @@ void Walker::update_server(const Update& u)
 
 			// don't allow the walker to go faster than the speed we were going when we last hit the ground
 			r32 accel_length = accel3.length();
-			if (accel_length > 0.0f && velocity.dot(accel3 / accel_length) < vi_max(speed * 0.25f, net_speed))
+			if (accel_length > 0.0f && velocity.dot(accel3 / accel_length) < vi_max(speed * 0.25f, net_speed()))
 				adjustment += accel3;
 		}
 
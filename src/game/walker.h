@@ -19,19 +19,41 @@ struct Walker : public ComponentType<Walker>
 {
 	static Vec3 get_support_velocity(const Vec3&, const btCollisionObject*);
 
+	static PinColumn<LinkArg<r32>, MAX_ENTITIES> land_links; // kept out of the component so update loops stay dense
+	static PinColumn<r32, MAX_ENTITIES> net_speeds;
+	static PinColumn<r32, MAX_ENTITIES> net_speed_timers;
+
 	Vec2 dir;
 	r32 speed,
 		max_speed,
 		rotation,
-		target_rotation,
-		net_speed,
-		net_speed_timer;
+		target_rotation;
 	Ref<RigidBody> support;
-	LinkArg<r32> land;
 	b8 auto_rotate;
 	b8 enabled;
 
 	Walker(r32 = 0.0f);
+
+	inline LinkArg<r32>& land()
+	{
+		return land_links[id()];
+	}
+
+	inline r32& net_speed()
+	{
+		return net_speeds[id()];
+	}
+
+	inline r32 net_speed() const
+	{
+		return net_speeds[id()];
+	}
+
+	inline r32& net_speed_timer()
+	{
+		return net_speed_timers[id()];
+	}
+
 	void awake();
 	b8 slide(Vec2*, const Vec3&);
 	btCollisionWorld::ClosestRayResultCallback check_support(r32 = 0.0f) const;
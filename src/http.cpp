@@ -3,6 +3,7 @@
 #include "data/pin_array.h"
 #include <new>
 #include "settings.h"
+#include "platform/util.h"
 
 namespace VI
 {
@@ -46,14 +47,60 @@ struct SmtpRequest
 	}
 };
 
+struct Socket
+{
+	s32 fd;
+	b8 read;
+	b8 write;
+};
+
 struct State
 {
 	CURLM* curl_multi;
 	PinArray<Request, 1024> requests; // up to N requests active at a time
 	Array<SmtpRequest> smtp_requests;
+	Array<Socket> sockets; // every socket curl is waiting on; kept up to date by socket_callback
+	Array<s32> sockets_scratch;
+	r64 timer; // when curl wants CURL_SOCKET_TIMEOUT; negative means never
 };
 State state;
 
+s32 socket_callback(CURL* curl, curl_socket_t fd, s32 what, void* user_data, void* socket_data)
+{
+	Socket* socket = nullptr;
+	for (s32 i = 0; i < state.sockets.length; i++)
+	{
+		if (state.sockets[i].fd == s32(fd))
+		{
+			socket = &state.sockets[i];
+			break;
+		}
+	}
+
+	if (what == CURL_POLL_REMOVE)
+	{
+		if (socket)
+			state.sockets.remove(s32(socket - &state.sockets[0]));
+	}
+	else
+	{
+		if (!socket)
+		{
+			socket = state.sockets.add();
+			socket->fd = s32(fd);
+		}
+		socket->read = what == CURL_POLL_IN || what == CURL_POLL_INOUT;
+		socket->write = what == CURL_POLL_OUT || what == CURL_POLL_INOUT;
+	}
+	return 0;
+}
+
+s32 timer_callback(CURLM* curl_multi, long timeout_ms, void* user_data)
+{
+	state.timer = timeout_ms < 0 ? -1.0 : platform::time() + r64(timeout_ms) / 1000.0;
+	return 0;
+}
+
 void init()
 {
 	if (curl_global_init(CURL_GLOBAL_SSL)) // no need for CURL_GLOBAL_WIN32 as Sock::init() initializes Win32 socket libs
@@ -63,6 +110,12 @@ void init()
 
 	if (!state.curl_multi)
 		vi_assert(false);
+
+	// curl tells us which sockets and timeouts it cares about, rather than us asking with curl_multi_fdset,
+	// which can't report sockets past FD_SETSIZE
+	state.timer = -1.0;
+	curl_multi_setopt(state.curl_multi, CURLMOPT_SOCKETFUNCTION, &socket_callback);
+	curl_multi_setopt(state.curl_multi, CURLMOPT_TIMERFUNCTION, &timer_callback);
 }
 
 size_t write_callback(void* data, size_t size, size_t count, void* user_data)
@@ -78,7 +131,19 @@ size_t write_callback(void* data, size_t size, size_t count, void* user_data)
 void update()
 {
 	s32 _; // never used
-	curl_multi_perform(state.curl_multi, &_);
+	if (state.timer >= 0.0 && platform::time() >= state.timer)
+	{
+		state.timer = -1.0;
+		curl_multi_socket_action(state.curl_multi, CURL_SOCKET_TIMEOUT, 0, &_);
+	}
+
+	// the event loop doesn't tell us which sockets woke it up, so curl checks each one itself.
+	// socket_callback can change the list while we do this, so go through a copy
+	state.sockets_scratch.length = 0;
+	for (s32 i = 0; i < state.sockets.length; i++)
+		state.sockets_scratch.add(state.sockets[i].fd);
+	for (s32 i = 0; i < state.sockets_scratch.length; i++)
+		curl_multi_socket_action(state.curl_multi, curl_socket_t(state.sockets_scratch[i]), 0, &_);
 
 	while (CURLMsg* msg = curl_multi_info_read(state.curl_multi, &_))
 	{
@@ -137,6 +202,21 @@ void update()
 	}
 }
 
+// for event loops. reports every socket curl is waiting on, and returns how long until update() must be called anyway,
+// in seconds. negative means there's no deadline
+r64 sockets(SocketCallback* callback)
+{
+	for (s32 i = 0; i < state.sockets.length; i++)
+	{
+		const Socket& socket = state.sockets[i];
+		callback(socket.fd, socket.read, socket.write);
+	}
+
+	if (state.timer < 0.0)
+		return -1.0;
+	return vi_max(0.0, state.timer - platform::time());
+}
+
 Request* get_headers(const char* url, Callback* callback, struct curl_slist* headers, u64 user_data)
 {
 	Request* request = state.requests.add();
@@ -302,6 +382,8 @@ void term()
 	}
 	state.smtp_requests.length = 0;
 	curl_multi_cleanup(state.curl_multi);
+	state.sockets.length = 0;
+	state.timer = -1.0;
 	curl_global_cleanup();
 }
 
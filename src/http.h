@@ -15,6 +15,7 @@ namespace Http
 {
 
 typedef void Callback(s32, const char*, u64);
+typedef void SocketCallback(s32, b8, b8); // socket, wants read, wants write
 
 extern char ca_path[MAX_PATH_LENGTH + 1];
 extern char smtp_server[MAX_PATH_LENGTH + 1];
@@ -41,6 +42,7 @@ Request* request_for_user_data(u64);
 void smtp(const char*, const char*, const char*, const char* = nullptr);
 Request* add(CURL*, Callback* = nullptr, struct curl_slist* = nullptr, u64 = 0);
 void update();
+r64 sockets(SocketCallback*);
 void term();
 
 
@@ -13,18 +13,45 @@
 #include "settings.h"
 #include "game/master.h"
 #include "game/overworld.h"
+#include "net_serialize.h"
+#include <mutex>
 
 namespace VI
 {
 
 const char* Loader::data_directory;
 LoopSwapper* Loader::swapper;
+b8 Loader::threaded;
+
+// guards the lazy loaders while Loader::threaded is set.
+// recursive because the _permanent and _instanced variants call the plain ones
+std::recursive_mutex lazy_load_mutex;
+
+struct LazyLoadLock
+{
+	b8 locked;
+
+	LazyLoadLock()
+		: locked(Loader::threaded)
+	{
+		if (locked)
+			lazy_load_mutex.lock();
+	}
+
+	~LazyLoadLock()
+	{
+		if (locked)
+			lazy_load_mutex.unlock();
+	}
+};
 
 namespace Settings
 {
 	Gamepad gamepads[MAX_GAMEPADS];
 	s32 display_mode_index;
 	s32 framerate_limit;
+	s32 ai_workers;
+	s32 worker_threads;
 #if SERVER
 	u64 secret;
 	u16 port;
@@ -52,6 +79,7 @@ namespace Settings
 	b8 subtitles;
 	b8 ssao;
 	b8 record;
+	b8 record_render;
 	b8 expo;
 	b8 shell_casings;
 	b8 god_mode;
@@ -411,6 +439,10 @@ void Loader::settings_load(const Array<DisplayMode>& modes, const DisplayMode& c
 	Settings::waypoints = b8(Json::get_s32(json, "waypoints", 1));
 	Settings::scan_lines = b8(Json::get_s32(json, "scan_lines", 1));
 	Settings::record = b8(Json::get_s32(json, "record", 0));
+	Settings::record_render = b8(Json::get_s32(json, "record_render", 0));
+	Settings::ai_workers = vi_max(-1, Json::get_s32(json, "ai_workers", -1));
+	Settings::worker_threads = vi_max(-1, Json::get_s32(json, "worker_threads", -1));
+	Net::packet_compression = Net::Compression(vi_max(0, vi_min(s32(Net::Compression::count) - 1, Json::get_s32(json, "net_compression"))));
 	Settings::expo = b8(Json::get_s32(json, "expo", 0));
 	Settings::god_mode = b8(Json::get_s32(json, "god_mode"));
 	Settings::parkour_reticle = b8(Json::get_s32(json, "parkour_reticle"));
@@ -473,8 +505,16 @@ void Loader::settings_save()
 	cJSON_AddNumberToObject(json, "version", config_version);
 	if (Settings::record)
 		cJSON_AddNumberToObject(json, "record", 1);
+	if (Settings::record_render)
+		cJSON_AddNumberToObject(json, "record_render", 1);
+	if (Settings::ai_workers != -1)
+		cJSON_AddNumberToObject(json, "ai_workers", Settings::ai_workers);
+	if (Settings::worker_threads != -1)
+		cJSON_AddNumberToObject(json, "worker_threads", Settings::worker_threads);
 	if (Settings::expo)
 		cJSON_AddNumberToObject(json, "expo", 1);
+	if (Net::packet_compression != Net::Compression::Zlib)
+		cJSON_AddNumberToObject(json, "net_compression", s32(Net::packet_compression));
 
 	// only save master server setting if it is not the default
 	if (strncmp(Settings::master_server, default_master_server, MAX_PATH_LENGTH) != 0)
@@ -546,6 +586,7 @@ void Loader::settings_save()
 
 const Mesh* Loader::mesh(AssetID id)
 {
+	LazyLoadLock lock;
 	if (id == AssetNull)
 		return nullptr;
 
@@ -617,6 +658,7 @@ const Mesh* Loader::mesh(AssetID id)
 
 const Mesh* Loader::mesh_permanent(AssetID id)
 {
+	LazyLoadLock lock;
 	const Mesh* m = mesh(id);
 	if (m)
 		meshes[id].type = AssetPermanent;
@@ -625,6 +667,7 @@ const Mesh* Loader::mesh_permanent(AssetID id)
 
 const Mesh* Loader::mesh_instanced(AssetID id)
 {
+	LazyLoadLock lock;
 	Mesh* m = (Mesh*)mesh(id);
 	if (m && !m->instanced)
 	{
@@ -654,6 +697,7 @@ void Loader::mesh_free(AssetID id)
 
 const Armature* Loader::armature(AssetID id)
 {
+	LazyLoadLock lock;
 	if (id == AssetNull || id >= armature_count)
 		return 0;
 
@@ -776,6 +820,7 @@ void Loader::dynamic_mesh_free(s32 id)
 
 const Animation* Loader::animation(AssetID id)
 {
+	LazyLoadLock lock;
 	if (id == AssetNull)
 		return 0;
 
@@ -850,6 +895,7 @@ void Loader::animation_free(AssetID id)
 
 void Loader::texture(AssetID id, RenderTextureWrap wrap, RenderTextureFilter filter)
 {
+	LazyLoadLock lock;
 #if !SERVER
 	if (id == AssetNull || id >= static_texture_count)
 		return;
@@ -890,6 +936,7 @@ void Loader::texture(AssetID id, RenderTextureWrap wrap, RenderTextureFilter fil
 
 void Loader::texture_permanent(AssetID id, RenderTextureWrap wrap, RenderTextureFilter filter)
 {
+	LazyLoadLock lock;
 	texture(id);
 	if (id != AssetNull)
 		textures[id].type = AssetPermanent;
@@ -1038,6 +1085,7 @@ void Loader::framebuffer_free(AssetID id)
 
 void Loader::shader(AssetID id)
 {
+	LazyLoadLock lock;
 	if (id == AssetNull || id >= shader_count)
 		return;
 
@@ -1084,6 +1132,7 @@ void Loader::shader(AssetID id)
 
 void Loader::shader_permanent(AssetID id)
 {
+	LazyLoadLock lock;
 	shader(id);
 	if (id != AssetNull)
 		shaders[id].type = AssetPermanent;
@@ -1107,6 +1156,7 @@ const Font* Loader::font(AssetID id)
 #if SERVER
 	return 0;
 #else
+	LazyLoadLock lock;
 	if (id == AssetNull)
 		return 0;
 
@@ -1165,6 +1215,7 @@ const Font* Loader::font(AssetID id)
 
 const Font* Loader::font_permanent(AssetID id)
 {
+	LazyLoadLock lock;
 	const Font* f = font(id);
 	if (f)
 		fonts[id].type = AssetPermanent;
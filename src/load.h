@@ -46,6 +46,7 @@ struct Loader
 	static s32 armature_count;
 	static s32 animation_count;
 	static LoopSwapper* swapper;
+	static b8 threaded; // set while several threads might lazy load at once (cameras recording in parallel)
 	static void init(LoopSwapper*);
 	static Array<Entry<Mesh> > meshes;
 	static Array<Entry<Animation> > animations;
@@ -19,6 +19,10 @@
 #include "game/team.h"
 #include "game/entities.h"
 #include "net.h"
+#include "console.h"
+#include "task_graph.h"
+#include "render/particles.h"
+#include "render/skinned_model.h"
 
 #if DEBUG
 	#define DEBUG_RENDER 0
@@ -676,12 +680,14 @@ void draw(LoopSync* sync, const Camera* camera)
 						Vec2(r32(shadow_map_size[s32(Settings::shadow_quality)][2]), r32(shadow_map_size[s32(Settings::shadow_quality)][2])),
 					};
 					shadow_camera.orthographic(size, size, 1.0f, depth);
-					far_shadow_cascade_camera = shadow_camera;
+					if (Camera::list.count() == 1) // only reused when there's one camera, and other cameras might be recording right now
+						far_shadow_cascade_camera = shadow_camera;
 					render_shadows(sync, shadow_fbo[2], *render_params.camera, shadow_camera);
+					render_params.shadow_vp = relative_shadow_vp(*render_params.camera, shadow_camera);
 				}
-				draw_far_shadow_cascade = !draw_far_shadow_cascade;
+				else
+					render_params.shadow_vp = relative_shadow_vp(*render_params.camera, far_shadow_cascade_camera);
 
-				render_params.shadow_vp = relative_shadow_vp(*render_params.camera, far_shadow_cascade_camera);
 				if (Settings::volumetric_lighting)
 					render_params.shadow_buffer = shadow_buffer[2]; // skybox needs this for volumetric lighting
 
@@ -1585,6 +1591,66 @@ void draw(LoopSync* sync, const Camera* camera)
 	sync->write(true);
 }
 
+// split screen: every active camera records into its own buffer on the task graph,
+// then the buffers are appended to the frame in camera order
+TaskGraph draw_graph;
+StaticArray<const Camera*, Camera::max_cameras> draw_cameras;
+LoopSync draw_syncs[Camera::max_cameras];
+
+void draw_cameras_record(const Update&, s32 slice, s32 slice_count)
+{
+	for (s32 i = slice; i < draw_cameras.length; i += slice_count)
+		draw(&draw_syncs[i], draw_cameras[i]);
+}
+
+void draw_all(LoopSync* sync)
+{
+	draw_cameras.length = 0;
+	for (auto i = Camera::list.iterator(); !i.is_last(); i.next())
+	{
+		if (i.item()->flag(CameraFlagActive))
+			draw_cameras.add(i.item());
+	}
+
+	// draw() mustn't touch anything shared with other cameras
+	ParticleSystem::upload_all(sync);
+	SkinnedModel::upload_all(sync);
+
+	if (draw_cameras.length == 1)
+		draw(sync, draw_cameras[0]);
+	else if (draw_cameras.length > 1)
+	{
+		for (s32 i = 0; i < draw_cameras.length; i++)
+		{
+			LoopSync* camera_sync = &draw_syncs[i];
+			camera_sync->queue.length = 0;
+			memcpy(&camera_sync->input, &sync->input, sizeof(camera_sync->input)); // UI reads the cursor out of the sync buffer
+		}
+
+		// lazy loads still go to the main buffer, which executes before any of the camera buffers.
+		// transform caches are refreshed up front so the cameras only read them.
+		Loader::threaded = true;
+		Transform::cache_freeze();
+		draw_graph.clear();
+		draw_graph.add(draw_cameras_record, 0, 0, TaskGraph::FlagConcurrent | TaskGraph::FlagSliced);
+		Update u = {};
+		draw_graph.execute(u);
+		Transform::cache_thaw();
+		Loader::threaded = false;
+
+		for (s32 i = 0; i < draw_cameras.length; i++)
+		{
+			const Array<u8>& queue = draw_syncs[i].queue;
+			sync->write(queue.data, queue.length);
+		}
+	}
+
+	draw_far_shadow_cascade = !draw_far_shadow_cascade;
+#if DEBUG
+	UI::debugs.length = 0;
+#endif
+}
+
 void resolution_apply(const DisplayMode& mode)
 {
 	if (mode.width != resolution_current.width || mode.height != resolution_current.height)
@@ -1615,6 +1681,8 @@ void loop(LoopSwapper* swapper_render, PhysicsSwapper* swapper_physics)
 	mersenne::srand(u32(platform::timestamp()));
 	noise::reseed();
 
+	Transform::cache_owner();
+
 	LoopSync* sync_render = swapper_render->swap<SwapType::Write>();
 
 	Loader::init(swapper_render);
@@ -1723,6 +1791,14 @@ void loop(LoopSwapper* swapper_render, PhysicsSwapper* swapper_physics)
 		else
 			sync_physics = swapper_physics->get();
 
+#if !SERVER
+		if (Game::show_render_stats)
+		{
+			const RenderFilterStats& stats = sync_render->render_stats;
+			Console::debug("%d render ops | %d after filter | %dkb | %dkb after filter", stats.ops_in, stats.ops_out, stats.bytes_in / 1024, stats.bytes_out / 1024);
+		}
+#endif
+
 		Game::update(&sync_render->input, &last_input);
 
 		sync_physics->time = Game::time;
@@ -1738,11 +1814,7 @@ void loop(LoopSwapper* swapper_render, PhysicsSwapper* swapper_physics)
 		sync_render->write(true);
 		sync_render->write(true);
 
-		for (auto i = Camera::list.iterator(); !i.is_last(); i.next())
-		{
-			if (i.item()->flag(CameraFlagActive))
-				draw(sync_render, i.item());
-		}
+		draw_all(sync_render);
 #endif
 
 		if (sync_render->quit)
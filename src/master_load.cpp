@@ -0,0 +1,712 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <unordered_map>
+
+#include "types.h"
+#include "vi_assert.h"
+#include "lmath.h"
+#include "data/array.h"
+#include "net_serialize.h"
+#include "platform/sock.h"
+#include "game/master.h"
+#include "game/constants.h"
+#include "next/next.h"
+
+// drives fake game servers and clients against a running master server and reports throughput and latency.
+// servers register and send status updates the way lasercrabsrv does.
+// in "list" mode, clients log in, then keep one server list request in flight at all times, so the master is kept as busy as it can be.
+// in "match" mode, clients log in and ask for a story mode server. servers "load" whatever they're told to,
+// play for LOAD_MATCH_LENGTH seconds, then go back to idle. match latency is the time from the client's request
+// until the master tells a server to expect that client.
+// clients log in with AuthType::Itch, which only works against a dev build of the master (OFFLINE_DEV)
+// with at least one row in its User table.
+// every node has its own socket so the master sees a distinct address for each; large runs need a higher fd limit (ulimit -n).
+
+namespace VI
+{
+
+namespace Net
+{
+
+namespace Master
+{
+
+#define LOAD_REQUEST_TIMEOUT 5.0 // give up on a request after x seconds and send it again
+#define LOAD_MATCH_LENGTH 2.0 // servers go back to idle x seconds after loading
+#define LOAD_HISTOGRAM_BUCKET 0.0001 // seconds
+#define LOAD_HISTOGRAM_BUCKETS 100000 // up to 10 seconds
+
+struct Histogram
+{
+	Array<s32> buckets;
+	s64 count;
+	r64 total;
+	r64 max;
+
+	Histogram()
+		: buckets(), count(), total(), max()
+	{
+		buckets.resize(LOAD_HISTOGRAM_BUCKETS);
+	}
+
+	void add(r64 seconds)
+	{
+		count++;
+		total += seconds;
+		max = vi_max(max, seconds);
+		buckets[vi_min(s32(seconds / LOAD_HISTOGRAM_BUCKET), LOAD_HISTOGRAM_BUCKETS - 1)]++;
+	}
+
+	// upper bound of the bucket the given fraction of samples falls under
+	r64 percentile(r64 fraction) const
+	{
+		s64 target = s64(r64(count) * fraction);
+		s64 sum = 0;
+		for (s32 i = 0; i < buckets.length; i++)
+		{
+			sum += buckets[i];
+			if (sum > target)
+				return vi_min(r64(i + 1) * LOAD_HISTOGRAM_BUCKET, max);
+		}
+		return max;
+	}
+
+	void print(const char* name, r64 duration) const
+	{
+		if (count == 0)
+			printf("%s: none\n", name);
+		else
+		{
+			printf("%s: %lld | %.1f/s | avg %.2fms | p50 %.2fms | p99 %.2fms | max %.2fms\n", name, (long long)count, r64(count) / duration,
+				(total / r64(count)) * 1000.0, percentile(0.5) * 1000.0, percentile(0.99) * 1000.0, max * 1000.0);
+		}
+	}
+};
+
+struct FakeNode
+{
+	Sock::Handle sock;
+	SequenceID outgoing_seq;
+	SequenceID incoming_seq;
+};
+
+struct FakeServer
+{
+	FakeNode node;
+	ServerState state;
+	r64 status_timestamp;
+	r64 load_timestamp;
+};
+
+struct FakeClient
+{
+	enum class State : s8
+	{
+		Authenticating,
+		AuthFailed,
+		RequestingServerList,
+		RequestingServer,
+		Matched,
+		count,
+	};
+
+	FakeNode node;
+	UserKey key;
+	r64 request_timestamp;
+	State state;
+};
+
+struct Stats
+{
+	Histogram auth;
+	Histogram server_list;
+	Histogram match;
+	s64 auth_failed;
+	s64 reauth;
+	s64 timeouts;
+	s64 wrong_version;
+	s64 sent;
+	s64 received;
+};
+
+enum class Mode : s8
+{
+	List,
+	Match,
+	count,
+};
+
+Sock::Address master_addr;
+u64 secret;
+Mode mode;
+Stats stats;
+std::unordered_map<u64, FakeClient*> clients_waiting; // clients waiting for a server, by user key
+
+// outgoing packets for the node being processed; flushed together with udp_send_batch
+StreamWrite outgoing[NET_MAX_DATAGRAM_BATCH];
+s32 outgoing_count;
+
+// receive buffers
+StreamRead incoming[NET_MAX_DATAGRAM_BATCH];
+
+r64 load_time()
+{
+	return r64(std::chrono::high_resolution_clock::now().time_since_epoch().count()) / 1000000000.0;
+}
+
+void node_flush(FakeNode* node)
+{
+	if (outgoing_count > 0)
+	{
+		Sock::Datagram datagrams[NET_MAX_DATAGRAM_BATCH];
+		for (s32 i = 0; i < outgoing_count; i++)
+		{
+			datagrams[i].address = master_addr;
+			datagrams[i].data = outgoing[i].data.data;
+			datagrams[i].size = outgoing[i].bytes_written();
+		}
+		Sock::udp_send_batch(&node->sock, datagrams, outgoing_count);
+		stats.sent += outgoing_count;
+		outgoing_count = 0;
+	}
+}
+
+StreamWrite* packet_alloc(FakeNode* node)
+{
+	if (outgoing_count == NET_MAX_DATAGRAM_BATCH)
+		node_flush(node);
+
+	StreamWrite* p = &outgoing[outgoing_count];
+	outgoing_count++;
+	p->reset();
+	packet_init(p);
+	return p;
+}
+
+// same header Messenger::add_header() writes
+b8 packet_header_write(StreamWrite* p, SequenceID seq, Message type)
+{
+	using Stream = StreamWrite;
+	{
+		s16 version = GAME_VERSION;
+		serialize_s16(p, version);
+	}
+	serialize_int(p, SequenceID, seq, 0, NET_SEQUENCE_COUNT - 1);
+	serialize_enum(p, Message, type);
+	return true;
+}
+
+StreamWrite* packet_add(FakeNode* node, Message type)
+{
+	StreamWrite* p = packet_alloc(node);
+	packet_header_write(p, node->outgoing_seq, type);
+	node->outgoing_seq = sequence_advance(node->outgoing_seq, 1);
+	return p;
+}
+
+// acks reuse the sequence number they're acking
+void packet_ack(FakeNode* node, SequenceID seq)
+{
+	StreamWrite* p = packet_alloc(node);
+	packet_header_write(p, seq, Message::Ack);
+	packet_finalize(p);
+}
+
+b8 server_send_status(FakeServer* server, r64 timestamp)
+{
+	using Stream = StreamWrite;
+	StreamWrite* p = packet_add(&server->node, Message::ServerStatusUpdate);
+	serialize_u64(p, secret);
+	{
+		u8 public_key[NEXT_PUBLIC_KEY_BYTES] = {};
+		serialize_bytes(p, public_key, NEXT_PUBLIC_KEY_BYTES);
+	}
+	if (!serialize_server_state(p, &server->state))
+		net_error();
+	{
+		Sock::Address public_ipv4 = {}; // port 0; the master uses the address the packet came from
+		Sock::Address::serialize(p, &public_ipv4);
+		Sock::Address public_ipv6 = {};
+		public_ipv6.host.type = Sock::Host::Type::IPv6;
+		Sock::Address::serialize(p, &public_ipv6);
+	}
+	packet_finalize(p);
+	server->status_timestamp = timestamp;
+	return true;
+}
+
+b8 client_send_auth(FakeClient* client, r64 timestamp)
+{
+	using Stream = StreamWrite;
+	StreamWrite* p = packet_add(&client->node, Message::Auth);
+	{
+		AuthType auth_type = AuthType::Itch;
+		serialize_enum(p, AuthType, auth_type);
+	}
+	{
+		const char* auth_key = "master_load";
+		s32 auth_key_length = s32(strlen(auth_key));
+		serialize_int(p, s32, auth_key_length, 0, MAX_AUTH_KEY);
+		serialize_bytes(p, (u8*)auth_key, auth_key_length);
+	}
+	{
+		u32 steam_app_id = 0;
+		serialize_u32(p, steam_app_id);
+	}
+	packet_finalize(p);
+	client->state = FakeClient::State::Authenticating;
+	client->request_timestamp = timestamp;
+	return true;
+}
+
+b8 client_send_server_list_request(FakeClient* client, r64 timestamp)
+{
+	using Stream = StreamWrite;
+	StreamWrite* p = packet_add(&client->node, Message::ClientRequestServerList);
+	serialize_u32(p, client->key.id);
+	serialize_u32(p, client->key.token);
+	{
+		Region region = Region::US;
+		serialize_enum(p, Region, region);
+		ServerListType type = ServerListType::Top;
+		serialize_enum(p, ServerListType, type);
+		s32 offset = 0;
+		serialize_s32(p, offset);
+	}
+	packet_finalize(p);
+	client->state = FakeClient::State::RequestingServerList;
+	client->request_timestamp = timestamp;
+	return true;
+}
+
+u64 user_key_hash(const UserKey& key)
+{
+	return (u64(key.id) << 32) | u64(key.token);
+}
+
+b8 client_send_server_request(FakeClient* client, r64 timestamp)
+{
+	using Stream = StreamWrite;
+	StreamWrite* p = packet_add(&client->node, Message::ClientRequestServer);
+	serialize_u32(p, client->key.id);
+	serialize_u32(p, client->key.token);
+	{
+		s32 client_info_length = 0;
+		serialize_int(p, s32, client_info_length, 0, 4096);
+	}
+	{
+		u32 requested_server_id = 0; // story mode
+		serialize_u32(p, requested_server_id);
+		AssetID level = 0; // servers don't actually load anything
+		serialize_s16(p, level);
+		Region region = Region::US;
+		serialize_enum(p, Region, region);
+		StoryModeTeam team = StoryModeTeam::Attack;
+		serialize_enum(p, StoryModeTeam, team);
+	}
+	packet_finalize(p);
+	client->state = FakeClient::State::RequestingServer;
+	client->request_timestamp = timestamp;
+	clients_waiting[user_key_hash(client->key)] = client;
+	return true;
+}
+
+// the master forgets everything about us once we disconnect; the next session logs in from scratch
+void client_send_disconnect(FakeClient* client)
+{
+	StreamWrite* p = packet_add(&client->node, Message::Disconnect);
+	packet_finalize(p);
+	client->node.incoming_seq = NET_SEQUENCE_COUNT - 1;
+}
+
+// reads the header and acks the packet. returns false if the packet should be ignored
+b8 packet_header(FakeNode* node, StreamRead* p, Message* type)
+{
+	using Stream = StreamRead;
+	{
+		s16 version;
+		serialize_s16(p, version);
+		if (version != GAME_VERSION)
+		{
+			stats.wrong_version++;
+			return false;
+		}
+	}
+	SequenceID seq;
+	serialize_int(p, SequenceID, seq, 0, NET_SEQUENCE_COUNT - 1);
+	serialize_enum(p, Message, *type);
+
+	if (*type == Message::Ack || *type == Message::Disconnect)
+		return true;
+
+	packet_ack(node, seq);
+
+	// the master resends anything we don't ack in time; only handle each message once
+	if (!sequence_more_recent(seq, node->incoming_seq))
+		return false;
+	node->incoming_seq = seq;
+	return true;
+}
+
+b8 server_handle(FakeServer* server, StreamRead* p, r64 timestamp)
+{
+	using Stream = StreamRead;
+	Message type;
+	if (!packet_header(&server->node, p, &type))
+		return false;
+
+	switch (type)
+	{
+		case Message::ServerLoad:
+		{
+			ServerConfig config;
+			if (!serialize_server_config(p, &config))
+				net_error();
+			server->state.id = config.id;
+			if (config.id == 0) // story mode
+			{
+				serialize_s16(p, server->state.level);
+				serialize_enum(p, StoryModeTeam, server->state.story_mode_team);
+			}
+			else
+				server->state.level = config.levels[0];
+			server->load_timestamp = timestamp;
+			server_send_status(server, timestamp); // done loading
+			break;
+		}
+		case Message::ExpectClient:
+		{
+			UserKey key;
+			serialize_u32(p, key.id);
+			serialize_u32(p, key.token);
+			auto i = clients_waiting.find(user_key_hash(key));
+			if (i != clients_waiting.end())
+			{
+				FakeClient* client = i->second;
+				stats.match.add(timestamp - client->request_timestamp);
+				client->state = FakeClient::State::Matched;
+				clients_waiting.erase(i);
+			}
+			break;
+		}
+		case Message::WrongVersion:
+		{
+			stats.wrong_version++;
+			break;
+		}
+		default: // everything else just needs an ack
+			break;
+	}
+	return true;
+}
+
+b8 client_handle(FakeClient* client, StreamRead* p, r64 timestamp)
+{
+	using Stream = StreamRead;
+	Message type;
+	if (!packet_header(&client->node, p, &type))
+		return false;
+
+	switch (type)
+	{
+		case Message::AuthResponse:
+		{
+			if (client->state != FakeClient::State::Authenticating)
+				break;
+			b8 success;
+			serialize_bool(p, success);
+			if (success)
+			{
+				serialize_u32(p, client->key.id);
+				serialize_u32(p, client->key.token);
+				stats.auth.add(timestamp - client->request_timestamp);
+				if (mode == Mode::List)
+					client_send_server_list_request(client, timestamp);
+				else
+					client_send_server_request(client, timestamp);
+			}
+			else
+			{
+				// try again after a while
+				stats.auth_failed++;
+				client->state = FakeClient::State::AuthFailed;
+				client->request_timestamp = timestamp;
+			}
+			break;
+		}
+		case Message::ReauthRequired:
+		{
+			stats.reauth++;
+			if (client->state == FakeClient::State::RequestingServer)
+				clients_waiting.erase(user_key_hash(client->key));
+			client_send_auth(client, timestamp);
+			break;
+		}
+		case Message::ServerList:
+		{
+			if (client->state != FakeClient::State::RequestingServerList)
+				break;
+
+			ServerListType list_type;
+			serialize_enum(p, ServerListType, list_type);
+			while (true)
+			{
+				s32 index;
+				serialize_s32(p, index);
+				if (index < 0)
+					break;
+				ServerListEntry entry;
+				if (!serialize_server_list_entry(p, &entry))
+					net_error();
+			}
+			b8 done;
+			serialize_bool(p, done);
+			if (done)
+			{
+				stats.server_list.add(timestamp - client->request_timestamp);
+				client_send_server_list_request(client, timestamp);
+			}
+			break;
+		}
+		case Message::WrongVersion:
+		{
+			stats.wrong_version++;
+			break;
+		}
+		default:
+			break;
+	}
+	return true;
+}
+
+// drains one batch into the receive buffers. returns the number of datagrams received
+s32 node_receive(FakeNode* node)
+{
+	Sock::Datagram datagrams[NET_MAX_DATAGRAM_BATCH];
+	for (s32 i = 0; i < NET_MAX_DATAGRAM_BATCH; i++)
+	{
+		datagrams[i].data = incoming[i].data.data;
+		datagrams[i].size = NET_MAX_PACKET_SIZE;
+	}
+	s32 received = Sock::udp_receive_batch(&node->sock, datagrams, NET_MAX_DATAGRAM_BATCH);
+	for (s32 i = 0; i < received; i++)
+	{
+		StreamRead* packet = &incoming[i];
+		s32 bytes_read = datagrams[i].size;
+		packet->reset();
+		packet->resize_bytes(bytes_read);
+		if (bytes_read > 0 && packet->read_checksum())
+			packet_decompress(packet, bytes_read);
+		else
+			packet->reset(); // ignore
+	}
+	stats.received += received;
+	return received;
+}
+
+s32 server_update(FakeServer* server, r64 timestamp)
+{
+	s32 received = node_receive(&server->node);
+	for (s32 i = 0; i < received; i++)
+	{
+		if (incoming[i].data.length > 0)
+			server_handle(server, &incoming[i], timestamp);
+	}
+
+	if (server->state.level != AssetNull && timestamp - server->load_timestamp > LOAD_MATCH_LENGTH)
+	{
+		// match over
+		server->state.id = 0;
+		server->state.level = AssetNull;
+		server_send_status(server, timestamp);
+	}
+	else if (timestamp - server->status_timestamp > NET_MASTER_STATUS_INTERVAL)
+		server_send_status(server, timestamp);
+
+	node_flush(&server->node);
+	return received;
+}
+
+s32 client_update(FakeClient* client, r64 timestamp)
+{
+	s32 received = node_receive(&client->node);
+	for (s32 i = 0; i < received; i++)
+	{
+		if (incoming[i].data.length > 0)
+			client_handle(client, &incoming[i], timestamp);
+	}
+
+	if (client->state == FakeClient::State::Matched)
+	{
+		// a real client would go play on the server now. start a new session instead
+		client_send_disconnect(client);
+		client_send_auth(client, timestamp);
+	}
+	else if (client->state == FakeClient::State::RequestingServer)
+	{
+		// no timeout; waiting for a free server can take a while
+	}
+	else if (timestamp - client->request_timestamp > LOAD_REQUEST_TIMEOUT)
+	{
+		// lost, or the master is too far behind. start over
+		if (client->state == FakeClient::State::AuthFailed)
+			client_send_auth(client, timestamp);
+		else
+		{
+			stats.timeouts++;
+			if (client->state == FakeClient::State::RequestingServerList)
+				client_send_server_list_request(client, timestamp);
+			else
+				client_send_auth(client, timestamp);
+		}
+	}
+
+	node_flush(&client->node);
+	return received;
+}
+
+b8 node_open(FakeNode* node)
+{
+	node->outgoing_seq = 0;
+	node->incoming_seq = NET_SEQUENCE_COUNT - 1;
+	if (Sock::udp_open(&node->sock))
+	{
+		fprintf(stderr, "%s\n", Sock::get_error());
+		return false;
+	}
+	return true;
+}
+
+s32 usage()
+{
+	fprintf(stderr, "%s", "Usage: master_load list|match [clients] [servers] [seconds] [secret] [host]\n");
+	return 1;
+}
+
+s32 proc(s32 argc, char* argv[])
+{
+	s32 client_count = 256;
+	s32 server_count = 32;
+	r64 duration = 30.0;
+	const char* host = "127.0.0.1";
+	if (argc < 2 || argc > 7)
+		return usage();
+	if (strcmp(argv[1], "list") == 0)
+		mode = Mode::List;
+	else if (strcmp(argv[1], "match") == 0)
+		mode = Mode::Match;
+	else
+		return usage();
+	if (argc > 2)
+		client_count = atoi(argv[2]);
+	if (argc > 3)
+		server_count = atoi(argv[3]);
+	if (argc > 4)
+		duration = atof(argv[4]);
+	if (argc > 5)
+		secret = strtoull(argv[5], nullptr, 10);
+	if (argc > 6)
+		host = argv[6];
+	if (client_count < 0 || server_count < 0 || duration <= 0.0)
+		return usage();
+
+	Sock::init();
+
+	if (Sock::Address::get(&master_addr, host, NET_MASTER_PORT))
+	{
+		fprintf(stderr, "%s\n", Sock::get_error());
+		return 1;
+	}
+
+	Array<FakeServer> servers;
+	servers.resize(server_count);
+	for (s32 i = 0; i < servers.length; i++)
+	{
+		FakeServer* server = &servers[i];
+		if (!node_open(&server->node))
+			return 1;
+		server->state.level = AssetNull;
+		server->state.player_slots = MAX_PLAYERS;
+		server->state.max_players = MAX_PLAYERS;
+		server->state.region = Region::US;
+	}
+
+	Array<FakeClient> clients;
+	clients.resize(client_count);
+	for (s32 i = 0; i < clients.length; i++)
+	{
+		if (!node_open(&clients[i].node))
+			return 1;
+	}
+
+	r64 start = load_time();
+
+	for (s32 i = 0; i < servers.length; i++)
+	{
+		FakeServer* server = &servers[i];
+		server_send_status(server, start);
+		node_flush(&server->node);
+	}
+
+	for (s32 i = 0; i < clients.length; i++)
+	{
+		FakeClient* client = &clients[i];
+		client_send_auth(client, start);
+		node_flush(&client->node);
+	}
+
+	// single thread, polling every socket in turn. the time a sweep takes bounds how precise the latencies are
+	s64 sweeps = 0;
+	r64 timestamp = start;
+	while (timestamp - start < duration)
+	{
+		for (s32 i = 0; i < servers.length; i++)
+			server_update(&servers[i], timestamp);
+		for (s32 i = 0; i < clients.length; i++)
+			client_update(&clients[i], load_time());
+		sweeps++;
+		timestamp = load_time();
+	}
+
+	r64 elapsed = timestamp - start;
+	printf("%d clients | %d servers | %.1fs | %.3fms per sweep\n", clients.length, servers.length, elapsed, (elapsed / r64(sweeps)) * 1000.0);
+	printf("packets: %lld sent | %lld received\n", (long long)stats.sent, (long long)stats.received);
+	stats.auth.print("auth", elapsed);
+	if (mode == Mode::List)
+		stats.server_list.print("server list", elapsed);
+	else
+	{
+		stats.match.print("match", elapsed);
+		printf("still waiting for a server: %d\n", s32(clients_waiting.size()));
+	}
+	printf("auth failed: %lld | reauth required: %lld | timeouts: %lld | wrong version: %lld\n",
+		(long long)stats.auth_failed, (long long)stats.reauth, (long long)stats.timeouts, (long long)stats.wrong_version);
+
+	for (s32 i = 0; i < clients.length; i++)
+		Sock::close(&clients[i].node.sock);
+	for (s32 i = 0; i < servers.length; i++)
+		Sock::close(&servers[i].node.sock);
+
+	Sock::netshutdown();
+
+	if (stats.auth.count == 0 && clients.length > 0)
+	{
+		fprintf(stderr, "%s\n", "Error: no client managed to log in. The master must be a dev build with at least one user in its database.");
+		return 1;
+	}
+
+	return 0;
+}
+
+}
+
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	return VI::Net::Master::proc(argc, argv);
+}
@@ -148,6 +148,13 @@ struct StateHistory
 {
 	StaticArray<StateFrame, NET_HISTORY_SIZE> frames;
 	s32 current_index;
+
+	~StateHistory()
+	{
+		// StaticArray doesn't destruct its elements; free the transform buffers
+		for (s32 i = 0; i < frames.length; i++)
+			frames[i].~StateFrame();
+	}
 };
 
 struct Ack
@@ -213,6 +220,8 @@ struct PacketEntry
 Array<PacketEntry> lag_buffer;
 #endif
 
+StaticArray<PacketEntry, NET_MAX_DATAGRAM_BATCH> master_packets; // receive buffers for the master socket
+
 void packet_received(PacketEntry*);
 
 r32 internal_interpolation_delay(b8 low_latency)
@@ -617,8 +626,8 @@ template<typename Stream> b8 serialize_entity(Stream* p, Entity* e)
 	if (e->has<Health>())
 	{
 		Health* h = e->get<Health>();
-		serialize_r32_range(p, h->active_armor_timer, 0, 5, 8);
-		serialize_r32_range(p, h->regen_timer, 0, 10, 8);
+		serialize_r32_range(p, h->active_armor_timer(), 0, 5, 8);
+		serialize_r32_range(p, h->regen_timer(), 0, 10, 8);
 		serialize_s8(p, h->shield);
 		serialize_s8(p, h->shield_max);
 		serialize_s8(p, h->hp);
@@ -751,9 +760,9 @@ template<typename Stream> b8 serialize_entity(Stream* p, Entity* e)
 		serialize_s8(p, x->team);
 		serialize_ref(p, x->owner);
 		serialize_ref(p, x->player);
-		serialize_r32(p, x->velocity.x);
-		serialize_r32(p, x->velocity.y);
-		serialize_r32(p, x->velocity.z);
+		serialize_r32(p, x->velocity().x);
+		serialize_r32(p, x->velocity().y);
+		serialize_r32(p, x->velocity().z);
 		serialize_enum(p, Bolt::Type, x->type);
 		serialize_bool(p, x->reflected);
 	}
@@ -1628,45 +1637,52 @@ b8 equal_states_transform(const TransformState& a, const TransformState& b)
 	if (a.resolution == Resolution::High || b.resolution == Resolution::High)
 		tolerance_pos = 0.001f;
 
-	if (a.revision == b.revision
+	// quaternion angle is by far the most expensive test; do it last
+	return a.revision == b.revision
 		&& a.resolution == b.resolution
 		&& a.parent.equals(b.parent)
-		&& equal_states_quat(a, b))
-	{
-		return s32(a.pos.x / tolerance_pos) == s32(b.pos.x / tolerance_pos)
-			&& s32(a.pos.y / tolerance_pos) == s32(b.pos.y / tolerance_pos)
-			&& s32(a.pos.z / tolerance_pos) == s32(b.pos.z / tolerance_pos);
-	}
-
-	return false;
+		&& s32(a.pos.x / tolerance_pos) == s32(b.pos.x / tolerance_pos)
+		&& s32(a.pos.y / tolerance_pos) == s32(b.pos.y / tolerance_pos)
+		&& s32(a.pos.z / tolerance_pos) == s32(b.pos.z / tolerance_pos)
+		&& equal_states_quat(a, b);
 }
 
-b8 equal_states_transform(const StateFrame* a, const StateFrame* b, s32 index)
+// sets a bit for every transform that differs between the two frames.
+// a transform inactive in both frames is unchanged, and with no base every inactive transform is already inactive on the other end.
+// walks both packed transform arrays in lockstep, one bitmask word at a time, so there are no per-index lookups
+void state_frame_changed_transforms(const StateFrame& frame, const StateFrame* base, Bitmask<MAX_ENTITIES>* changed)
 {
-	if (a && b)
+	if (!base)
 	{
-		b8 a_active = a->transforms_active.get(index);
-		b8 b_active = b->transforms_active.get(index);
-		if (a_active == b_active)
-		{
-			if (a_active && b_active)
-				return equal_states_transform(a->transforms[index], b->transforms[index]);
-			else if (!a_active && !b_active)
-				return true;
-		}
+		*changed = frame.transforms_active;
+		return;
 	}
-	return false;
-}
 
-b8 equal_states_walker(const StateFrame* frame_a, const StateFrame* frame_b, s32 index)
-{
-	if (frame_a && frame_b)
+	changed->clear();
+	s32 start = vi_min(s32(frame.transforms_active.start), s32(base->transforms_active.start));
+	s32 end = vi_max(s32(frame.transforms_active.end), s32(base->transforms_active.end));
+	if (start >= end)
+		return;
+
+	s32 frame_packed = 0;
+	s32 base_packed = 0;
+	for (s32 word = start / 32; word < ((end - 1) / 32) + 1; word++)
 	{
-		b8 a_active = frame_a->walkers_active.get(index);
-		b8 b_active = frame_b->walkers_active.get(index);
-		return !a_active && !b_active;
+		u32 a = frame.transforms_active.data[word];
+		u32 b = base->transforms_active.data[word];
+		u32 bits = a | b;
+		while (bits)
+		{
+			u32 bit = bits & (0 - bits); // lowest set bit
+			if (!(a & bit) || !(b & bit) || !equal_states_transform(frame.transforms[frame_packed], base->transforms[base_packed]))
+				changed->set(word * 32 + BitUtility::ctz(bit), true);
+			if (a & bit)
+				frame_packed++;
+			if (b & bit)
+				base_packed++;
+			bits &= bits - 1;
+		}
 	}
-	return false;
 }
 
 b8 equal_states_drone(const StateFrame* frame_a, const StateFrame* frame_b, s32 index)
@@ -1698,14 +1714,136 @@ b8 equal_states_parkour(const StateFrame* frame_a, const StateFrame* frame_b, s3
 	return false;
 }
 
+// lag compensation builds StateFrames on the stack all the time. instead of allocating and freeing a transform buffer
+// for each one, every thread keeps a few spare buffers around.
+// plain data, so frames destroyed during static destruction can still return theirs. threads live as long as the process
+#define STATE_FRAME_SPARE_BUFFERS 4
+struct StateFrameSpares
+{
+	TransformState* data[STATE_FRAME_SPARE_BUFFERS];
+	s32 reserved[STATE_FRAME_SPARE_BUFFERS];
+	s32 count;
+};
+
+thread_local StateFrameSpares state_frame_spares;
+
+void state_frame_spare_take(Array<TransformState>* transforms)
+{
+	StateFrameSpares* spares = &state_frame_spares;
+	if (spares->count > 0)
+	{
+		spares->count--;
+		transforms->data = spares->data[spares->count];
+		transforms->reserved = spares->reserved[spares->count];
+	}
+}
+
+StateFrame::StateFrame()
+	: transforms()
+{
+	state_frame_spare_take(&transforms);
+	reset();
+}
+
+StateFrame::StateFrame(const StateFrame& other)
+	: transforms()
+{
+	state_frame_spare_take(&transforms);
+	*this = other;
+}
+
+StateFrame::~StateFrame()
+{
+	StateFrameSpares* spares = &state_frame_spares;
+	if (transforms.data && spares->count < STATE_FRAME_SPARE_BUFFERS)
+	{
+		spares->data[spares->count] = transforms.data;
+		spares->reserved[spares->count] = transforms.reserved;
+		spares->count++;
+		transforms.data = nullptr; // so the Array destructor doesn't free it
+		transforms.reserved = 0;
+		transforms.length = 0;
+	}
+}
+
+// copies everything except transforms
+void state_frame_copy_untracked(StateFrame* frame, const StateFrame& other)
+{
+	memcpy(frame->players, other.players, sizeof(frame->players));
+	memcpy(frame->walkers, other.walkers, sizeof(frame->walkers));
+	memcpy(frame->drones, other.drones, sizeof(frame->drones));
+	memcpy(frame->parkours, other.parkours, sizeof(frame->parkours));
+	frame->timestamp = other.timestamp;
+	frame->walkers_active = other.walkers_active;
+	frame->sequence_id = other.sequence_id;
+}
+
+StateFrame& StateFrame::operator=(const StateFrame& other)
+{
+	if (this != &other)
+	{
+		state_frame_copy_untracked(this, other);
+		transforms.resize(other.transforms.length);
+		memcpy(transforms.data, other.transforms.data, sizeof(TransformState) * other.transforms.length);
+		transforms_active = other.transforms_active;
+		memcpy(transforms_word_offset, other.transforms_word_offset, sizeof(transforms_word_offset));
+	}
+	return *this;
+}
+
+TransformState* StateFrame::transform_add(s32 index)
+{
+	vi_assert(index >= transforms_active.end);
+	s32 word = index / 32;
+	if (transforms.length == 0 || word != (transforms_active.end - 1) / 32)
+		transforms_word_offset[word] = s16(transforms.length); // first active transform in this word
+	transforms_active.set(index, true);
+	TransformState* transform = transforms.add();
+	memset(transform, 0, sizeof(*transform));
+	return transform;
+}
+
+void StateFrame::transforms_clear()
+{
+	transforms.length = 0;
+	transforms_active.clear();
+}
+
+void StateFrame::reset()
+{
+	transforms_clear();
+	memset(players, 0, sizeof(players));
+	memset(walkers, 0, sizeof(walkers));
+	memset(drones, 0, sizeof(drones));
+	memset(parkours, 0, sizeof(parkours));
+	timestamp = 0.0f;
+	walkers_active.clear();
+	sequence_id = 0;
+}
+
+// copies every transform active in the base frame, starting at *base_index and stopping before the given index
+void state_frame_transforms_carry(StateFrame* frame, const StateFrame* base, s32* base_index, s32 index)
+{
+	if (base)
+	{
+		while (*base_index < index && *base_index < base->transforms_active.end)
+		{
+			*frame->transform_add(*base_index) = *base->transform(*base_index);
+			*base_index = base->transforms_active.next(*base_index);
+		}
+	}
+}
+
 template<typename Stream> b8 serialize_state_frame(Stream* p, StateFrame* frame, const StateFrame* base)
 {
 	if (Stream::IsReading)
 	{
+		// transforms are merged from the base below
 		if (base)
-			memcpy(frame, base, sizeof(*frame));
+			state_frame_copy_untracked(frame, *base);
 		else
-			new (frame) StateFrame();
+			frame->reset();
+		frame->transforms_clear();
 		frame->timestamp = state_common.timestamp;
 	}
 
@@ -1714,61 +1852,71 @@ template<typename Stream> b8 serialize_state_frame(Stream* p, StateFrame* frame,
 	// transforms
 	{
 		s32 changed_count;
+		ID changed[MAX_ENTITIES];
 		if (Stream::IsWriting)
 		{
-			// count changed transforms
-			changed_count = 0;
-			s32 index = vi_min(s32(frame->transforms_active.start), base ? s32(base->transforms_active.start) : MAX_ENTITIES - 1);
-			while (index < vi_max(s32(frame->transforms_active.end), base ? s32(base->transforms_active.end) : 0))
-			{
-				if (!equal_states_transform(frame, base, index))
-					changed_count++;
-				index++;
-			}
+			Bitmask<MAX_ENTITIES> changed_mask;
+			state_frame_changed_transforms(*frame, base, &changed_mask);
+			changed_count = changed_mask.indices(changed);
 		}
 		serialize_int(p, s32, changed_count, 0, MAX_ENTITIES);
 
-		s32 index;
-		if (Stream::IsWriting)
-			index = vi_min(s32(frame->transforms_active.start), base ? s32(base->transforms_active.start) : MAX_ENTITIES - 1);
+		s32 base_index = base ? base->transforms_active.start : MAX_ENTITIES; // reading: next base transform to carry over
 		for (s32 i = 0; i < changed_count; i++)
 		{
+			s32 index;
 			if (Stream::IsWriting)
+				index = changed[i];
+
+			serialize_int(p, s32, index, 0, MAX_ENTITIES - 1);
+
+			if (Stream::IsReading)
 			{
-				while (equal_states_transform(frame, base, index))
-					index++;
+				// changed transforms arrive in ascending order; everything in between is the same as the base
+				if (index < frame->transforms_active.end)
+					net_error();
+				state_frame_transforms_carry(frame, base, &base_index, index);
+				if (base_index == index)
+					base_index = base->transforms_active.next(base_index);
 			}
 
-			serialize_int(p, s32, index, 0, MAX_ENTITIES - 1);
+			const TransformState* base_transform = base ? base->transform(index) : nullptr;
 
 			b8 active;
 			if (Stream::IsWriting)
 				active = frame->transforms_active.get(index);
 			serialize_bool(p, active);
-			if (Stream::IsReading)
-				frame->transforms_active.set(index, active);
 
 			if (active)
 			{
+				TransformState* transform;
+				if (Stream::IsWriting)
+					transform = frame->transform(index);
+				else
+				{
+					transform = frame->transform_add(index);
+					if (base_transform)
+						*transform = *base_transform;
+				}
+
 				b8 revision_changed;
 				if (Stream::IsWriting)
-					revision_changed = !base || frame->transforms[index].revision != base->transforms[index].revision;
+					revision_changed = !base_transform || transform->revision != base_transform->revision;
 				serialize_bool(p, revision_changed);
 				if (revision_changed)
-					serialize_s16(p, frame->transforms[index].revision);
+					serialize_s16(p, transform->revision);
 				b8 parent_changed;
 				if (Stream::IsWriting)
-					parent_changed = revision_changed || !base || !frame->transforms[index].parent.equals(base->transforms[index].parent);
+					parent_changed = revision_changed || !transform->parent.equals(base_transform->parent);
 				serialize_bool(p, parent_changed);
 				if (parent_changed)
-					serialize_ref(p, frame->transforms[index].parent);
-				if (!serialize_transform(p, &frame->transforms[index], (base && !revision_changed) ? &base->transforms[index] : nullptr))
+					serialize_ref(p, transform->parent);
+				if (!serialize_transform(p, transform, revision_changed ? nullptr : base_transform))
 					net_error();
 			}
-
-			if (Stream::IsWriting)
-				index++;
 		}
+		if (Stream::IsReading)
+			state_frame_transforms_carry(frame, base, &base_index, MAX_ENTITIES);
 #if DEBUG_TRANSFORMS
 		vi_debug("Wrote %d transforms", changed_count);
 #endif
@@ -1791,32 +1939,23 @@ template<typename Stream> b8 serialize_state_frame(Stream* p, StateFrame* frame,
 
 	// walkers
 	{
+		// walkers are always sent while active, so anything active in either frame has changed
+		Bitmask<MAX_MINIONS * 2> changed;
 		s32 changed_count;
 		if (Stream::IsWriting)
 		{
-			// count changed walkers
-			changed_count = 0;
-			s32 index = vi_min(s32(frame->walkers_active.start), base ? s32(base->walkers_active.start) : MAX_MINIONS - 1);
-			while (index < vi_max(s32(frame->walkers_active.end), base ? s32(base->walkers_active.end) : 0))
-			{
-				if (!equal_states_walker(frame, base, index))
-					changed_count++;
-				index++;
-			}
+			changed = frame->walkers_active;
+			if (base)
+				changed.add(base->walkers_active);
+			changed_count = changed.count();
 		}
 		serialize_int(p, s32, changed_count, 0, MAX_MINIONS);
 
 		s32 index;
 		if (Stream::IsWriting)
-			index = vi_min(s32(frame->walkers_active.start), base ? s32(base->walkers_active.start) : MAX_MINIONS - 1);
+			index = changed.start;
 		for (s32 i = 0; i < changed_count; i++)
 		{
-			if (Stream::IsWriting)
-			{
-				while (equal_states_walker(frame, base, index))
-					index++;
-			}
-
 			serialize_int(p, s32, index, 0, MAX_MINIONS - 1);
 			b8 active;
 			if (Stream::IsWriting)
@@ -1829,7 +1968,8 @@ template<typename Stream> b8 serialize_state_frame(Stream* p, StateFrame* frame,
 				if (!serialize_walker(p, &frame->walkers[index], base ? &base->walkers[index] : nullptr))
 					net_error();
 			}
-			index++;
+			if (Stream::IsWriting)
+				index = changed.next(index);
 		}
 	}
 
@@ -1886,8 +2026,7 @@ void state_frame_build(StateFrame* frame)
 	{
 		if (Game::net_transform_filter(i.item()->entity(), Game::level.mode))
 		{
-			frame->transforms_active.set(i.index, true);
-			TransformState* transform = &frame->transforms[i.index];
+			TransformState* transform = frame->transform_add(i.index);
 			transform->revision = i.item()->revision;
 			transform->pos = i.item()->pos;
 			transform->rot = i.item()->rot;
@@ -1966,18 +2105,18 @@ void transform_absolute(const StateFrame& frame, s32 index, Vec3* abs_pos, Quat*
 	if (local_offset)
 	{
 		vi_assert(index >= 0 && index < MAX_ENTITIES);
-		*local_offset = frame.transforms[index].target_local_offset;
+		const TransformState* transform = frame.transform(index);
+		*local_offset = transform ? transform->target_local_offset : Vec3::zero;
 	}
 	while (index != IDNull)
 	{ 
-		if (frame.transforms_active.get(index))
+		if (const TransformState* transform = frame.transform(index))
 		{
 			// this transform is being tracked with the dynamic transform system
-			const TransformState& transform = frame.transforms[index];
 			if (abs_rot)
-				*abs_rot = transform.rot * *abs_rot;
-			*abs_pos = (transform.rot * *abs_pos) + transform.pos;
-			index = transform.parent.id;
+				*abs_rot = transform->rot * *abs_rot;
+			*abs_pos = (transform->rot * *abs_pos) + transform->pos;
+			index = transform->parent.id;
 		}
 		else
 		{
@@ -2036,19 +2175,22 @@ void state_frame_interpolate(const StateFrame& a, const StateFrame& b, StateFram
 
 	// transforms
 	{
-		result->transforms_active = b.transforms_active;
+		result->transforms_clear();
 		s32 index = s32(b.transforms_active.start);
+		s32 packed_index = 0;
 		while (index < b.transforms_active.end)
 		{
-			TransformState* transform = &result->transforms[index];
-			const TransformState& last = a.transforms[index];
-			const TransformState& next = b.transforms[index];
+			TransformState* transform = result->transform_add(index);
+			const TransformState* last_ptr = a.transform(index);
+			const TransformState& next = b.transforms[packed_index];
 
 			transform->parent = next.parent;
 			transform->revision = next.revision;
+			transform->resolution = next.resolution;
 
-			if (last.revision == next.revision)
+			if (last_ptr && last_ptr->revision == next.revision)
 			{
+				const TransformState& last = *last_ptr;
 				if (last.parent.id == next.parent.id)
 				{
 					transform->pos = Vec3::lerp(blend, last.pos, next.pos);
@@ -2076,6 +2218,7 @@ void state_frame_interpolate(const StateFrame& a, const StateFrame& b, StateFram
 				transform->target_local_offset = next.target_local_offset;
 			}
 			index = b.transforms_active.next(index);
+			packed_index++;
 		}
 	}
 
@@ -2184,7 +2327,7 @@ StateFrame* state_frame_add(StateHistory* history)
 		history->current_index = (history->current_index + 1) % history->frames.capacity();
 		frame = &history->frames[history->current_index];
 	}
-	new (frame) StateFrame();
+	frame->reset(); // keeps the transform buffer we allocated last time around
 	frame->timestamp = state_common.timestamp;
 	return frame;
 }
@@ -2368,10 +2511,23 @@ struct ExpectedClient
 
 b8 msg_process(StreamRead*, Client*, SequenceID);
 
+// serialized state frame delta against one base, for the current frame.
+// every client that acked the same base gets exactly the same bits, so each delta is only serialized once per tick
+struct StateFrameDelta
+{
+	StreamWrite stream;
+	const StateFrame* source;
+	SequenceID frame;
+	SequenceID base;
+};
+
 struct StateServer
 {
 	FILE* replay_file;
 	StaticArray<Client, MAX_PLAYERS> clients;
+	StaticArray<StateFrameDelta, MAX_PLAYERS> state_frame_deltas;
+	s32 state_frame_delta_hits;
+	s32 state_frame_delta_misses;
 	Array<Ref<Entity>> finalize_children_queue;
 	Array<ExpectedClient> expected_clients;
 	Mode mode;
@@ -2631,6 +2787,39 @@ b8 packet_build_disconnect(StreamWrite* p, DisconnectReason reason)
 	return true;
 }
 
+// returns the serialized delta from the given base to the given frame, serializing it if no other client needed it yet this tick
+const StateFrameDelta* state_frame_delta(StateFrame* frame, SequenceID base_sequence)
+{
+	// the cache is cleared every tick. sequence IDs wrap and history slots get reused, so check everything anyway
+	for (s32 i = 0; i < state_server.state_frame_deltas.length; i++)
+	{
+		const StateFrameDelta& delta = state_server.state_frame_deltas[i];
+		if (delta.source == frame && delta.frame == frame->sequence_id && delta.base == base_sequence)
+		{
+			state_server.state_frame_delta_hits++;
+			return &delta;
+		}
+	}
+
+	state_server.state_frame_delta_misses++;
+
+	if (state_server.state_frame_deltas.length == state_server.state_frame_deltas.capacity())
+		state_server.state_frame_deltas.length = 0;
+
+	StateFrameDelta* delta = state_server.state_frame_deltas.add();
+	delta->source = frame;
+	delta->frame = frame->sequence_id;
+	delta->base = base_sequence;
+	delta->stream.reset();
+	const StateFrame* base = state_frame_by_sequence(state_common.state_history, base_sequence);
+	if (!serialize_state_frame(&delta->stream, frame, base))
+	{
+		state_server.state_frame_deltas.length--;
+		return nullptr;
+	}
+	return delta;
+}
+
 b8 packet_build_update(StreamWrite* p, Client* client, StateFrame* frame)
 {
 	packet_init(p);
@@ -2683,9 +2872,10 @@ b8 packet_build_update(StreamWrite* p, Client* client, StateFrame* frame)
 			client->msgs_out_load_history.msg_frames.length = 0; // it's been long enough, we can stop worrying about this. all frames should have state frames by now
 
 		serialize_int(p, SequenceID, client->acked_state_frame, 0, NET_SEQUENCE_COUNT); // not NET_SEQUENCE_COUNT - 1, because base_sequence_id might be NET_SEQUENCE_INVALID
-		const StateFrame* base = state_frame_by_sequence(state_common.state_history, client->acked_state_frame);
-		if (!serialize_state_frame(p, frame, base))
+		const StateFrameDelta* delta = state_frame_delta(frame, client->acked_state_frame);
+		if (!delta || p->would_overflow(delta->stream.bits_written()))
 			net_error();
+		p->append(delta->stream);
 	}
 
 	packet_finalize(p);
@@ -2815,6 +3005,7 @@ void tick(const Update& u, r32 dt)
 	}
 	frame = state_frame_add(&state_common.state_history);
 	state_frame_build(frame);
+	state_server.state_frame_deltas.length = 0; // new frame; every cached delta is stale
 
 	StreamWrite p;
 	for (s32 i = 0; i < state_server.clients.length; i++)
@@ -3912,10 +4103,11 @@ void state_frame_apply(const StateFrame& frame, const StateFrame& frame_last, co
 	// transforms
 	{
 		s32 index = frame.transforms_active.start;
+		s32 packed_index = 0;
 		while (index < frame.transforms_active.end)
 		{
 			Transform* t = &Transform::list[index];
-			const TransformState& s = frame.transforms[index];
+			const TransformState& s = frame.transforms[packed_index];
 			if (Transform::list.active(index) && t->revision == s.revision
 				&& (!t->has<PlayerControlHuman>() || !t->get<PlayerControlHuman>()->local())) // don't immediately overwrite local player positions with the server's data
 			{
@@ -3972,12 +4164,13 @@ void state_frame_apply(const StateFrame& frame, const StateFrame& frame_last, co
 						transform_absolute(frame_last, index, &abs_pos_last);
 						Vec3 abs_pos_next;
 						transform_absolute(*frame_next, index, &abs_pos_next);
-						t->get<Bolt>()->velocity = (abs_pos_next - abs_pos_last) / tick_rate();
+						t->get<Bolt>()->velocity() = (abs_pos_next - abs_pos_last) / tick_rate();
 					}
 				}
 			}
 
 			index = frame.transforms_active.next(index);
+			packed_index++;
 		}
 	}
 
@@ -4663,19 +4856,19 @@ b8 packet_handle(StreamRead* p, const Sock::Address& address)
 				// only insert the frame into the history if it is more recent
 				if (state_common.state_history.frames.length == 0 || sequence_more_recent(frame.sequence_id, state_common.state_history.frames[state_common.state_history.current_index].sequence_id))
 				{
-					memcpy(state_frame_add(&state_common.state_history), &frame, sizeof(StateFrame));
+					*state_frame_add(&state_common.state_history) = frame;
 
 					// let players know where the server thinks they are immediately, with no interpolation
 					for (auto i = PlayerControlHuman::list.iterator(); !i.is_last(); i.next())
 					{
 						Transform* t = i.item()->get<Transform>();
-						const TransformState& transform_state = frame.transforms[t->id()];
-						if (transform_state.revision == t->revision)
+						const TransformState* transform_state = frame.transform(t->id());
+						if (transform_state && transform_state->revision == t->revision)
 						{
 							PlayerControlHuman::RemoteControl* control = &i.item()->remote_control;
-							control->parent = transform_state.parent;
-							control->pos = transform_state.pos;
-							control->rot = transform_state.rot;
+							control->parent = transform_state->parent;
+							control->pos = transform_state->pos;
+							control->rot = transform_state->rot;
 						}
 					}
 				}
@@ -4995,12 +5188,24 @@ void update_start(const Update& u)
 
 	while (true)
 	{
-		PacketEntry entry(state_common.timestamp);
-		s32 bytes_received = Sock::udp_receive(&state_persistent.master_sock, &entry.address, entry.packet.data.data, NET_MAX_PACKET_SIZE);
-		entry.packet.resize_bytes(bytes_received);
-		if (bytes_received > 0)
-			packet_received(&entry);
-		else
+		Sock::Datagram datagrams[NET_MAX_DATAGRAM_BATCH];
+		master_packets.length = NET_MAX_DATAGRAM_BATCH;
+		for (s32 i = 0; i < NET_MAX_DATAGRAM_BATCH; i++)
+		{
+			datagrams[i].data = master_packets[i].packet.data.data;
+			datagrams[i].size = NET_MAX_PACKET_SIZE;
+		}
+		s32 received = Sock::udp_receive_batch(&state_persistent.master_sock, datagrams, NET_MAX_DATAGRAM_BATCH);
+		for (s32 i = 0; i < received; i++)
+		{
+			PacketEntry* entry = &master_packets[i];
+			entry->timestamp = state_common.timestamp;
+			entry->address = datagrams[i].address;
+			entry->packet.reset();
+			entry->packet.resize_bytes(datagrams[i].size);
+			packet_received(entry);
+		}
+		if (received < NET_MAX_DATAGRAM_BATCH)
 			break;
 	}
 
@@ -5037,6 +5242,15 @@ void update_start(const Update& u)
 		state_common.bandwidth_out = state_common.bandwidth_out_counter;
 		state_common.bandwidth_in_counter = 0;
 		state_common.bandwidth_out_counter = 0;
+#if SERVER
+		if (show_stats)
+		{
+			s32 total = Server::state_server.state_frame_delta_hits + Server::state_server.state_frame_delta_misses;
+			vi_debug("%.0fkbps down | %.0fkbps up | %d%% state frame delta reuse (%d/%d)", state_common.bandwidth_in * 8.0f / 500.0f, state_common.bandwidth_out * 8.0f / 500.0f, total > 0 ? (Server::state_server.state_frame_delta_hits * 100) / total : 0, Server::state_server.state_frame_delta_hits, total);
+		}
+		Server::state_server.state_frame_delta_hits = 0;
+		Server::state_server.state_frame_delta_misses = 0;
+#endif
 	}
 }
 
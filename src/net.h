@@ -102,9 +102,11 @@ struct ParkourStateFrame
 	b8 active;
 };
 
+// transforms are stored packed: one TransformState per set bit in transforms_active, in index order.
+// only a few hundred of the MAX_ENTITIES slots are ever active, and we keep NET_HISTORY_SIZE of these around.
 struct StateFrame
 {
-	TransformState transforms[MAX_ENTITIES];
+	Array<TransformState> transforms;
 	PlayerManagerState players[MAX_PLAYERS];
 	WalkerState walkers[MAX_MINIONS * 2];
 	DroneState drones[MAX_PLAYERS];
@@ -112,7 +114,32 @@ struct StateFrame
 	r32 timestamp;
 	Bitmask<MAX_ENTITIES> transforms_active;
 	Bitmask<MAX_MINIONS * 2> walkers_active;
+	s16 transforms_word_offset[(MAX_ENTITIES + 31) / 32]; // index in transforms of the first active transform in each word of transforms_active
 	SequenceID sequence_id;
+
+	StateFrame();
+	StateFrame(const StateFrame&);
+	~StateFrame();
+	StateFrame& operator=(const StateFrame&);
+
+	// returns null if the transform is not active in this frame
+	inline const TransformState* transform(s32 index) const
+	{
+		if (!transforms_active.get(index))
+			return nullptr;
+		s32 word = index / 32;
+		u32 below = transforms_active.data[word] & ((1u << (index - word * 32)) - 1);
+		return &transforms[transforms_word_offset[word] + BitUtility::popcount(below)];
+	}
+
+	inline TransformState* transform(s32 index)
+	{
+		return const_cast<TransformState*>(static_cast<const StateFrame*>(this)->transform(index));
+	}
+
+	TransformState* transform_add(s32); // index must be higher than every transform already active
+	void transforms_clear();
+	void reset();
 };
 
 void init();
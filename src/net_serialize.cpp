@@ -1,6 +1,10 @@
 #include "net_serialize.h"
 #include <cstdio>
 #include "assimp/contrib/zlib/zlib.h"
+#include "fastlz/fastlz.h"
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
 
 namespace VI
 {
@@ -46,11 +50,71 @@ static const u32 crc32_table[256] =
 	0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94, 0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d 
 };
 
+// slice-by-8 tables. slice[k][b] is the crc of byte b followed by k zero bytes
+struct Crc32Slices
+{
+	u32 slice[8][256];
+
+	Crc32Slices()
+	{
+		memcpy(slice[0], crc32_table, sizeof(crc32_table));
+		for (s32 k = 1; k < 8; k++)
+		{
+			for (s32 i = 0; i < 256; i++)
+				slice[k][i] = (slice[k - 1][i] >> 8) ^ crc32_table[slice[k - 1][i] & 0xFF];
+		}
+	}
+};
+static const Crc32Slices crc32_slices;
+
+// standard CRC-32 (IEEE 802.3); every version of the protocol depends on these exact values.
+// x86 SSE 4.2 only has an instruction for CRC-32C, which is a different polynomial, so x86 uses slice-by-8.
+// ARMv8 has the IEEE polynomial in hardware.
 u32 crc32(const u8* buffer, memory_index length, u32 value)
 {
 	value ^= 0xFFFFFFFF;
-	for (memory_index i = 0; i < length; i++) 
-		value = (value >> 8) ^ crc32_table[(value ^ buffer[i]) & 0xFF];
+
+	// byte at a time until aligned
+	while (length > 0 && (memory_index(buffer) & 7))
+	{
+		value = (value >> 8) ^ crc32_table[(value ^ *buffer) & 0xFF];
+		buffer++;
+		length--;
+	}
+
+#if defined(__ARM_FEATURE_CRC32)
+	while (length >= 8)
+	{
+		u64 word;
+		memcpy(&word, buffer, sizeof(word));
+		value = __crc32d(value, word);
+		buffer += 8;
+		length -= 8;
+	}
+#else
+	// assumes little endian, like the rest of the packet code
+	const u32 (*slice)[256] = crc32_slices.slice;
+	while (length >= 8)
+	{
+		u32 a;
+		u32 b;
+		memcpy(&a, buffer, sizeof(a));
+		memcpy(&b, buffer + 4, sizeof(b));
+		a ^= value;
+		value = slice[7][a & 0xFF] ^ slice[6][(a >> 8) & 0xFF] ^ slice[5][(a >> 16) & 0xFF] ^ slice[4][a >> 24]
+			^ slice[3][b & 0xFF] ^ slice[2][(b >> 8) & 0xFF] ^ slice[1][(b >> 16) & 0xFF] ^ slice[0][b >> 24];
+		buffer += 8;
+		length -= 8;
+	}
+#endif
+
+	while (length > 0)
+	{
+		value = (value >> 8) ^ crc32_table[(value ^ *buffer) & 0xFF];
+		buffer++;
+		length--;
+	}
+
 	return value ^ 0xFFFFFFFF;
 }
 
@@ -164,6 +228,16 @@ void StreamWrite::flush()
 	}
 }
 
+// copies every bit written to the other stream. the other stream must not be flushed
+void StreamWrite::append(const StreamWrite& other)
+{
+	vi_assert(other.scratch_bits >= 0);
+	for (s32 i = 0; i < other.data.length; i++)
+		bits(other.data[i], 32);
+	if (other.scratch_bits > 0)
+		bits(u32(other.scratch), other.scratch_bits);
+}
+
 b8 StreamWrite::would_overflow(s32 bits) const
 {
 	return bits_written() + bits > data.capacity() * 32;
@@ -307,6 +381,10 @@ void StreamRead::resize_bytes(s32 b)
 {
 	data.resize((b / sizeof(u32)) + (b % sizeof(u32) == 0 ? 0 : 1));
 	bytes_total = b;
+	// receive buffers are reused, so clear anything a longer packet left past the end of the last word.
+	// the checksum covers whole words
+	if (b % sizeof(u32) != 0)
+		memset((u8*)(data.data) + b, 0, sizeof(u32) - (b % sizeof(u32)));
 }
 
 b8 StreamRead::align()
@@ -331,38 +409,126 @@ void packet_init(StreamWrite* p)
 	p->bits(NET_PROTOCOL_ID, 32); // packet_send() will replace this with the packet checksum
 }
 
+// zlib state is kept alive and reset for each packet, rather than allocated and torn down every time
+struct CompressionContext
+{
+	z_stream deflate_stream;
+	z_stream inflate_stream;
+	b8 deflate_active;
+	b8 inflate_active;
+
+	CompressionContext()
+		: deflate_stream(), inflate_stream(), deflate_active(), inflate_active()
+	{
+	}
+
+	~CompressionContext()
+	{
+		if (deflate_active)
+			deflateEnd(&deflate_stream);
+		if (inflate_active)
+			inflateEnd(&inflate_stream);
+	}
+
+	z_stream* deflater()
+	{
+		if (deflate_active)
+		{
+			s32 result = deflateReset(&deflate_stream);
+			vi_assert(result == Z_OK);
+		}
+		else
+		{
+			s32 result = deflateInit(&deflate_stream, Z_DEFAULT_COMPRESSION);
+			vi_assert(result == Z_OK);
+			deflate_active = true;
+		}
+		return &deflate_stream;
+	}
+
+	z_stream* inflater()
+	{
+		if (inflate_active)
+		{
+			s32 result = inflateReset(&inflate_stream);
+			vi_assert(result == Z_OK);
+		}
+		else
+		{
+			s32 result = inflateInit(&inflate_stream);
+			vi_assert(result == Z_OK);
+			inflate_active = true;
+		}
+		return &inflate_stream;
+	}
+};
+
+thread_local CompressionContext compression_context;
+
+Compression packet_compression = Compression::Zlib;
+
+// returns compressed size
+s32 compress_zlib(const u8* in, s32 in_bytes, u8* out, s32 out_bytes)
+{
+	z_stream* z = compression_context.deflater();
+	z->next_in = (Bytef*)in;
+	z->avail_in = in_bytes;
+	z->next_out = (Bytef*)out;
+	z->avail_out = out_bytes;
+
+	s32 result = deflate(z, Z_FINISH);
+	vi_assert(result == Z_STREAM_END && z->avail_in == 0);
+
+	return out_bytes - s32(z->avail_out);
+}
+
+// returns compressed size, or -1 if the packet doesn't fit
+s32 compress_fastlz(const u8* in, s32 in_bytes, u8* out, s32 out_bytes)
+{
+	if (in_bytes < 16) // fastlz minimum
+		return -1;
+
+	u8 buffer[NET_MAX_PACKET_SIZE * 2]; // fastlz needs 5% headroom for incompressible input
+	s32 bytes = fastlz_compress(in, in_bytes, buffer);
+	if (bytes > out_bytes)
+		return -1;
+
+	memcpy(out, buffer, bytes);
+	return bytes;
+}
+
 void packet_finalize(StreamWrite* p)
 {
 	vi_assert(p->data[0] == NET_PROTOCOL_ID);
 	p->flush();
 
 	// compress everything but the protocol ID
+	// first byte after the protocol ID says which codec was used
+	const u8* in = (const u8*)&p->data[0] + sizeof(u32);
+	s32 in_bytes = p->bytes_written() - sizeof(u32);
+
 	StreamWrite compressed;
 	compressed.resize_bytes(NET_MAX_PACKET_SIZE);
-	z_stream z;
-	z.zalloc = nullptr;
-	z.zfree = nullptr;
-	z.opaque = nullptr;
-	z.next_out = (Bytef*)&compressed.data[1];
-	z.avail_out = NET_MAX_PACKET_SIZE - sizeof(u32);
-	z.next_in = (Bytef*)&p->data[1];
-	z.avail_in = p->bytes_written() - sizeof(u32);
-
-	s32 result = deflateInit(&z, Z_DEFAULT_COMPRESSION);
-	vi_assert(result == Z_OK);
-
-	result = deflate(&z, Z_FINISH);
-
-	vi_assert(result == Z_STREAM_END && z.avail_in == 0);
-
-	result = deflateEnd(&z);
-	vi_assert(result == Z_OK);
+	u8* out = (u8*)&compressed.data[1];
+	s32 out_bytes = NET_MAX_PACKET_SIZE - sizeof(u32) - 1;
+
+	Compression codec = packet_compression;
+	s32 compressed_bytes = -1;
+	if (codec == Compression::FastLZ)
+		compressed_bytes = compress_fastlz(in, in_bytes, &out[1], out_bytes);
+	if (compressed_bytes == -1)
+	{
+		codec = Compression::Zlib;
+		compressed_bytes = compress_zlib(in, in_bytes, &out[1], out_bytes);
+	}
+	out[0] = u8(codec);
+	compressed_bytes += 1;
 
 	p->reset();
-	p->resize_bytes(sizeof(u32) + NET_MAX_PACKET_SIZE - z.avail_out); // include one u32 for the CRC32
+	p->resize_bytes(sizeof(u32) + compressed_bytes); // include one u32 for the CRC32
 	vi_assert(p->data.length > 0);
 	p->data[p->data.length - 1] = 0; // make sure everything gets zeroed out so the CRC32 comes out right
-	memcpy(&p->data[1], &compressed.data[1], NET_MAX_PACKET_SIZE - z.avail_out);
+	memcpy(&p->data[1], out, compressed_bytes);
 
 	// replace protocol ID with CRC32
 	u32 checksum = crc32((const u8*)&p->data[0], sizeof(u32));
@@ -375,31 +541,50 @@ void packet_decompress(StreamRead* p, s32 bytes)
 {
 	StreamRead decompressed;
 	decompressed.resize_bytes(NET_MAX_PACKET_SIZE);
-	
-	z_stream z;
-	z.zalloc = nullptr;
-	z.zfree = nullptr;
-	z.opaque = nullptr;
-	z.next_in = (Bytef*)&p->data[1];
-	z.avail_in = bytes - sizeof(u32);
-	z.next_out = (Bytef*)&decompressed.data[1];
-	z.avail_out = NET_MAX_PACKET_SIZE - sizeof(u32);
-
-	s32 result = inflateInit(&z);
-	vi_assert(result == Z_OK);
-	
-	result = inflate(&z, Z_NO_FLUSH);
-	vi_assert(result == Z_STREAM_END);
-
-	result = inflateEnd(&z);
-	vi_assert(result == Z_OK);
+
+	const u8* in = (const u8*)&p->data[1];
+	s32 in_bytes = bytes - sizeof(u32);
+	vi_assert(in_bytes > 0);
+	u8* out = (u8*)&decompressed.data[1];
+	s32 out_bytes = NET_MAX_PACKET_SIZE - sizeof(u32);
+
+	s32 decompressed_bytes;
+	switch (Compression(in[0]))
+	{
+		case Compression::Zlib:
+		{
+			z_stream* z = compression_context.inflater();
+			z->next_in = (Bytef*)&in[1];
+			z->avail_in = in_bytes - 1;
+			z->next_out = (Bytef*)out;
+			z->avail_out = out_bytes;
+
+			s32 result = inflate(z, Z_NO_FLUSH);
+			vi_assert(result == Z_STREAM_END);
+
+			decompressed_bytes = out_bytes - s32(z->avail_out);
+			break;
+		}
+		case Compression::FastLZ:
+		{
+			decompressed_bytes = fastlz_decompress(&in[1], in_bytes - 1, out, out_bytes);
+			vi_assert(decompressed_bytes > 0);
+			break;
+		}
+		default:
+		{
+			vi_assert(false);
+			decompressed_bytes = 0;
+			break;
+		}
+	}
 
 	p->reset();
-	p->resize_bytes(sizeof(u32) + (NET_MAX_PACKET_SIZE - sizeof(u32)) - z.avail_out);
+	p->resize_bytes(sizeof(u32) + decompressed_bytes);
 	vi_assert(p->data.length > 0);
 
 	p->data[p->data.length - 1] = 0;
-	memcpy(&p->data[1], &decompressed.data[1], NET_MAX_PACKET_SIZE - z.avail_out);
+	memcpy((u8*)&p->data[0] + sizeof(u32), out, decompressed_bytes);
 
 	p->bits_read = 32; // skip past the CRC32
 }
@@ -14,7 +14,7 @@ namespace Net
 
 // borrows heavily from https://github.com/networkprotocol/libyojimbo
 
-#define NET_PROTOCOL_ID 0x6906c2fe
+#define NET_PROTOCOL_ID 0x6906c2ff
 
 u32 crc32(const u8*, memory_index, u32 value = 0);
 
@@ -40,6 +40,7 @@ struct StreamWrite
 	void resize_bytes(s32);
 	void flush();
 	void reset();
+	void append(const StreamWrite&);
 };
 
 struct StreamRead
@@ -70,6 +71,15 @@ struct StreamRead
 
 typedef u16 SequenceID;
 
+enum class Compression : s8
+{
+	Zlib, // smaller packets
+	FastLZ, // cheaper to compress and decompress
+	count,
+};
+
+extern Compression packet_compression; // codec used by packet_finalize(), from "net_compression" in the config file. recorded in each packet, so peers can differ
+
 void packet_init(StreamWrite*);
 void packet_finalize(StreamWrite*);
 void packet_decompress(StreamRead*, s32);
@@ -0,0 +1,314 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "types.h"
+#include "vi_assert.h"
+#include "lmath.h"
+#include "data/array.h"
+#include "data/pin_array.h"
+#include "game/constants.h"
+
+// times the per-frame Bolt, Health and Walker loops over a MAX_ENTITIES PinArray, once with the hot fields
+// inside the components (the old layout) and once with them split out into PinColumns (the current layout).
+// runs with a sparse pool (every eighth slot) and a full one. both layouts get the same updates and the
+// results have to match at the end.
+
+namespace VI
+{
+
+#define BENCH_DT (1.0f / 60.0f)
+
+// old layouts, field for field. Ref<> and Array<> are stood in for by same-sized members
+struct BenchBoltAoS
+{
+	ID entity_id;
+	Vec3 velocity;
+	Vec3 last_pos;
+	r32 remaining_lifetime;
+	u32 player;
+	u32 owner;
+	s8 team;
+	s8 type;
+	b8 reflected;
+};
+
+struct BenchHealthAoS
+{
+	ID entity_id;
+	r32 active_armor_timer;
+	r32 regen_timer;
+	void* damage_buffer_data;
+	s32 damage_buffer_length;
+	s32 damage_buffer_reserved;
+	s8 shield;
+	s8 shield_max;
+	s8 hp;
+	s8 hp_max;
+};
+
+struct BenchWalkerAoS
+{
+	ID entity_id;
+	Vec2 dir;
+	r32 speed;
+	r32 max_speed;
+	r32 rotation;
+	r32 target_rotation;
+	r32 net_speed;
+	r32 net_speed_timer;
+	u32 support;
+	b8 auto_rotate;
+	b8 enabled;
+};
+
+// current layouts: the same components minus the hot fields, which live in columns
+struct BenchBoltSoA
+{
+	ID entity_id;
+	u32 player;
+	u32 owner;
+	s8 team;
+	s8 type;
+	b8 reflected;
+};
+
+struct BenchHealthSoA
+{
+	ID entity_id;
+	void* damage_buffer_data;
+	s32 damage_buffer_length;
+	s32 damage_buffer_reserved;
+	s8 shield;
+	s8 shield_max;
+	s8 hp;
+	s8 hp_max;
+};
+
+struct BenchWalkerSoA
+{
+	ID entity_id;
+	Vec2 dir;
+	r32 speed;
+	r32 max_speed;
+	r32 rotation;
+	r32 target_rotation;
+	u32 support;
+	b8 auto_rotate;
+	b8 enabled;
+};
+
+PinArray<BenchBoltAoS, MAX_ENTITIES> bolts_aos;
+PinArray<BenchHealthAoS, MAX_ENTITIES> healths_aos;
+PinArray<BenchWalkerAoS, MAX_ENTITIES> walkers_aos;
+
+PinArray<BenchBoltSoA, MAX_ENTITIES> bolts_soa;
+PinColumn<Vec3, MAX_ENTITIES> bolt_velocities;
+PinColumn<Vec3, MAX_ENTITIES> bolt_last_positions;
+PinColumn<r32, MAX_ENTITIES> bolt_remaining_lifetimes;
+
+PinArray<BenchHealthSoA, MAX_ENTITIES> healths_soa;
+PinColumn<r32, MAX_ENTITIES> health_active_armor_timers;
+PinColumn<r32, MAX_ENTITIES> health_regen_timers;
+
+PinArray<BenchWalkerSoA, MAX_ENTITIES> walkers_soa;
+PinColumn<r32, MAX_ENTITIES> walker_net_speeds;
+PinColumn<r32, MAX_ENTITIES> walker_net_speed_timers;
+
+r64 bench_time()
+{
+	return r64(std::chrono::high_resolution_clock::now().time_since_epoch().count()) / 1000000000.0;
+}
+
+template<typename T> void bench_fill(PinArray<T, MAX_ENTITIES>* array, s32 stride)
+{
+	array->clear();
+	for (s32 i = 0; i < MAX_ENTITIES; i++)
+	{
+		T* item = array->add();
+		*item = T();
+		item->entity_id = ID(i);
+	}
+	for (s32 i = 0; i < MAX_ENTITIES; i++)
+	{
+		if (i % stride != 0)
+			array->remove(i);
+	}
+}
+
+void bench_reset(s32 stride)
+{
+	bench_fill(&bolts_aos, stride);
+	bench_fill(&healths_aos, stride);
+	bench_fill(&walkers_aos, stride);
+	bench_fill(&bolts_soa, stride);
+	bench_fill(&healths_soa, stride);
+	bench_fill(&walkers_soa, stride);
+
+	for (s32 i = 0; i < MAX_ENTITIES; i++)
+	{
+		Vec3 velocity(r32(i % 7) - 3.0f, r32(i % 3), r32(i % 5) - 2.0f);
+		r32 lifetime = 1.0f + r32(i % 11);
+		r32 timer = r32(i % 13) * 0.1f;
+
+		bolts_aos[i].velocity = velocity;
+		bolts_aos[i].last_pos = Vec3(0, 0, 0);
+		bolts_aos[i].remaining_lifetime = lifetime;
+		bolt_velocities[i] = velocity;
+		bolt_last_positions[i] = Vec3(0, 0, 0);
+		bolt_remaining_lifetimes[i] = lifetime;
+
+		healths_aos[i].active_armor_timer = timer;
+		healths_aos[i].regen_timer = timer * 2.0f;
+		health_active_armor_timers[i] = timer;
+		health_regen_timers[i] = timer * 2.0f;
+
+		walkers_aos[i].net_speed = timer * 10.0f;
+		walkers_aos[i].net_speed_timer = 0.0f;
+		walker_net_speeds[i] = timer * 10.0f;
+		walker_net_speed_timers[i] = 0.0f;
+	}
+}
+
+// same field updates as Bolt::simulate, Health::update and update_net_speed, minus the game logic
+void bench_tick_aos()
+{
+	for (auto i = bolts_aos.iterator(); !i.is_last(); i.next())
+	{
+		BenchBoltAoS* b = i.item();
+		b->remaining_lifetime -= BENCH_DT;
+		if (b->remaining_lifetime > 0.0f)
+			b->last_pos += b->velocity * BENCH_DT;
+	}
+
+	for (auto i = healths_aos.iterator(); !i.is_last(); i.next())
+	{
+		BenchHealthAoS* h = i.item();
+		h->active_armor_timer = vi_max(0.0f, h->active_armor_timer - BENCH_DT);
+		h->regen_timer -= BENCH_DT;
+	}
+
+	for (auto i = walkers_aos.iterator(); !i.is_last(); i.next())
+	{
+		BenchWalkerAoS* w = i.item();
+		w->net_speed_timer += BENCH_DT;
+		if (w->net_speed_timer > 0.5f)
+		{
+			w->net_speed *= 0.5f;
+			w->net_speed_timer = 0.0f;
+		}
+	}
+}
+
+void bench_tick_soa()
+{
+	for (auto i = bolts_soa.iterator(); !i.is_last(); i.next())
+	{
+		r32& remaining_lifetime = bolt_remaining_lifetimes[i.index];
+		remaining_lifetime -= BENCH_DT;
+		if (remaining_lifetime > 0.0f)
+			bolt_last_positions[i.index] += bolt_velocities[i.index] * BENCH_DT;
+	}
+
+	for (auto i = healths_soa.iterator(); !i.is_last(); i.next())
+	{
+		health_active_armor_timers[i.index] = vi_max(0.0f, health_active_armor_timers[i.index] - BENCH_DT);
+		health_regen_timers[i.index] -= BENCH_DT;
+	}
+
+	for (auto i = walkers_soa.iterator(); !i.is_last(); i.next())
+	{
+		r32& net_speed_timer = walker_net_speed_timers[i.index];
+		net_speed_timer += BENCH_DT;
+		if (net_speed_timer > 0.5f)
+		{
+			walker_net_speeds[i.index] *= 0.5f;
+			net_speed_timer = 0.0f;
+		}
+	}
+}
+
+s32 bench_mismatches()
+{
+	s32 result = 0;
+	for (auto i = bolts_aos.iterator(); !i.is_last(); i.next())
+	{
+		const BenchBoltAoS* b = i.item();
+		if (b->remaining_lifetime != bolt_remaining_lifetimes[i.index]
+			|| b->last_pos.x != bolt_last_positions[i.index].x
+			|| b->last_pos.y != bolt_last_positions[i.index].y
+			|| b->last_pos.z != bolt_last_positions[i.index].z)
+			result++;
+	}
+	for (auto i = healths_aos.iterator(); !i.is_last(); i.next())
+	{
+		const BenchHealthAoS* h = i.item();
+		if (h->active_armor_timer != health_active_armor_timers[i.index] || h->regen_timer != health_regen_timers[i.index])
+			result++;
+	}
+	for (auto i = walkers_aos.iterator(); !i.is_last(); i.next())
+	{
+		const BenchWalkerAoS* w = i.item();
+		if (w->net_speed != walker_net_speeds[i.index] || w->net_speed_timer != walker_net_speed_timers[i.index])
+			result++;
+	}
+	return result;
+}
+
+s32 usage()
+{
+	fprintf(stderr, "%s", "Usage: pin_array_bench [frames]\n");
+	return 1;
+}
+
+s32 proc(s32 argc, char* argv[])
+{
+	s32 frame_count = 10000;
+	if (argc > 2)
+		return usage();
+	if (argc > 1)
+		frame_count = atoi(argv[1]);
+	if (frame_count <= 0)
+		return usage();
+
+	printf("bolt %d -> %d bytes | health %d -> %d bytes | walker %d -> %d bytes\n",
+		s32(sizeof(BenchBoltAoS)), s32(sizeof(BenchBoltSoA)),
+		s32(sizeof(BenchHealthAoS)), s32(sizeof(BenchHealthSoA)),
+		s32(sizeof(BenchWalkerAoS)), s32(sizeof(BenchWalkerSoA)));
+
+	const s32 strides[] = { 8, 1 };
+	const char* names[] = { "sparse", "dense" };
+	for (s32 s = 0; s < 2; s++)
+	{
+		bench_reset(strides[s]);
+
+		r64 start = bench_time();
+		for (s32 i = 0; i < frame_count; i++)
+			bench_tick_aos();
+		r64 time_aos = bench_time() - start;
+
+		start = bench_time();
+		for (s32 i = 0; i < frame_count; i++)
+			bench_tick_soa();
+		r64 time_soa = bench_time() - start;
+
+		s32 mismatches = bench_mismatches();
+		if (mismatches > 0)
+		{
+			fprintf(stderr, "Error: %d items disagree between layouts\n", mismatches);
+			return 1;
+		}
+
+		r64 per_frame = 1000000.0 / r64(frame_count);
+		printf("%s (%d of %d slots): in-component %.3fus | columns %.3fus per frame\n", names[s], s32(bolts_aos.count()), MAX_ENTITIES, time_aos * per_frame, time_soa * per_frame);
+	}
+
+	return 0;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	return VI::proc(argc, argv);
+}
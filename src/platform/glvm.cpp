@@ -143,6 +143,12 @@ struct GLData
 	static Array<char> uniform_name_buffer;
 	static Array<AssetID> uniform_names;
 
+	// skinning palettes for the whole frame, read by armature shaders through a samplerBuffer.
+	// lives on its own texture unit so the per-shader sampler list never rebinds it
+	static const s32 bone_texture_unit = 15;
+	static GLuint bone_buffer;
+	static GLuint bone_texture;
+
 	static const char* uniform_name(AssetID index)
 	{
 		AssetID buffer_index = GLData::uniform_names[index];
@@ -159,6 +165,8 @@ RenderTechnique GLData::current_shader_technique = RenderTechnique::Default;
 Array<AssetID> GLData::samplers;
 Array<char> GLData::uniform_name_buffer;
 Array<AssetID> GLData::uniform_names;
+GLuint GLData::bone_buffer;
+GLuint GLData::bone_texture;
 RenderColorMask GLData::color_mask = RENDER_COLOR_MASK_DEFAULT;
 b8 GLData::depth_mask = true;
 b8 GLData::depth_test = true;
@@ -185,6 +193,15 @@ void render_init()
 	glDisable(GL_POLYGON_OFFSET_LINE);
 	glDisable(GL_POLYGON_OFFSET_FILL);
 	glDisable(GL_POLYGON_OFFSET_POINT);
+
+	glGenBuffers(1, &GLData::bone_buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, GLData::bone_buffer);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(Vec4), nullptr, GL_STREAM_DRAW); // glTexBuffer needs a data store
+	glGenTextures(1, &GLData::bone_texture);
+	glActiveTexture(GL_TEXTURE0 + GLData::bone_texture_unit);
+	glBindTexture(GL_TEXTURE_BUFFER, GLData::bone_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, GLData::bone_buffer);
+	glActiveTexture(GL_TEXTURE0);
 }
 
 void bind_attrib_pointers(Array<GLData::Mesh::Attrib>& attribs)
@@ -705,6 +722,7 @@ do\
 				s32 code_length = *(sync->read<s32>());
 				const char* code = sync->read<char>(code_length);
 
+				b8 program_changed = false;
 				for (s32 i = 0; i < s32(RenderTechnique::count); i++)
 				{
 					compile_shader(TechniquePrefixes::all[i], code, code_length, &GLData::shaders[id][i].handle);
@@ -712,6 +730,23 @@ do\
 					GLData::shaders[id][i].uniforms.resize(GLData::uniform_names.length);
 					for (s32 j = 0; j < GLData::uniform_names.length; j++)
 						GLData::shaders[id][i].uniforms[j] = glGetUniformLocation(GLData::shaders[id][i].handle, GLData::uniform_name(j));
+
+					// the bone buffer never moves, so point the sampler at it once
+					GLint bone_buffer_uniform = glGetUniformLocation(GLData::shaders[id][i].handle, "bone_buffer");
+					if (bone_buffer_uniform != -1)
+					{
+						glUseProgram(GLData::shaders[id][i].handle);
+						glUniform1i(bone_buffer_uniform, GLData::bone_texture_unit);
+						program_changed = true;
+					}
+				}
+
+				if (program_changed)
+				{
+					if (GLData::current_shader_asset == AssetNull)
+						glUseProgram(0);
+					else
+						glUseProgram(GLData::shaders[GLData::current_shader_asset][s32(GLData::current_shader_technique)].handle);
 				}
 
 				debug_check();
@@ -721,7 +756,10 @@ do\
 			{
 				AssetID id = *(sync->read<AssetID>());
 				for (s32 i = 0; i < s32(RenderTechnique::count); i++)
+				{
 					glDeleteProgram(GLData::shaders[id][i].handle);
+					GLData::shaders[id][i].handle = 0; // LoadShader might rebind the current program
+				}
 				debug_check();
 				break;
 			}
@@ -827,6 +865,7 @@ do\
 						if (sampler_index == -1)
 						{
 							sampler_index = GLData::samplers.length;
+							vi_assert(sampler_index < GLData::bone_texture_unit);
 							GLData::samplers.add(texture_asset);
 
 							glActiveTexture(GL_TEXTURE0 + sampler_index);
@@ -928,6 +967,15 @@ do\
 				debug_check();
 				break;
 			}
+			case RenderOp::UpdateBoneBuffer:
+			{
+				s32 count = *(sync->read<s32>());
+				glBindBuffer(GL_TEXTURE_BUFFER, GLData::bone_buffer);
+				glBufferData(GL_TEXTURE_BUFFER, sizeof(Vec4) * vi_max(count, 1), nullptr, GL_STREAM_DRAW); // orphan last frame's palettes
+				glBufferSubData(GL_TEXTURE_BUFFER, 0, sizeof(Vec4) * count, sync->read<Vec4>(count));
+				debug_check();
+				break;
+			}
 			case RenderOp::Instances:
 			{
 				AssetID id = *(sync->read<AssetID>());
@@ -11,6 +11,11 @@
 #else
 #include <sys/stat.h>
 #endif
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
 #include <time.h>
 #include <chrono>
 #include <ctime>
@@ -156,6 +161,11 @@ namespace Master
 		void update();
 	}
 
+	namespace EventLoop
+	{
+		void watch(s32, b8, b8);
+	}
+
 	namespace Signup
 	{
 		void distribute_keys();
@@ -294,6 +304,22 @@ void update()
 	mg_mgr_poll(&mgr, 0);
 }
 
+// registers every mongoose socket with the event loop. returns true if mongoose needs update() right away
+b8 watch()
+{
+	b8 immediate = false;
+	for (mg_connection* c = mg_next(&mgr, nullptr); c; c = mg_next(&mgr, c))
+	{
+		if (c->sock == INVALID_SOCKET)
+			continue;
+		b8 write = c->send_mbuf.len > 0 || (c->flags & MG_F_CONNECTING);
+		Master::EventLoop::watch(s32(c->sock), true, write);
+		if (c->flags & (MG_F_CLOSE_IMMEDIATELY | MG_F_SEND_AND_CLOSE))
+			immediate = true; // closing happens in mg_mgr_poll
+	}
+	return immediate;
+}
+
 void term()
 {
 	mg_mgr_free(&mgr);
@@ -313,6 +339,7 @@ namespace Master
 #define MASTER_SETTINGS_FILE "config.txt"
 #define MASTER_TOKEN_TIMEOUT (86400 * 2)
 #define MASTER_SERVER_LOAD_TIMEOUT 10.0
+#define MASTER_MAX_RECEIVE_BATCHES 8 // process at most x batches of packets before running upkeep again
 
 	r64 real_timestamp;
 	r64 global_timestamp;
@@ -337,6 +364,9 @@ namespace Master
 			size_t client_info_length;
 			UserKey user_key;
 			char username[MAX_USERNAME + 1];
+			u32 queue_config_id; // which wait queue the client is in, if queued
+			Region queue_region;
+			b8 queued;
 		};
 
 		struct Server
@@ -344,6 +374,8 @@ namespace Master
 			u8 public_key[NEXT_PUBLIC_KEY_BYTES];
 			Sock::Address public_ipv4;
 			Sock::Address public_ipv6;
+			Region idle_region; // which idle list the server is in, if listed
+			b8 idle_listed;
 		};
 
 		r64 last_message_timestamp;
@@ -375,30 +407,166 @@ namespace Master
 		s8 slots;
 	};
 
+	struct WaitQueue
+	{
+		Array<u64> clients; // in arrival order
+		u64 server_loading; // idle server we asked to load this config, if any
+	};
+
+	struct CachedStatement
+	{
+		sqlite3_stmt* stmt;
+		b8 in_use;
+	};
+
 	struct Global
 	{
 		sqlite3* db;
+		std::unordered_map<u64, CachedStatement> statements; // prepared statements keyed by hash of their SQL text
 		std::unordered_map<u64, Node> nodes;
 		std::unordered_map<u32, Sock::Address> server_config_map;
 		Sock::Handle sock;
 		Messenger messenger;
 		Array<u64> servers;
-		Array<u64> clients_waiting;
+		Array<u64> servers_idle[s32(Region::count)]; // may contain stale entries; see server_idle_pop
+		std::unordered_map<u32, WaitQueue> config_queues; // clients waiting for a multiplayer server config
+		Array<u64> story_queues[s32(Region::count)]; // clients waiting for a story mode server
 		Array<ClientConnection> clients_connecting;
+		StreamRead packets[NET_MAX_DATAGRAM_BATCH]; // receive buffers
 	};
 	Global global;
 
+	// blocks until a socket we care about is ready or the timeout expires.
+	// the UDP sockets are registered once; mongoose and curl sockets come and go, so they are re-registered before every wait
+	namespace EventLoop
+	{
+#if defined(__linux__)
+		s32 epoll_fd = -1;
+		Array<s32> watched; // transient sockets registered for the current wait
+		Array<s32> watched_last;
+
+		void init()
+		{
+			epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+			vi_assert(epoll_fd >= 0);
+			u64 handles[] = { global.sock.ipv4, global.sock.ipv6 };
+			for (s32 i = 0; i < 2; i++)
+			{
+				if (handles[i])
+				{
+					epoll_event e = {};
+					e.events = EPOLLIN;
+					e.data.fd = s32(handles[i]);
+					epoll_ctl(epoll_fd, EPOLL_CTL_ADD, e.data.fd, &e);
+				}
+			}
+		}
+
+		void watch(s32 fd, b8 read, b8 write)
+		{
+			epoll_event e = {};
+			e.events = (read ? EPOLLIN : 0) | (write ? EPOLLOUT : 0);
+			e.data.fd = fd;
+			// the socket may have been closed and its number reused since the last wait; closing drops it from the epoll set
+			if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &e) && errno == ENOENT)
+				epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &e);
+			watched.add(fd);
+		}
+
+		void wait(r64 timeout)
+		{
+			// stop watching sockets nobody asked about this time, for example idle connections curl keeps cached
+			for (s32 i = 0; i < watched_last.length; i++)
+			{
+				s32 fd = watched_last[i];
+				b8 still_watched = false;
+				for (s32 j = 0; j < watched.length; j++)
+				{
+					if (watched[j] == fd)
+					{
+						still_watched = true;
+						break;
+					}
+				}
+				if (!still_watched)
+					epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr); // fails harmlessly if it's already closed
+			}
+			watched_last.resize(watched.length);
+			if (watched.length > 0)
+				memcpy(&watched_last[0], &watched[0], sizeof(s32) * watched.length);
+			watched.length = 0;
+
+			epoll_event events[16];
+			epoll_wait(epoll_fd, events, 16, s32(ceil(vi_max(0.0, timeout) * 1000.0)));
+		}
+
+		void term()
+		{
+			::close(epoll_fd);
+			epoll_fd = -1;
+		}
+#else
+		void init()
+		{
+		}
+
+		void watch(s32 fd, b8 read, b8 write)
+		{
+		}
+
+		void wait(r64 timeout)
+		{
+			platform::vi_sleep(r32(vi_min(timeout, 1.0 / 60.0)));
+		}
+
+		void term()
+		{
+		}
+#endif
+	}
+
+	u64 db_sql_hash(const char* sql)
+	{
+		// FNV-1a
+		u64 hash = 14695981039346656037ULL;
+		for (const char* c = sql; *c; c++)
+			hash = (hash ^ u64(u8(*c))) * 1099511628211ULL;
+		return hash;
+	}
+
+	// statements are prepared once and reused; db_finalize hands them back to the cache.
+	// if the cached statement for this SQL is still in use (nested query) or the hash collides, we prepare a one-off.
 	sqlite3_stmt* db_query(const char* sql)
 	{
+#if DEBUG_SQL
+		printf("%s\n", sql);
+#endif
+		u64 hash = db_sql_hash(sql);
+		auto i = global.statements.find(hash);
+		if (i != global.statements.end())
+		{
+			CachedStatement* cached = &i->second;
+			if (!cached->in_use && strcmp(sqlite3_sql(cached->stmt), sql) == 0)
+			{
+				cached->in_use = true;
+				return cached->stmt;
+			}
+		}
+
 		sqlite3_stmt* stmt;
 		if (sqlite3_prepare_v2(global.db, sql, -1, &stmt, nullptr))
 		{
 			fprintf(stderr, "SQL: Failed to prepare statement: %s\nError: %s", sql, sqlite3_errmsg(global.db));
 			vi_assert(false);
 		}
-#if DEBUG_SQL
-		printf("%s\n", sql);
-#endif
+
+		if (i == global.statements.end())
+		{
+			CachedStatement* cached = &global.statements[hash];
+			cached->stmt = stmt;
+			cached->in_use = true;
+		}
+
 		return stmt;
 	}
 
@@ -469,13 +637,32 @@ namespace Master
 
 	void db_finalize(sqlite3_stmt* stmt)
 	{
-		if (sqlite3_finalize(stmt))
+		auto i = global.statements.find(db_sql_hash(sqlite3_sql(stmt)));
+		if (i != global.statements.end() && i->second.stmt == stmt)
+		{
+			// return it to the cache
+			vi_assert(i->second.in_use);
+			i->second.in_use = false;
+			if (sqlite3_reset(stmt) || sqlite3_clear_bindings(stmt))
+			{
+				fprintf(stderr, "SQL: Failed to reset query.\nError: %s", sqlite3_errmsg(global.db));
+				vi_assert(false);
+			}
+		}
+		else if (sqlite3_finalize(stmt))
 		{
 			fprintf(stderr, "SQL: Failed to finalize query.\nError: %s", sqlite3_errmsg(global.db));
 			vi_assert(false);
 		}
 	}
 
+	void db_statements_clear()
+	{
+		for (auto i = global.statements.begin(); i != global.statements.end(); i++)
+			sqlite3_finalize(i->second.stmt);
+		global.statements.clear();
+	}
+
 	s64 db_exec(sqlite3_stmt* stmt)
 	{
 		b8 more = db_step(stmt);
@@ -497,6 +684,42 @@ namespace Master
 		}
 	}
 
+	// schema changes applied to existing databases, in order. pragma user_version counts how many have run.
+	// only ever append to this list; new databases run every step right after the tables are created
+	void db_migrate()
+	{
+		s32 version;
+		{
+			sqlite3_stmt* stmt = db_query("pragma user_version;");
+			db_step(stmt);
+			version = s32(db_column_int(stmt, 0));
+			db_finalize(stmt);
+		}
+
+		const s32 latest = 1;
+		if (version >= latest)
+			return;
+
+		db_exec("begin;");
+
+		if (version < 1)
+		{
+			// loading the server ranking reads only this index instead of every config's json
+			db_exec("create index if not exists ServerConfigRank on ServerConfig (is_private, online, region, score desc);");
+			db_exec("create index if not exists ServerConfigSecret on ServerConfig (secret);");
+			// covers the Recent and Mine server lists, and the per-user exceptions to the Top list
+			db_exec("create index if not exists UserServerRecent on UserServer (user_id, timestamp desc, role, server_id);");
+		}
+
+		{
+			char sql[64];
+			snprintf(sql, sizeof(sql), "pragma user_version=%d;", latest);
+			db_exec(sql);
+		}
+
+		db_exec("commit;");
+	}
+
 	Node* node_add_or_get(const Sock::Address& addr)
 	{
 		u64 hash = addr.hash();
@@ -523,6 +746,81 @@ namespace Master
 			return &i->second;
 	}
 
+	// servers are never removed from the idle lists directly. instead each server remembers which list it was last added to,
+	// and server_idle_pop throws away entries that don't match or whose server has since left the idle state
+	void server_idle_add(Node* server)
+	{
+		vi_assert(server->state == Node::State::ServerIdle);
+		Region region = server->server_state.region;
+		if (!server->server.idle_listed || server->server.idle_region != region)
+		{
+			global.servers_idle[s32(region)].add(server->addr.hash());
+			server->server.idle_listed = true;
+			server->server.idle_region = region;
+		}
+	}
+
+	Node* server_idle_pop(Region region)
+	{
+		Array<u64>* list = &global.servers_idle[s32(region)];
+		while (list->length > 0)
+		{
+			Node* server = node_for_hash((*list)[list->length - 1]);
+			list->length--;
+			if (server && server->server.idle_listed && server->server.idle_region == region)
+			{
+				server->server.idle_listed = false;
+				if (server->state == Node::State::ServerIdle && server->server_state.region == region)
+					return server;
+			}
+		}
+		return nullptr;
+	}
+
+	Array<u64>* client_wait_queue(u32 config_id, Region region)
+	{
+		if (config_id)
+			return &global.config_queues[config_id].clients;
+		else
+			return &global.story_queues[s32(region)];
+	}
+
+	void client_wait_remove(Node* client)
+	{
+		if (!client->client.queued)
+			return;
+
+		Array<u64>* queue = client_wait_queue(client->client.queue_config_id, client->client.queue_region);
+		u64 hash = client->addr.hash();
+		for (s32 i = 0; i < queue->length; i++)
+		{
+			if ((*queue)[i] == hash)
+			{
+				queue->remove_ordered(i);
+				break;
+			}
+		}
+		client->client.queued = false;
+	}
+
+	// puts the client at the back of the queue for the server it's requesting, unless it's already waiting in that queue
+	void client_wait_add(Node* client)
+	{
+		u32 config_id = client->server_state.id;
+		Region region = client->server_state.region;
+		if (client->client.queued)
+		{
+			if (client->client.queue_config_id == config_id && (config_id || client->client.queue_region == region))
+				return;
+			client_wait_remove(client);
+		}
+
+		client_wait_queue(config_id, region)->add(client->addr.hash());
+		client->client.queue_config_id = config_id;
+		client->client.queue_region = region;
+		client->client.queued = true;
+	}
+
 	Node* node_for_address(const Sock::Address& addr)
 	{
 		return node_for_hash(addr.hash());
@@ -569,7 +867,10 @@ namespace Master
 			{
 				Node* client = node_for_address(connection.client);
 				if (client)
+				{
 					client->transition(Node::State::ClientWaiting);
+					client_wait_add(client);
+				}
 				global.clients_connecting.remove(i);
 				i--;
 			}
@@ -1104,12 +1405,250 @@ namespace Master
 		}
 	}
 
+	// in-memory ranking for the Top server list, mirroring the online/score/region/is_private columns of ServerConfig.
+	// the list a user sees is: every public online config, then the public offline configs in their region, best score first.
+	// on top of that, configs the user is banned from are dropped, and private configs they're allowed on are merged in.
+	// those per-user exceptions are few, so a page costs O(exceptions * log(configs) + page size) no matter how deep it is.
+	namespace ServerConfigRank
+	{
+		struct Entry
+		{
+			s64 score;
+			u32 id;
+			Region region;
+			b8 online;
+			b8 is_private;
+		};
+
+		struct Exception
+		{
+			Entry entry;
+			s32 position; // where the entry sits (or would sit) in the public list
+			b8 include;
+		};
+
+		std::unordered_map<u32, Entry> entries;
+		Array<Entry> online; // public online configs
+		Array<Entry> offline[s32(Region::count)]; // public offline configs per region
+
+		b8 before(const Entry& a, const Entry& b)
+		{
+			if (a.online != b.online)
+				return a.online;
+			if (a.score != b.score)
+				return a.score > b.score;
+			return a.id < b.id;
+		}
+
+		// the view is online ++ offline[region]; does this entry show up in it (ignoring is_private)?
+		b8 visible(const Entry& e, Region region)
+		{
+			return e.online || e.region == region;
+		}
+
+		Array<Entry>* list(const Entry& e)
+		{
+			if (e.is_private)
+				return nullptr;
+			if (e.online)
+				return &online;
+			if (s32(e.region) >= 0 && s32(e.region) < s32(Region::count))
+				return &offline[s32(e.region)];
+			return nullptr;
+		}
+
+		// index of the first entry in the list that does not rank before e
+		s32 lower_bound(const Array<Entry>& list, const Entry& e)
+		{
+			s32 low = 0;
+			s32 high = list.length;
+			while (low < high)
+			{
+				s32 mid = (low + high) / 2;
+				if (before(list[mid], e))
+					low = mid + 1;
+				else
+					high = mid;
+			}
+			return low;
+		}
+
+		void remove(u32 id)
+		{
+			auto i = entries.find(id);
+			if (i == entries.end())
+				return;
+			Array<Entry>* l = list(i->second);
+			if (l)
+			{
+				s32 index = lower_bound(*l, i->second);
+				vi_assert(index < l->length && (*l)[index].id == id);
+				l->remove_ordered(index);
+			}
+			entries.erase(i);
+		}
+
+		void update(const Entry& e)
+		{
+			remove(e.id);
+			entries[e.id] = e;
+			Array<Entry>* l = list(e);
+			if (l)
+				l->insert(lower_bound(*l, e), e);
+		}
+
+		void update_online(u32 id, b8 online)
+		{
+			auto i = entries.find(id);
+			if (i != entries.end() && i->second.online != online)
+			{
+				Entry e = i->second;
+				e.online = online;
+				update(e);
+			}
+		}
+
+		void update_score(u32 id, s64 score)
+		{
+			auto i = entries.find(id);
+			if (i != entries.end())
+			{
+				Entry e = i->second;
+				e.score = score;
+				update(e);
+			}
+		}
+
+		void update_settings(u32 id, b8 is_private, Region region)
+		{
+			auto i = entries.find(id);
+			if (i != entries.end())
+			{
+				Entry e = i->second;
+				e.is_private = is_private;
+				e.region = region;
+				update(e);
+			}
+		}
+
+		void init()
+		{
+			sqlite3_stmt* stmt = db_query("select id, score, region, is_private, online from ServerConfig;");
+			while (db_step(stmt))
+			{
+				Entry e;
+				e.id = u32(db_column_int(stmt, 0));
+				e.score = db_column_int(stmt, 1);
+				e.region = Region(db_column_int(stmt, 2));
+				e.is_private = b8(db_column_int(stmt, 3));
+				e.online = b8(db_column_int(stmt, 4));
+				update(e);
+			}
+			db_finalize(stmt);
+		}
+
+		// position of e in the public list online ++ offline[region]
+		s32 position(const Entry& e, Region region)
+		{
+			if (e.online)
+				return lower_bound(online, e);
+			else
+				return online.length + lower_bound(offline[s32(region)], e);
+		}
+
+		// ids of the configs at [offset, offset + count) in the given user's Top list
+		void page(u32 user_id, Region region, s32 offset, s32 count, Array<u32>* ids)
+		{
+			if (s32(region) < 0 || s32(region) >= s32(Region::count))
+				return;
+
+			const Array<Entry>& region_offline = offline[s32(region)];
+			s32 public_count = online.length + region_offline.length;
+
+			// collect this user's exceptions, sorted by rank
+			Array<Exception> exceptions;
+			{
+				sqlite3_stmt* stmt = db_query("select server_id, role from UserServer where user_id=? and role>0;");
+				db_bind_int(stmt, 0, user_id);
+				while (db_step(stmt))
+				{
+					auto i = entries.find(u32(db_column_int(stmt, 0)));
+					if (i == entries.end() || !visible(i->second, region))
+						continue;
+					Role role = Role(db_column_int(stmt, 1));
+					Exception x;
+					x.entry = i->second;
+					if (role == Role::Banned && !x.entry.is_private)
+						x.include = false;
+					else if (role > Role::Banned && x.entry.is_private)
+						x.include = true;
+					else
+						continue;
+					x.position = position(x.entry, region);
+
+					s32 index = exceptions.length;
+					while (index > 0 && before(x.entry, exceptions[index - 1].entry))
+						index--;
+					exceptions.insert(index, x);
+				}
+				db_finalize(stmt);
+			}
+
+			// find where the page starts.
+			// p is the position in the public list, f is the position in the user's list, x is the next exception to handle
+			s32 p = 0;
+			s32 f = 0;
+			s32 x = 0;
+			while (x < exceptions.length)
+			{
+				const Exception& exception = exceptions[x];
+				s32 run = exception.position - p; // public entries before this exception
+				if (f + run > offset)
+					break;
+				f += run;
+				p = exception.position;
+				if (exception.include)
+				{
+					if (f == offset)
+						break;
+					f++;
+				}
+				else
+					p++; // skip the banned entry
+				x++;
+			}
+			p += offset - f;
+
+			// merge the rest of the public list with the remaining exceptions
+			while (ids->length < count)
+			{
+				if (x < exceptions.length && exceptions[x].position <= p)
+				{
+					const Exception& exception = exceptions[x];
+					if (exception.include)
+						ids->add(exception.entry.id);
+					else
+						p++;
+					x++;
+				}
+				else if (p < public_count)
+				{
+					ids->add(p < online.length ? online[p].id : region_offline[p - online.length].id);
+					p++;
+				}
+				else
+					break;
+			}
+		}
+	}
+
 	void db_set_server_online(u32 id, b8 online)
 	{
 		sqlite3_stmt* stmt = db_query("update ServerConfig set online=? where id=?;");
 		db_bind_int(stmt, 0, online);
 		db_bind_int(stmt, 1, id);
 		db_exec(stmt);
+		ServerConfigRank::update_online(id, online);
 	}
 
 	void disconnected(const Sock::Address& addr)
@@ -1142,6 +1681,7 @@ namespace Master
 					}
 				}
 			}
+			// any idle list entry goes stale once the node is erased
 
 			// reset any clients trying to connect to this server
 			server_remove_clients_connecting(node);
@@ -1154,21 +1694,8 @@ namespace Master
 			node->client.client_info = nullptr;
 			node->client.client_info_length = 0;
 
-			if (node->state == Node::State::ClientWaiting)
-			{
-				// it's a client waiting for a server; remove it from the wait list
-				{
-					u64 hash = addr.hash();
-					for (s32 i = 0; i < global.clients_waiting.length; i++)
-					{
-						if (global.clients_waiting[i] == hash)
-						{
-							global.clients_waiting.remove(i);
-							i--;
-						}
-					}
-				}
-			}
+			// if it's a client waiting for a server, remove it from the wait list
+			client_wait_remove(node);
 		}
 		global.nodes.erase(addr.hash());
 		global.messenger.remove(addr);
@@ -1238,11 +1765,13 @@ namespace Master
 			}
 
 			{
+				s64 score = server_config_score(plays, platform::timestamp());
 				sqlite3_stmt* stmt = db_query("update ServerConfig set plays=?, score=? where id=?;");
 				db_bind_int(stmt, 0, plays);
-				db_bind_int(stmt, 1, server_config_score(plays, platform::timestamp()));
+				db_bind_int(stmt, 1, score);
 				db_bind_int(stmt, 2, server_id);
 				db_exec(stmt);
+				ServerConfigRank::update_score(server_id, score);
 			}
 		}
 
@@ -1359,42 +1888,74 @@ namespace Master
 		return true;
 	}
 
-	sqlite3_stmt* server_list_query(Node* client, Region region, ServerListType type, s32 offset)
+	struct ServerListRow
 	{
-		sqlite3_stmt* stmt;
+		ServerListEntry entry;
+		u32 id;
+	};
+
+	// columns: id, name, creator username, creator vip, max_players, team_count, game_type, preset
+	void server_list_row_read(sqlite3_stmt* stmt, ServerListRow* row)
+	{
+		row->id = u32(db_column_int(stmt, 0));
+		ServerListEntry* entry = &row->entry;
+		memset(entry->name, 0, sizeof(entry->name));
+		strncpy(entry->name, db_column_text(stmt, 1), MAX_SERVER_CONFIG_NAME);
+		memset(entry->creator_username, 0, sizeof(entry->creator_username));
+		strncpy(entry->creator_username, db_column_text(stmt, 2), MAX_USERNAME);
+		entry->creator_vip = b8(db_column_int(stmt, 3));
+		entry->max_players = s8(db_column_int(stmt, 4));
+		entry->team_count = s8(db_column_int(stmt, 5));
+		entry->game_type = GameType(db_column_int(stmt, 6));
+		entry->preset = Ruleset::Preset(db_column_int(stmt, 7));
+	}
+
+	void server_list_query(Node* client, Region region, ServerListType type, s32 offset, Array<ServerListRow>* rows)
+	{
+		const s32 page_size = 24;
 		switch (type)
 		{
 			case ServerListType::Top:
 			{
-				stmt = db_query("select ServerConfig.id, ServerConfig.name, User.username, User.vip, ServerConfig.max_players, ServerConfig.team_count, ServerConfig.game_type, ServerConfig.preset from ServerConfig left join User on User.id=ServerConfig.creator_id left join UserServer on (ServerConfig.id=UserServer.server_id and UserServer.user_id=?) where (ServerConfig.is_private=0 or UserServer.role>1) and (ServerConfig.online=1 or ServerConfig.region=?) and (UserServer.role!=1 or UserServer.role is null) order by ServerConfig.online desc, ServerConfig.score desc limit ?,24");
-				db_bind_int(stmt, 0, client->client.user_key.id);
-				db_bind_int(stmt, 1, s64(region));
-				db_bind_int(stmt, 2, offset);
-				break;
+				Array<u32> ids;
+				ServerConfigRank::page(client->client.user_key.id, region, offset, page_size, &ids);
+				for (s32 i = 0; i < ids.length; i++)
+				{
+					sqlite3_stmt* stmt = db_query("select ServerConfig.id, ServerConfig.name, User.username, User.vip, ServerConfig.max_players, ServerConfig.team_count, ServerConfig.game_type, ServerConfig.preset from ServerConfig left join User on User.id=ServerConfig.creator_id where ServerConfig.id=?;");
+					db_bind_int(stmt, 0, ids[i]);
+					if (db_step(stmt))
+						server_list_row_read(stmt, rows->add());
+					db_finalize(stmt);
+				}
+				return;
 			}
 			case ServerListType::Recent:
 			{
-				stmt = db_query("select ServerConfig.id, ServerConfig.name, User.username, User.vip, ServerConfig.max_players, ServerConfig.team_count, ServerConfig.game_type, ServerConfig.preset from ServerConfig inner join UserServer on UserServer.server_id=ServerConfig.id left join User on User.id=ServerConfig.creator_id where UserServer.user_id=? and UserServer.role!=1 order by ServerConfig.online desc, UserServer.timestamp desc limit ?,24");
+				sqlite3_stmt* stmt = db_query("select ServerConfig.id, ServerConfig.name, User.username, User.vip, ServerConfig.max_players, ServerConfig.team_count, ServerConfig.game_type, ServerConfig.preset from ServerConfig inner join UserServer on UserServer.server_id=ServerConfig.id left join User on User.id=ServerConfig.creator_id where UserServer.user_id=? and UserServer.role!=1 order by ServerConfig.online desc, UserServer.timestamp desc limit ?,24");
 				db_bind_int(stmt, 0, client->client.user_key.id);
 				db_bind_int(stmt, 1, offset);
-				break;
+				while (db_step(stmt))
+					server_list_row_read(stmt, rows->add());
+				db_finalize(stmt);
+				return;
 			}
 			case ServerListType::Mine:
 			{
-				stmt = db_query("select ServerConfig.id, ServerConfig.name, User.username, User.vip, ServerConfig.max_players, ServerConfig.team_count, ServerConfig.game_type, ServerConfig.preset from ServerConfig inner join UserServer on UserServer.server_id=ServerConfig.id left join User on User.id=ServerConfig.creator_id where UserServer.user_id=? and UserServer.role>=3 order by ServerConfig.online desc, UserServer.timestamp desc limit ?,24");
+				sqlite3_stmt* stmt = db_query("select ServerConfig.id, ServerConfig.name, User.username, User.vip, ServerConfig.max_players, ServerConfig.team_count, ServerConfig.game_type, ServerConfig.preset from ServerConfig inner join UserServer on UserServer.server_id=ServerConfig.id left join User on User.id=ServerConfig.creator_id where UserServer.user_id=? and UserServer.role>=3 order by ServerConfig.online desc, UserServer.timestamp desc limit ?,24");
 				db_bind_int(stmt, 0, client->client.user_key.id);
 				db_bind_int(stmt, 1, offset);
-				break;
+				while (db_step(stmt))
+					server_list_row_read(stmt, rows->add());
+				db_finalize(stmt);
+				return;
 			}
 			default:
 				vi_assert(false);
 				break;
 		}
-
-		return stmt;
 	}
 
-	b8 send_server_list_fragment(Node* client, Region region, ServerListType type, sqlite3_stmt* stmt, s32* offset, b8* done)
+	b8 send_server_list_fragment(Node* client, Region region, ServerListType type, Array<ServerListRow>* rows, s32* row, s32* offset, b8* done)
 	{
 		using Stream = StreamWrite;
 
@@ -1408,29 +1969,18 @@ namespace Master
 		s32 count = 0;
 		while (true)
 		{
-			if (!db_step(stmt))
+			if (*row == rows->length)
 			{
 				*done = true;
 				break;
 			}
 			serialize_s32(&p, *offset);
 
-			ServerListEntry entry;
-
-			u32 id = u32(db_column_int(stmt, 0));
-			memset(entry.name, 0, sizeof(entry.name));
-			strncpy(entry.name, db_column_text(stmt, 1), MAX_SERVER_CONFIG_NAME);
-			memset(entry.creator_username, 0, sizeof(entry.creator_username));
-			strncpy(entry.creator_username, db_column_text(stmt, 2), MAX_USERNAME);
-			entry.creator_vip = b8(db_column_int(stmt, 3));
-			entry.max_players = s8(db_column_int(stmt, 4));
-			entry.team_count = s8(db_column_int(stmt, 5));
-			entry.game_type = GameType(db_column_int(stmt, 6));
-			entry.preset = Ruleset::Preset(db_column_int(stmt, 7));
+			ServerListRow* r = &(*rows)[*row];
+			(*row)++;
+			server_state_for_config_id(r->id, r->entry.max_players, region, &r->entry.server_state, client->addr.host.type, &r->entry.addr);
 
-			server_state_for_config_id(id, entry.max_players, region, &entry.server_state, client->addr.host.type, &entry.addr);
-
-			if (!serialize_server_list_entry(&p, &entry))
+			if (!serialize_server_list_entry(&p, &r->entry))
 				net_error();
 
 			(*offset)++;
@@ -1455,15 +2005,16 @@ namespace Master
 	b8 send_server_list(Node* client, Region region, ServerListType type, s32 offset)
 	{
 		offset = vi_max(offset - 12, 0);
-		sqlite3_stmt* stmt = server_list_query(client, region, type, offset);
+		Array<ServerListRow> rows;
+		server_list_query(client, region, type, offset, &rows);
+		s32 row = 0;
 		while (true)
 		{
 			b8 done;
-			send_server_list_fragment(client, region, type, stmt, &offset, &done);
+			send_server_list_fragment(client, region, type, &rows, &row, &offset, &done);
 			if (done)
 				break;
 		}
-		db_finalize(stmt);
 		return true;
 	}
 
@@ -1844,6 +2395,8 @@ namespace Master
 
 		s8 original_open_slots = server->server_state.player_slots;
 		server->server_state = s;
+		if (server->state == Node::State::ServerIdle)
+			server_idle_add(server);
 		s8 clients_connecting_count = server_client_slots_connecting(server);
 		if (clients_connecting_count > 0)
 		{
@@ -1910,14 +2463,7 @@ namespace Master
 
 	void client_queue_join(Node* server, Node* client)
 	{
-		for (s32 i = 0; i < global.clients_waiting.length; i++)
-		{
-			if (global.clients_waiting[i] == client->addr.hash())
-			{
-				global.clients_waiting.remove(i);
-				break;
-			}
-		}
+		client_wait_remove(client);
 
 		ClientConnection* connection = global.clients_connecting.add();
 		connection->timestamp = global_timestamp;
@@ -1992,21 +2538,6 @@ namespace Master
 		return true;
 	}
 
-	s8 client_wait_position(const Node* client)
-	{
-		u32 desired_server_id = client->server_state.id;
-		s8 result = 0;
-		for (s32 i = 0; i < global.clients_waiting.length; i++)
-		{
-			Node* c = node_for_hash(global.clients_waiting[i]);
-			if (c->server_state.id == desired_server_id)
-				result++;
-			if (result == 127)
-				break;
-		}
-		return result - 1; // don't count the client themselves
-	}
-
 	b8 send_client_connection_step(const Node* client, ClientConnectionStep step, s8 wait_position = 0)
 	{
 		using Stream = StreamWrite;
@@ -2293,10 +2824,10 @@ namespace Master
 					}
 					node->server_state.id = requested_server_id;
 
+					// add to client waiting list, or move to a different queue if they're requesting a different server now
+					client_wait_add(node);
 					if (node->state != Node::State::ClientWaiting)
 					{
-						// add to client waiting list
-						global.clients_waiting.add(node->addr.hash());
 						node->transition(Node::State::ClientWaiting);
 
 						send_client_connection_step(node, ClientConnectionStep::AllocatingServer);
@@ -2384,11 +2915,22 @@ namespace Master
 					db_bind_int(stmt, 5, s64(config.game_type));
 					db_bind_int(stmt, 6, config.is_private);
 					db_bind_int(stmt, 7, s64(config.region));
-					db_bind_int(stmt, 8, server_config_score(0, platform::timestamp()));
+					s64 score = server_config_score(0, platform::timestamp());
+					db_bind_int(stmt, 8, score);
 					db_bind_text(stmt, 9, config.secret);
 					db_bind_int(stmt, 10, s64(config.preset));
 					config_id = u32(db_exec(stmt));
 
+					{
+						ServerConfigRank::Entry entry;
+						entry.score = score;
+						entry.id = config_id;
+						entry.region = config.region;
+						entry.online = false;
+						entry.is_private = config.is_private;
+						ServerConfigRank::update(entry);
+					}
+
 					// give friends access to new server
 					{
 						sqlite3_stmt* stmt = db_query("select user2_id from Friendship where user1_id=?;");
@@ -2418,9 +2960,13 @@ namespace Master
 							b8 previously_private = b8(db_column_int(stmt, 0));
 							if (!previously_private)
 								server_config_generate_secret(config.secret);
+							db_finalize(stmt);
 						}
 						else // config doesn't exist
+						{
+							db_finalize(stmt);
 							net_error();
+						}
 					}
 
 					sqlite3_stmt* stmt = db_query("update ServerConfig set name=?, config=?, max_players=?, team_count=?, game_type=?, is_private=?, region=?, secret=?, preset=? where id=?;");
@@ -2438,6 +2984,7 @@ namespace Master
 					db_bind_int(stmt, 9, config.id);
 					db_exec(stmt);
 					config_id = config.id;
+					ServerConfigRank::update_settings(config_id, config.is_private, config.region);
 				}
 
 				update_user_server_linkage(node->client.user_key.id, config_id, Role::Admin); // make them an admin
@@ -2622,6 +3169,11 @@ namespace Master
 				return 1;
 			}
 
+			// write-ahead log lets readers proceed during writes and turns most commits into a single append.
+			// with WAL, synchronous=normal only fsyncs at checkpoints; a power loss can drop the last few commits but never corrupts the database
+			db_exec("pragma journal_mode=wal;");
+			db_exec("pragma synchronous=normal;");
+
 			if (init_db)
 			{
 				db_exec("create table User (id integer primary key autoincrement, token integer not null, token_timestamp integer not null, itch_id integer, steam_id integer, gamejolt_id integer, username varchar(256) not null, banned boolean not null, vip boolean not null, unique(itch_id), unique(steam_id));");
@@ -2632,7 +3184,9 @@ namespace Master
 				db_exec("create table DiscordUser (id integer primary key, playtime integer, member_available_role boolean not null);");
 				db_exec("create table Email (email text, key text);");
 			}
+			db_migrate();
 			db_exec("update ServerConfig set online=0;");
+			ServerConfigRank::init();
 		}
 
 		// load settings
@@ -2756,6 +3310,8 @@ namespace Master
 
 		DiscordBot::init();
 
+		EventLoop::init();
+
 		r64 last_audit = 0.0;
 		r64 last_match = 0.0;
 		r64 last_key_distribution = 0.0;
@@ -2791,7 +3347,7 @@ namespace Master
 						if (client && client->state == Node::State::ClientConnecting)
 						{
 							client->transition(Node::State::ClientWaiting); // give up connecting, go back to matchmaking
-							global.clients_waiting.add(client->addr.hash());
+							client_wait_add(client);
 						}
 
 						Node* server = node_for_address(c.server);
@@ -2828,68 +3384,126 @@ namespace Master
 			{
 				last_match = global_timestamp;
 
-				for (s32 i = 0; i < global.clients_waiting.length; i++)
+				// story mode: every client gets an idle server of their own
+				for (s32 r = 0; r < s32(Region::count); r++)
 				{
-					Node* client = node_for_hash(global.clients_waiting[i]);
-					Node* server = client_requested_server(client);
-					if (server)
+					Array<u64>* queue = &global.story_queues[r];
+					while (queue->length > 0)
 					{
-						// server is already running
-						if (server_open_slots(server) >= client->server_state.player_slots)
-						{
-							client_connect_to_existing_server(client, server);
-							i--; // client has been removed from clients_waiting
-						}
-						else
-						{
-							// not enough room for client; let the client know
-							s8 wait_position = client_wait_position(client);
-							send_client_connection_step(client, ClientConnectionStep::WaitingForSlot, wait_position);
-						}
+						Node* idle_server = server_idle_pop(Region(r));
+						if (!idle_server)
+							break;
+						Node* client = node_for_hash((*queue)[0]);
+						send_server_load(idle_server, client);
+						send_server_expect_client(idle_server, &client->client.user_key);
+						client_queue_join(idle_server, client); // removes the client from the queue
 					}
-					else
+				}
+
+				// multiplayer: clients share one server per config
+				auto i = global.config_queues.begin();
+				while (i != global.config_queues.end())
+				{
+					u32 config_id = i->first;
+					WaitQueue* queue = &i->second;
+
+					if (queue->server_loading)
+					{
+						Node* loading = node_for_hash(queue->server_loading);
+						if (!loading || loading->state != Node::State::ServerLoading || loading->server_state.id != config_id)
+							queue->server_loading = 0; // done loading, or gave up
+					}
+
+					Node* server = server_for_config_id(config_id);
+					if (server)
 					{
-						// allocate an idle server for this client
-						Node* idle_server = nullptr;
-						for (s32 i = 0; i < global.servers.length; i++)
+						// server is already running
+						s8 wait_position = s8(vi_min(queue->clients.length, 127) - 1); // don't count the client themselves
+						for (s32 j = 0; j < queue->clients.length; j++)
 						{
-							Node* server = node_for_hash(global.servers[i]);
-							if (server->state == Node::State::ServerIdle && server->server_state.region == client->server_state.region)
+							Node* client = node_for_hash(queue->clients[j]);
+							if (server_open_slots(server) >= client->server_state.player_slots)
 							{
-								idle_server = server;
-								break;
+								client_connect_to_existing_server(client, server);
+								j--; // client has been removed from the queue
 							}
+							else // not enough room for client; let the client know
+								send_client_connection_step(client, ClientConnectionStep::WaitingForSlot, wait_position);
 						}
-
+					}
+					else if (queue->clients.length > 0 && !queue->server_loading)
+					{
+						// allocate an idle server for the first client; everyone else connects once it's up
+						Node* client = node_for_hash(queue->clients[0]);
+						Node* idle_server = server_idle_pop(client->server_state.region);
 						if (idle_server)
 						{
 							send_server_load(idle_server, client);
 							send_server_expect_client(idle_server, &client->client.user_key);
 							client_queue_join(idle_server, client);
-							i--; // client has been removed from clients_waiting
+							queue->server_loading = idle_server->addr.hash();
 						}
 					}
+
+					if (queue->clients.length == 0 && !queue->server_loading)
+						i = global.config_queues.erase(i);
+					else
+						i++;
 				}
 			}
 
-			Sock::Address addr;
-			StreamRead packet;
-			s32 bytes_read = Sock::udp_receive(&global.sock, &addr, packet.data.data, NET_MAX_PACKET_SIZE);
-			packet.resize_bytes(bytes_read);
-			if (bytes_read > 0)
+			// drain pending packets, a batch at a time. stop after a while so a flood can't starve the upkeep above
+			s32 received_total = 0;
+			for (s32 batch = 0; batch < MASTER_MAX_RECEIVE_BATCHES; batch++)
 			{
-				if (packet.read_checksum())
+				Sock::Datagram datagrams[NET_MAX_DATAGRAM_BATCH];
+				for (s32 i = 0; i < NET_MAX_DATAGRAM_BATCH; i++)
 				{
-					packet_decompress(&packet, bytes_read);
-					packet_handle(&packet, addr);
+					datagrams[i].data = global.packets[i].data.data;
+					datagrams[i].size = NET_MAX_PACKET_SIZE;
 				}
-				else
-					vi_debug("%s", "Discarding packet due to invalid checksum.");
+				s32 received = Sock::udp_receive_batch(&global.sock, datagrams, NET_MAX_DATAGRAM_BATCH);
+				for (s32 i = 0; i < received; i++)
+				{
+					StreamRead* packet = &global.packets[i];
+					s32 bytes_read = datagrams[i].size;
+					packet->reset();
+					packet->resize_bytes(bytes_read);
+					if (bytes_read > 0)
+					{
+						if (packet->read_checksum())
+						{
+							packet_decompress(packet, bytes_read);
+							packet_handle(packet, datagrams[i].address);
+						}
+						else
+							vi_debug("%s", "Discarding packet due to invalid checksum.");
+					}
+				}
+				received_total += received;
+				if (received < NET_MAX_DATAGRAM_BATCH)
+					break;
+			}
+
+			if (received_total == 0)
+			{
+				// nothing left to read; sleep until a socket is ready or it's time for the next periodic job.
+				// matchmaking has the shortest interval, so everything else still gets checked at least that often
+				b8 immediate = CrashReport::watch();
+				r64 timeout = Http::sockets(&EventLoop::watch);
+				if (immediate)
+					timeout = 0.0;
+				r64 now = platform::time();
+				r64 next_job = vi_min(last_match + MASTER_MATCH_INTERVAL, vi_min(last_audit + MASTER_AUDIT_INTERVAL, last_key_distribution + MASTER_KEY_DISTRIBUTION_INTERVAL));
+				if (timeout < 0.0 || next_job - now < timeout)
+					timeout = next_job - now;
+				EventLoop::wait(timeout);
 			}
-			else
-				platform::vi_sleep(1.0f / 60.0f);
 		}
 
+		EventLoop::term();
+
+		db_statements_clear();
 		sqlite3_close(global.db);
 
 		Http::term();
@@ -6,6 +6,8 @@
 //#undef main
 
 #include "render/glvm.h"
+#include "render/render_filter.h"
+#include "render/render_capture.h"
 #include "load.h"
 
 #include <thread>
@@ -542,6 +544,17 @@ namespace VI
 		glGetError(); // clear initial error caused by GLEW
 
 		render_init();
+		RenderFilter render_filter;
+
+		RenderCapture render_capture;
+		if (Settings::record_render)
+		{
+			const char* path = "render.cap";
+			if (render_capture.write_open(path, Settings::display().width, Settings::display().height))
+				vi_debug("Recording render commands to '%s'.", path);
+			else
+				vi_debug("Failed to open '%s' for recording render commands.", path);
+		}
 
 		// launch threads
 
@@ -893,6 +906,9 @@ namespace VI
 				SDL_MinimizeWindow(window);
 			}
 
+			if (render_capture.file && !render_capture.write(sync)) // before filtering, which depends on state from earlier frames
+				vi_debug("Render capture reached %d MB; stopped recording.", s32(RenderCapture::max_bytes >> 20));
+			render_filter.filter(sync, &sync->render_stats);
 			render(sync);
 
 			// swap buffers
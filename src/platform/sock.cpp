@@ -14,6 +14,7 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <fcntl.h>
+#include <errno.h>
 #endif
 #include <functional>
 
@@ -307,39 +308,67 @@ void close(Handle* socket)
 	}
 }
 
-s32 udp_send(Handle* socket, const Address& destination, const void* data, s32 size)
+// fills in the socket address and returns the handle to send it on, or 0 if we don't have a socket open for that protocol
+static u64 address_to_sockaddr(Handle* socket, const Address& destination, struct sockaddr_storage* address, size_t* addr_length)
 {
-	struct sockaddr_storage address;
-	memset(&address, 0, sizeof(address));
+	memset(address, 0, sizeof(*address));
 	u64 handle = 0;
-	size_t addr_length = 0;
+	*addr_length = 0;
 	switch (destination.host.type)
 	{
 		case Host::Type::IPv4:
 		{
-			struct sockaddr_in* ipv4 = (struct sockaddr_in*)(&address);
+			struct sockaddr_in* ipv4 = (struct sockaddr_in*)(address);
 			ipv4->sin_family = AF_INET;
 			ipv4->sin_port = destination.port;
 			ipv4->sin_addr.s_addr = destination.host.ipv4;
 			handle = socket->ipv4;
-			addr_length = sizeof(struct sockaddr_in);
+			*addr_length = sizeof(struct sockaddr_in);
 			break;
 		}
 		case Host::Type::IPv6:
 		{
-			struct sockaddr_in6* ipv6 = (struct sockaddr_in6*)(&address);
+			struct sockaddr_in6* ipv6 = (struct sockaddr_in6*)(address);
 			ipv6->sin6_family = AF_INET6;
 			ipv6->sin6_port = destination.port;
 			ipv6->sin6_scope_id = destination.host.scope_id;
 			memcpy(&ipv6->sin6_addr, &destination.host.ipv6, sizeof(ipv6->sin6_addr));
 			handle = socket->ipv6;
-			addr_length = sizeof(struct sockaddr_in6);
+			*addr_length = sizeof(struct sockaddr_in6);
 			break;
 		}
 		default:
 			vi_assert(false);
 			break;
 	}
+	return handle;
+}
+
+static void address_from_sockaddr(const struct sockaddr_storage& from, Address* sender)
+{
+	if (from.ss_family == AF_INET6)
+	{
+		sender->host.type = Host::Type::IPv6;
+		const struct sockaddr_in6* ipv6 = (const struct sockaddr_in6*)(&from);
+		memcpy(sender->host.ipv6, &ipv6->sin6_addr, sizeof(ipv6->sin6_addr));
+		sender->host.scope_id = ipv6->sin6_scope_id;
+		sender->port = ipv6->sin6_port;
+	}
+	else
+	{
+		sender->host.type = Host::Type::IPv4;
+		const struct sockaddr_in* ipv4 = (const struct sockaddr_in*)(&from);
+		sender->host.ipv4 = ipv4->sin_addr.s_addr;
+		sender->host.scope_id = 0;
+		sender->port = ipv4->sin_port;
+	}
+}
+
+s32 udp_send(Handle* socket, const Address& destination, const void* data, s32 size)
+{
+	struct sockaddr_storage address;
+	size_t addr_length;
+	u64 handle = address_to_sockaddr(socket, destination, &address, &addr_length);
 
 	if (handle) // do we actually have a socket open for the desired protocol?
 	{
@@ -376,24 +405,165 @@ s32 udp_receive(Handle* socket, Address* sender, void* data, s32 size)
 			return 0;
 	}
 
-	if (from.ss_family == AF_INET6)
+	address_from_sockaddr(from, sender);
+
+	return received_bytes;
+}
+
+#if defined(__linux__)
+
+// sends every datagram bound for the given socket, in as few syscalls as possible
+// errors caused by one datagram's destination or size, rather than the socket
+static b8 udp_send_error_per_datagram(s32 code)
+{
+	switch (code)
 	{
-		sender->host.type = Host::Type::IPv6;
-		const struct sockaddr_in6* ipv6 = (const struct sockaddr_in6*)(&from);
-		memcpy(sender->host.ipv6, &ipv6->sin6_addr, sizeof(ipv6->sin6_addr));
-		sender->host.scope_id = ipv6->sin6_scope_id;
-		sender->port = ipv6->sin6_port;
+		case EMSGSIZE:
+		case EHOSTUNREACH:
+		case EHOSTDOWN:
+		case ENETUNREACH:
+		case ENETDOWN:
+		case ECONNREFUSED:
+		case EACCES:
+		case EPERM:
+		case EADDRNOTAVAIL:
+		case EAFNOSUPPORT:
+		case EDESTADDRREQ:
+		case EINVAL:
+			return true;
+		default:
+			return false;
 	}
-	else
+}
+
+static s32 udp_send_batch_handle(Handle* socket, u64 handle, const Datagram* datagrams, s32 count)
+{
+	struct mmsghdr headers[NET_MAX_DATAGRAM_BATCH];
+	struct iovec iovecs[NET_MAX_DATAGRAM_BATCH];
+	struct sockaddr_storage addresses[NET_MAX_DATAGRAM_BATCH];
+	s32 header_count = 0;
+	for (s32 i = 0; i < count; i++)
 	{
-		sender->host.type = Host::Type::IPv4;
-		const struct sockaddr_in* ipv4 = (const struct sockaddr_in*)(&from);
-		sender->host.ipv4 = ipv4->sin_addr.s_addr;
-		sender->host.scope_id = 0;
-		sender->port = ipv4->sin_port;
+		size_t addr_length;
+		if (address_to_sockaddr(socket, datagrams[i].address, &addresses[header_count], &addr_length) != handle)
+			continue;
+		iovecs[header_count].iov_base = datagrams[i].data;
+		iovecs[header_count].iov_len = size_t(datagrams[i].size);
+		struct msghdr* header = &headers[header_count].msg_hdr;
+		memset(header, 0, sizeof(*header));
+		header->msg_name = &addresses[header_count];
+		header->msg_namelen = socklen_t(addr_length);
+		header->msg_iov = &iovecs[header_count];
+		header->msg_iovlen = 1;
+		header_count++;
 	}
 
-	return received_bytes;
+	// sendmmsg stops at the first datagram that fails. it returns -1 if that was the first one in the call,
+	// otherwise how many went out before it, and the failure comes back from the next call.
+	// a failure that only concerns one datagram skips it; the rest of the batch still goes out
+	s32 result = 0;
+	s32 sent = 0;
+	while (sent < header_count)
+	{
+		s32 count_sent = sendmmsg(handle, &headers[sent], header_count - sent, 0);
+		if (count_sent > 0)
+			sent += count_sent;
+		else if (count_sent < 0 && errno == EINTR)
+			continue;
+		else if (count_sent < 0 && udp_send_error_per_datagram(errno))
+		{
+			result = error("Failed to send data");
+			sent++;
+		}
+		else
+			return error("Failed to send data"); // the socket itself is in trouble (full buffer, out of memory, closed)
+	}
+	return result;
+}
+
+static s32 udp_receive_batch_handle(u64 handle, Datagram* datagrams, s32 count)
+{
+	struct mmsghdr headers[NET_MAX_DATAGRAM_BATCH];
+	struct iovec iovecs[NET_MAX_DATAGRAM_BATCH];
+	struct sockaddr_storage addresses[NET_MAX_DATAGRAM_BATCH];
+	for (s32 i = 0; i < count; i++)
+	{
+		iovecs[i].iov_base = datagrams[i].data;
+		iovecs[i].iov_len = size_t(datagrams[i].size);
+		struct msghdr* header = &headers[i].msg_hdr;
+		memset(header, 0, sizeof(*header));
+		header->msg_name = &addresses[i];
+		header->msg_namelen = sizeof(addresses[i]);
+		header->msg_iov = &iovecs[i];
+		header->msg_iovlen = 1;
+	}
+
+	s32 result = recvmmsg(handle, headers, count, MSG_DONTWAIT, nullptr);
+	if (result <= 0)
+		return 0;
+
+	for (s32 i = 0; i < result; i++)
+	{
+		datagrams[i].size = s32(headers[i].msg_len);
+		address_from_sockaddr(addresses[i], &datagrams[i].address);
+	}
+	return result;
+}
+
+#endif
+
+s32 udp_send_batch(Handle* socket, const Datagram* datagrams, s32 count)
+{
+	vi_assert(count <= NET_MAX_DATAGRAM_BATCH);
+#if defined(__linux__)
+	s32 result = 0;
+	if (socket->ipv4 && udp_send_batch_handle(socket, socket->ipv4, datagrams, count))
+		result = -1;
+	if (socket->ipv6 && udp_send_batch_handle(socket, socket->ipv6, datagrams, count))
+		result = -1;
+	return result;
+#else
+	s32 result = 0;
+	for (s32 i = 0; i < count; i++)
+	{
+		if (udp_send(socket, datagrams[i].address, datagrams[i].data, datagrams[i].size))
+			result = -1;
+	}
+	return result;
+#endif
+}
+
+s32 udp_receive_batch(Handle* socket, Datagram* datagrams, s32 count)
+{
+	vi_assert(count <= NET_MAX_DATAGRAM_BATCH);
+#if defined(__linux__)
+	if (!socket->ipv6)
+		return socket->ipv4 ? udp_receive_batch_handle(socket->ipv4, datagrams, count) : 0;
+	if (!socket->ipv4)
+		return udp_receive_batch_handle(socket->ipv6, datagrams, count);
+
+	// ipv4 gets half the batch up front so a busy ipv4 socket can't starve ipv6.
+	// ipv6 gets whatever ipv4 didn't use, and if ipv4 filled its half, it gets whatever ipv6 left
+	s32 ipv4_count = (count + 1) / 2;
+	s32 received = udp_receive_batch_handle(socket->ipv4, datagrams, ipv4_count);
+	b8 ipv4_full = received == ipv4_count;
+	received += udp_receive_batch_handle(socket->ipv6, &datagrams[received], count - received);
+	if (ipv4_full && received < count)
+		received += udp_receive_batch_handle(socket->ipv4, &datagrams[received], count - received);
+	return received;
+#else
+	s32 received = 0;
+	while (received < count)
+	{
+		Datagram* datagram = &datagrams[received];
+		s32 bytes = udp_receive(socket, &datagram->address, datagram->data, datagram->size);
+		if (bytes <= 0)
+			break;
+		datagram->size = bytes;
+		received++;
+	}
+	return received;
+#endif
 }
 
 }
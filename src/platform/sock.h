@@ -3,6 +3,7 @@
 #include "net_serialize.h"
 
 #define NET_MAX_ADDRESS 68
+#define NET_MAX_DATAGRAM_BATCH 32
 
 namespace VI
 {
@@ -84,6 +85,13 @@ struct Handle
 	u64 ipv6;
 };
 
+struct Datagram
+{
+	Address address;
+	void* data;
+	s32 size; // when receiving, the buffer size going in and the number of bytes received coming out
+};
+
 const char* get_error(void);
 void init();
 void netshutdown(void);
@@ -93,6 +101,8 @@ void close(Handle*);
 s32 udp_open(Handle*, u32 = 0);
 s32 udp_send(Handle*, const Address&, const void*, s32);
 s32 udp_receive(Handle*, Address*, void*, s32);
+s32 udp_send_batch(Handle*, const Datagram*, s32); // at most NET_MAX_DATAGRAM_BATCH
+s32 udp_receive_batch(Handle*, Datagram*, s32); // returns the number of datagrams received; at most NET_MAX_DATAGRAM_BATCH
 
 
 }
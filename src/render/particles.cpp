@@ -154,25 +154,35 @@ void ParticleSystem::update()
 	}
 }
 
-void ParticleSystem::draw(const RenderParams& params)
+// send new particles to GPU.
+// done once per frame before any camera draws, so draw() doesn't modify the system and cameras can record in parallel
+void ParticleSystem::upload_all(RenderSync* sync)
+{
+	for (s32 i = 0; i < list.length; i++)
+		list[i]->upload(sync);
+}
+
+void ParticleSystem::upload(RenderSync* sync)
 {
 	if (first_new != first_free)
 	{
-		// send new particles to GPU
 		if (first_new < first_free)
 		{
 			// all in one range
-			upload_range(params.sync, first_new * vertices_per_particle, (first_free - first_new) * vertices_per_particle);
+			upload_range(sync, first_new * vertices_per_particle, (first_free - first_new) * vertices_per_particle);
 		}
 		else
 		{
 			// split in two ranges
-			upload_range(params.sync, 0, first_free * vertices_per_particle);
-			upload_range(params.sync, first_new * vertices_per_particle, (MAX_PARTICLES - first_new) * vertices_per_particle);
+			upload_range(sync, 0, first_free * vertices_per_particle);
+			upload_range(sync, first_new * vertices_per_particle, (MAX_PARTICLES - first_new) * vertices_per_particle);
 		}
 		first_new = first_free;
 	}
+}
 
+void ParticleSystem::draw(const RenderParams& params)
+{
 	Loader::shader(shader);
 	Loader::texture(texture);
 
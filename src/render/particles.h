@@ -14,6 +14,8 @@ struct ParticleSystem
 	static StaticArray<ParticleSystem*, MAX_PARTICLE_SYSTEMS> list;
 	static r32 time;
 
+	static void upload_all(RenderSync*);
+
 	s32 vertices_per_particle;
 	s32 indices_per_particle;
 	Array<Vec3> positions;
@@ -33,6 +35,7 @@ struct ParticleSystem
 
 	void update();
 	void upload_range(RenderSync*, s32, s32);
+	void upload(RenderSync*);
 	void draw(const RenderParams&);
 	virtual b8 pre_draw(const RenderParams&) { return true; }
 	void add_raw(const Vec3&, const Vec4& = Vec4::zero, const Vec4& = Vec4::zero, r32 = 0.0f);
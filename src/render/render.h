@@ -5,6 +5,7 @@
 #include "sync.h"
 #include "input.h"
 #include "glvm.h"
+#include "render_filter.h"
 
 namespace VI
 {
@@ -135,6 +136,7 @@ struct LoopSync : RenderSync
 	DisplayMode display_mode;
 	InputState input;
 	WindowMode window_mode;
+	RenderFilterStats render_stats; // filled in by the render thread the last time it executed this buffer
 	b8 vsync;
 	b8 quit;
 	b8 minimize;
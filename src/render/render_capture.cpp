@@ -0,0 +1,84 @@
+#include "render_capture.h"
+#include "vi_assert.h"
+
+namespace VI
+{
+
+RenderCapture::RenderCapture()
+	: header(), file(), bytes_written()
+{
+}
+
+RenderCapture::~RenderCapture()
+{
+	close();
+}
+
+b8 RenderCapture::write_open(const char* path, s32 width, s32 height)
+{
+	close();
+	file = fopen(path, "wb");
+	if (!file)
+		return false;
+	header.magic = magic;
+	header.version = version;
+	header.width = width;
+	header.height = height;
+	fwrite(&header, sizeof(Header), 1, file);
+	bytes_written = sizeof(Header);
+	return true;
+}
+
+b8 RenderCapture::write(const RenderSync* sync)
+{
+	vi_assert(file);
+	s32 length = sync->queue.length;
+	if (bytes_written + s64(sizeof(s32)) + s64(length) > max_bytes)
+	{
+		close();
+		return false;
+	}
+	fwrite(&length, sizeof(s32), 1, file);
+	fwrite(sync->queue.data, sizeof(u8), length, file);
+	bytes_written += s64(sizeof(s32)) + s64(length);
+	return true;
+}
+
+b8 RenderCapture::read_open(const char* path)
+{
+	close();
+	file = fopen(path, "rb");
+	if (!file)
+		return false;
+	if (fread(&header, sizeof(Header), 1, file) != 1
+		|| header.magic != magic
+		|| header.version != version)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+b8 RenderCapture::read(RenderSync* sync)
+{
+	vi_assert(file);
+	sync->queue.length = 0;
+	sync->read_pos = 0;
+	s32 length;
+	if (fread(&length, sizeof(s32), 1, file) != 1 || length < 0)
+		return false;
+	sync->queue.resize(length);
+	return s32(fread(sync->queue.data, sizeof(u8), length, file)) == length;
+}
+
+void RenderCapture::close()
+{
+	if (file)
+	{
+		fclose(file);
+		file = nullptr;
+	}
+}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "glvm.h"
+#include <stdio.h>
+
+namespace VI
+{
+
+// raw RenderSync buffers, one per frame, exactly as the render thread received them.
+// recording starts with the first frame so the Alloc*/Load* ops that set up every resource are included.
+// layout: Header, then for each frame an s32 byte count followed by the buffer.
+struct RenderCapture
+{
+	static const u32 magic = 0x50414352; // "RCAP"
+	static const s32 version = 2; // bump whenever a RenderOp or its payload changes
+	static const s64 max_bytes = s64(1) << 30; // recording stops once the file reaches this size
+
+	struct Header
+	{
+		u32 magic;
+		s32 version;
+		s32 width;
+		s32 height;
+	};
+
+	Header header;
+	FILE* file;
+	s64 bytes_written;
+
+	RenderCapture();
+	~RenderCapture();
+
+	b8 write_open(const char*, s32, s32);
+	b8 write(const RenderSync*); // false once the file is full; it's closed after that
+	b8 read_open(const char*);
+	b8 read(RenderSync*); // false at the end of the file, or if the last frame is cut off
+	void close();
+};
+
+}
@@ -0,0 +1,454 @@
+#include "render_filter.h"
+#include "vi_assert.h"
+#include <string.h>
+
+namespace VI
+{
+
+RenderFilter::RenderFilter()
+	: meshes(), shaders(), samplers()
+{
+	reset();
+}
+
+RenderFilter::~RenderFilter()
+{
+	reset();
+}
+
+void RenderFilter::reset()
+{
+	for (s32 i = 0; i < meshes.length; i++)
+		meshes[i].~Mesh();
+	meshes.length = 0;
+	for (s32 i = 0; i < shaders.length; i++)
+		shaders[i].~Shader();
+	shaders.length = 0;
+	samplers.length = 0;
+	known = 0;
+	shader = AssetNull;
+	technique = RenderTechnique::Default;
+}
+
+// reads a fixed-size header field. if it would run off the end of the queue, flags the op invalid and returns zero
+template<typename T> T filter_read(RenderSync* sync, b8* valid)
+{
+	if (!*valid || sync->read_pos + s32(sizeof(T)) > sync->queue.length)
+	{
+		*valid = false;
+		return T();
+	}
+	return *(sync->read<T>());
+}
+
+// reads a state value. true if the op needs to go through; records the new value either way
+template<typename T> b8 filter_state(RenderFilter* f, RenderOp op, T* current, RenderSync* sync, b8* valid)
+{
+	T value = filter_read<T>(sync, valid);
+	if (!*valid)
+		return true;
+	u64 bit = u64(1) << s32(op);
+	if ((f->known & bit) && memcmp(current, &value, sizeof(T)) == 0)
+		return false;
+	f->known |= bit;
+	*current = value;
+	return true;
+}
+
+void filter_shader_uniforms_clear(RenderFilter* f, AssetID id)
+{
+	if (id >= 0 && id < f->shaders.length)
+	{
+		for (s32 i = 0; i < s32(RenderTechnique::count); i++)
+		{
+			Array<RenderFilter::Uniform>* uniforms = &f->shaders[id].uniforms[i];
+			for (s32 j = 0; j < uniforms->length; j++)
+				(*uniforms)[j].size = 0;
+		}
+	}
+}
+
+// null if the id doesn't refer to a mesh we've seen allocated
+const RenderFilter::Mesh* filter_mesh(const RenderFilter* f, AssetID id)
+{
+	if (id < 0 || id >= f->meshes.length)
+		return nullptr;
+	return &f->meshes[id];
+}
+
+// skips a payload of count elements of size bytes each. negative counts and payloads running off the end are invalid
+void filter_skip(RenderSync* sync, s32 count, s32 size, b8* valid)
+{
+	if (*valid && count >= 0 && (size == 0 || count <= (sync->queue.length - sync->read_pos) / size))
+		sync->read_pos += count * size;
+	else
+		*valid = false;
+}
+
+b8 RenderFilter::filter(RenderSync* sync, RenderFilterStats* stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	stats->bytes_in = sync->queue.length;
+
+	s32 write_pos = 0;
+	sync->read_pos = 0;
+	while (sync->read_pos < sync->queue.length)
+	{
+		s32 op_start = sync->read_pos;
+		RenderOp op = *(sync->read<RenderOp>());
+		b8 keep = true;
+		b8 valid = true;
+		switch (op)
+		{
+			case RenderOp::AllocUniform:
+			{
+				sync->read<AssetID>();
+				s32 length = filter_read<s32>(sync, &valid);
+				filter_skip(sync, length, sizeof(char), &valid);
+				break;
+			}
+			case RenderOp::AllocMesh:
+			{
+				AssetID id = filter_read<AssetID>(sync, &valid);
+				if (!valid || id < 0)
+				{
+					valid = false;
+					break;
+				}
+				if (id >= meshes.length)
+					meshes.resize(id + 1);
+				Mesh* mesh = &meshes[id];
+				mesh->attrib_sizes.length = 0;
+				mesh->vertex_size = 0;
+				sync->read<b8>(); // dynamic
+				s32 attrib_count = filter_read<s32>(sync, &valid);
+				for (s32 i = 0; i < attrib_count; i++)
+				{
+					RenderDataType data_type = filter_read<RenderDataType>(sync, &valid);
+					s32 element_count = filter_read<s32>(sync, &valid);
+					if (!valid || s32(data_type) < 0 || data_type >= RenderDataType::count || element_count < 0)
+					{
+						valid = false;
+						break;
+					}
+					s64 size = s64(render_data_type_size(data_type)) * s64(element_count);
+					if (s64(mesh->vertex_size) + size > s64(0x7fffffff))
+					{
+						valid = false;
+						break;
+					}
+					mesh->attrib_sizes.add(s32(size));
+					mesh->vertex_size += s32(size);
+				}
+				break;
+			}
+			case RenderOp::FreeMesh:
+			{
+				AssetID id = filter_read<AssetID>(sync, &valid);
+				if (valid && filter_mesh(this, id))
+				{
+					meshes[id].attrib_sizes.length = 0;
+					meshes[id].vertex_size = 0;
+				}
+				else
+					valid = false;
+				break;
+			}
+			case RenderOp::AllocInstances:
+			case RenderOp::MeshEdges:
+			case RenderOp::Instances:
+			case RenderOp::InstancesEdges:
+			case RenderOp::AllocTexture:
+			case RenderOp::FreeTexture:
+			case RenderOp::FreeFramebuffer:
+			{
+				sync->read<AssetID>();
+				break;
+			}
+			case RenderOp::UpdateAttribBuffers:
+			{
+				const Mesh* mesh = filter_mesh(this, filter_read<AssetID>(sync, &valid));
+				s32 count = filter_read<s32>(sync, &valid);
+				if (mesh)
+					filter_skip(sync, count, mesh->vertex_size, &valid);
+				else
+					valid = false;
+				break;
+			}
+			case RenderOp::UpdateAttribSubBuffers:
+			{
+				const Mesh* mesh = filter_mesh(this, filter_read<AssetID>(sync, &valid));
+				sync->read<s32>(); // offset
+				s32 count = filter_read<s32>(sync, &valid);
+				if (mesh)
+					filter_skip(sync, count, mesh->vertex_size, &valid);
+				else
+					valid = false;
+				break;
+			}
+			case RenderOp::UpdateAttribBuffer:
+			{
+				const Mesh* mesh = filter_mesh(this, filter_read<AssetID>(sync, &valid));
+				s32 attrib_index = filter_read<s32>(sync, &valid);
+				s32 count = filter_read<s32>(sync, &valid);
+				if (mesh && attrib_index >= 0 && attrib_index < mesh->attrib_sizes.length)
+					filter_skip(sync, count, mesh->attrib_sizes[attrib_index], &valid);
+				else
+					valid = false;
+				break;
+			}
+			case RenderOp::UpdateAttribSubBuffer:
+			{
+				const Mesh* mesh = filter_mesh(this, filter_read<AssetID>(sync, &valid));
+				s32 attrib_index = filter_read<s32>(sync, &valid);
+				sync->read<s32>(); // offset
+				s32 count = filter_read<s32>(sync, &valid);
+				if (mesh && attrib_index >= 0 && attrib_index < mesh->attrib_sizes.length)
+					filter_skip(sync, count, mesh->attrib_sizes[attrib_index], &valid);
+				else
+					valid = false;
+				break;
+			}
+			case RenderOp::UpdateIndexBuffer:
+			case RenderOp::UpdateEdgesIndexBuffer:
+			{
+				sync->read<AssetID>();
+				s32 index_count = filter_read<s32>(sync, &valid);
+				filter_skip(sync, index_count, sizeof(s32), &valid);
+				break;
+			}
+			case RenderOp::DynamicTexture:
+			{
+				sync->read<AssetID>();
+				sync->read<s32>(); // width
+				sync->read<s32>(); // height
+				sync->read<RenderDynamicTextureType>();
+				sync->read<RenderTextureWrap>();
+				sync->read<RenderTextureFilter>();
+				sync->read<RenderTextureCompare>();
+				break;
+			}
+			case RenderOp::LoadTexture:
+			{
+				sync->read<AssetID>();
+				sync->read<RenderTextureWrap>();
+				sync->read<RenderTextureFilter>();
+				u32 width = filter_read<u32>(sync, &valid);
+				u32 height = filter_read<u32>(sync, &valid);
+				if (width > 0xffff || height > 0xffff) // keeps 4 * width * height from overflowing
+					valid = false;
+				else
+					filter_skip(sync, s32(height), s32(4 * width), &valid);
+				break;
+			}
+			case RenderOp::LoadShader:
+			{
+				// a recompiled program starts over with default uniform values
+				AssetID id = filter_read<AssetID>(sync, &valid);
+				filter_shader_uniforms_clear(this, id);
+				s32 code_length = filter_read<s32>(sync, &valid);
+				filter_skip(sync, code_length, sizeof(char), &valid);
+				break;
+			}
+			case RenderOp::FreeShader:
+			{
+				AssetID id = filter_read<AssetID>(sync, &valid);
+				filter_shader_uniforms_clear(this, id);
+				break;
+			}
+			case RenderOp::Clear:
+			{
+				sync->read<b8>(); // color
+				sync->read<b8>(); // depth
+				break;
+			}
+			case RenderOp::Shader:
+			{
+				AssetID shader_asset = filter_read<AssetID>(sync, &valid);
+				RenderTechnique shader_technique = filter_read<RenderTechnique>(sync, &valid);
+				u64 bit = u64(1) << s32(RenderOp::Shader);
+				if (!valid || shader_asset < 0 || s32(shader_technique) < 0 || shader_technique >= RenderTechnique::count)
+					valid = false;
+				else if ((known & bit) && shader_asset == shader && shader_technique == technique)
+					keep = false;
+				else
+				{
+					// glvm starts handing out texture units from scratch
+					known |= bit;
+					shader = shader_asset;
+					technique = shader_technique;
+					samplers.length = 0;
+				}
+				break;
+			}
+			case RenderOp::Uniform:
+			{
+				AssetID uniform_asset = filter_read<AssetID>(sync, &valid);
+				s32 value_start = sync->read_pos;
+				RenderDataType uniform_type = filter_read<RenderDataType>(sync, &valid);
+				s32 uniform_count = filter_read<s32>(sync, &valid);
+				if (uniform_type == RenderDataType::Texture)
+				{
+					if (uniform_count != 1) // only single textures supported for now
+						valid = false;
+					sync->read<RenderTextureType>();
+					AssetID texture_asset = filter_read<AssetID>(sync, &valid);
+					if (valid && (known & (u64(1) << s32(RenderOp::Shader))))
+					{
+						// glvm won't rebind a texture it already gave a sampler to
+						for (s32 i = 0; i < samplers.length; i++)
+						{
+							if (samplers[i] == texture_asset)
+							{
+								keep = false;
+								break;
+							}
+						}
+						if (keep)
+							samplers.add(texture_asset);
+					}
+				}
+				else if (!valid || uniform_asset < 0 || s32(uniform_type) < 0 || uniform_type >= RenderDataType::count || uniform_count < 0)
+					valid = false;
+				else
+				{
+					filter_skip(sync, uniform_count, render_data_type_size(uniform_type), &valid);
+					if ((known & (u64(1) << s32(RenderOp::Shader))) && sync->read_pos <= sync->queue.length)
+					{
+						// programs keep their uniform values across shader switches, so these are cached per program
+						if (shader >= shaders.length)
+							shaders.resize(shader + 1);
+						Array<Uniform>* uniforms = &shaders[shader].uniforms[s32(technique)];
+						if (uniform_asset >= uniforms->length)
+							uniforms->resize(uniform_asset + 1); // new entries are zeroed, i.e. unknown
+						Uniform* cached = &(*uniforms)[uniform_asset];
+						s32 size = sync->read_pos - value_start;
+						const u8* value = &sync->queue[value_start];
+						if (size == cached->size && memcmp(cached->value, value, size) == 0)
+							keep = false;
+						else if (size <= uniform_cache_size)
+						{
+							memcpy(cached->value, value, size);
+							cached->size = size;
+						}
+						else
+							cached->size = 0;
+					}
+				}
+				break;
+			}
+			case RenderOp::Mesh:
+			{
+				sync->read<RenderPrimitiveMode>();
+				sync->read<AssetID>();
+				break;
+			}
+			case RenderOp::SubMesh:
+			{
+				sync->read<AssetID>();
+				sync->read<s32>(); // index offset
+				sync->read<s32>(); // index count
+				break;
+			}
+			case RenderOp::UpdateInstances:
+			{
+				sync->read<AssetID>();
+				s32 instance_count = filter_read<s32>(sync, &valid);
+				filter_skip(sync, instance_count, sizeof(InstanceVertex), &valid);
+				break;
+			}
+			case RenderOp::UpdateBoneBuffer:
+			{
+				s32 count = filter_read<s32>(sync, &valid);
+				filter_skip(sync, count, sizeof(Vec4), &valid);
+				break;
+			}
+			case RenderOp::AllocFramebuffer:
+			{
+				sync->read<AssetID>();
+				s32 attachments = filter_read<s32>(sync, &valid);
+				filter_skip(sync, attachments, sizeof(RenderFramebufferAttachment) + sizeof(AssetID), &valid); // attachment type and texture per attachment
+				break;
+			}
+			case RenderOp::BlitFramebuffer:
+			{
+				sync->read<AssetID>();
+				sync->read<Rect2>(); // source
+				sync->read<Rect2>(); // destination
+				break;
+			}
+
+			// render states; these mirror the checks glvm makes before touching GL
+
+			case RenderOp::Viewport:
+				keep = filter_state(this, op, &viewport, sync, &valid);
+				break;
+			case RenderOp::ColorMask:
+				keep = filter_state(this, op, &color_mask, sync, &valid);
+				break;
+			case RenderOp::DepthMask:
+				keep = filter_state(this, op, &depth_mask, sync, &valid);
+				break;
+			case RenderOp::DepthTest:
+				keep = filter_state(this, op, &depth_test, sync, &valid);
+				break;
+			case RenderOp::DepthFunc:
+				keep = filter_state(this, op, &depth_func, sync, &valid);
+				break;
+			case RenderOp::BlendMode:
+				keep = filter_state(this, op, &blend_mode, sync, &valid);
+				break;
+			case RenderOp::CullMode:
+				keep = filter_state(this, op, &cull_mode, sync, &valid);
+				break;
+			case RenderOp::FillMode:
+				keep = filter_state(this, op, &fill_mode, sync, &valid);
+				break;
+			case RenderOp::PointSize:
+				keep = filter_state(this, op, &point_size, sync, &valid);
+				break;
+			case RenderOp::LineWidth:
+				keep = filter_state(this, op, &line_width, sync, &valid);
+				break;
+			case RenderOp::PolygonOffset:
+				keep = filter_state(this, op, &polygon_offset, sync, &valid);
+				break;
+			case RenderOp::BindFramebuffer:
+				keep = filter_state(this, op, &framebuffer, sync, &valid);
+				break;
+			default:
+			{
+				valid = false;
+				break;
+			}
+		}
+
+		// counts come straight out of the buffer; a bad one can send us backward or off the end
+		if (!valid || sync->read_pos <= op_start || sync->read_pos > sync->queue.length)
+		{
+			sync->queue.length = write_pos;
+			sync->read_pos = 0;
+			stats->bytes_out = write_pos;
+			return false;
+		}
+
+		stats->ops_in++;
+		if (keep)
+		{
+			s32 op_size = sync->read_pos - op_start;
+			if (write_pos != op_start)
+				memmove(&sync->queue[write_pos], &sync->queue[op_start], op_size);
+			write_pos += op_size;
+			stats->ops_out++;
+		}
+		else
+			stats->elided[s32(op)]++;
+	}
+
+	sync->queue.length = write_pos;
+	sync->read_pos = 0;
+	stats->bytes_out = write_pos;
+	return true;
+}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "glvm.h"
+
+namespace VI
+{
+
+struct RenderFilterStats
+{
+	s32 ops_in;
+	s32 ops_out;
+	s32 bytes_in;
+	s32 bytes_out;
+	s32 elided[s32(RenderOp::count)];
+};
+
+// strips ops out of a RenderSync that can't change anything once they reach glvm:
+// state changes to the value glvm already has, shader binds of the bound shader,
+// uniform uploads identical to the value the program already holds,
+// and texture uniforms for textures already bound to a sampler since the last shader change.
+// never touches GL, so it can run over captured buffers.
+// state carries over between buffers; it has to see every buffer glvm executes, in order.
+struct RenderFilter
+{
+	static const s32 uniform_cache_size = sizeof(RenderDataType) + sizeof(s32) + sizeof(Mat4); // larger uploads (arrays) are never cached
+
+	struct Uniform
+	{
+		u8 value[uniform_cache_size]; // type, count, and data, exactly as written to the sync buffer
+		s32 size; // 0 if unknown
+	};
+
+	struct Shader
+	{
+		Array<Uniform> uniforms[s32(RenderTechnique::count)];
+	};
+
+	struct Mesh
+	{
+		Array<s32> attrib_sizes; // bytes per vertex in each attrib buffer
+		s32 vertex_size;
+	};
+
+	Array<Mesh> meshes;
+	Array<Shader> shaders;
+	Array<AssetID> samplers;
+	u64 known; // bit per state RenderOp; set once we've seen a value for it
+
+	AssetID shader;
+	RenderTechnique technique;
+	Rect2 viewport;
+	RenderColorMask color_mask;
+	b8 depth_mask;
+	b8 depth_test;
+	RenderDepthFunc depth_func;
+	RenderBlendMode blend_mode;
+	RenderCullMode cull_mode;
+	RenderFillMode fill_mode;
+	r32 point_size;
+	r32 line_width;
+	Vec2 polygon_offset;
+	AssetID framebuffer;
+
+	RenderFilter();
+	~RenderFilter();
+
+	void reset();
+	b8 filter(RenderSync*, RenderFilterStats*); // compacts the buffer in place. false if the buffer is malformed; everything from the bad op on is dropped
+};
+
+}
@@ -28,6 +28,7 @@ SkinnedModel::SkinnedModel()
 	offset(Mat4::identity),
 	color(-1, -1, -1, -1),
 	mask(RENDER_MASK_DEFAULT),
+	bone_offset(-1),
 	team(s8(AI::TeamNone))
 {
 }
@@ -55,6 +56,52 @@ SkinnedModel::~SkinnedModel()
 	alpha_disable();
 }
 
+// skinning palettes for every model, computed once per frame before any camera draws.
+// every pass references its model's palette by offset instead of uploading it again.
+// a bone is stored as the top three rows of its skinning matrix, which is all armature.glsl reads
+void SkinnedModel::upload_all(RenderSync* sync)
+{
+	s32 bone_count = 0;
+	for (auto i = list.iterator(); !i.is_last(); i.next())
+	{
+		SkinnedModel* model = i.item();
+		const Animator* animator = model->get<Animator>();
+		if (animator->bones.length > 0 && Loader::armature(animator->armature))
+		{
+			model->bone_offset = bone_count;
+			bone_count += animator->bones.length;
+		}
+		else
+			model->bone_offset = -1;
+	}
+
+	if (bone_count == 0)
+		return;
+
+	vi_assert(bone_count * 3 <= 65536); // smallest GL_MAX_TEXTURE_BUFFER_SIZE allowed
+
+	sync->write(RenderOp::UpdateBoneBuffer);
+	sync->write<s32>(bone_count * 3);
+	Vec4* rows = sync->alloc<Vec4>(bone_count * 3);
+	for (auto i = list.iterator(); !i.is_last(); i.next())
+	{
+		const SkinnedModel* model = i.item();
+		if (model->bone_offset == -1)
+			continue;
+
+		const Animator* animator = model->get<Animator>();
+		const Armature* arm = Loader::armature(animator->armature);
+		for (s32 j = 0; j < animator->bones.length; j++)
+		{
+			Mat4 m = arm->inverse_bind_pose[j] * animator->bones[j];
+			Vec4* bone = &rows[(model->bone_offset + j) * 3];
+			// Mat4 is [row][col] with translation in the last row; the shader sees it transposed
+			for (s32 k = 0; k < 3; k++)
+				bone[k] = Vec4(m.m[0][k], m.m[1][k], m.m[2][k], m.m[3][k]);
+		}
+	}
+}
+
 void SkinnedModel::draw_opaque(const RenderParams& params)
 {
 	for (auto i = SkinnedModel::list.iterator(); !i.is_last(); i.next())
@@ -156,7 +203,7 @@ void SkinnedModel::alpha_mode(AlphaMode m)
 
 void SkinnedModel::draw(const RenderParams& params, ObstructingBehavior b)
 {
-	if (!(params.camera->mask & mask))
+	if (!(params.camera->mask & mask) || bone_offset == -1)
 		return;
 
 	RenderSync* sync = params.sync;
@@ -224,18 +271,11 @@ void SkinnedModel::draw(const RenderParams& params, ObstructingBehavior b)
 	sync->write<RenderTextureType>(RenderTextureType::Texture2D);
 	sync->write<AssetID>(texture);
 
-	const Armature* arm = Loader::armature(get<Animator>()->armature);
-	const Array<Mat4>& bones = get<Animator>()->bones;
-	StaticArray<Mat4, MAX_BONES> skin_transforms;
-	skin_transforms.resize(bones.length);
-	for (s32 i = 0; i < bones.length; i++)
-		skin_transforms[i] = arm->inverse_bind_pose[i] * bones[i];
-
 	sync->write(RenderOp::Uniform);
-	sync->write(Asset::Uniform::bones);
-	sync->write(RenderDataType::Mat4);
-	sync->write<s32>(skin_transforms.length);
-	sync->write(skin_transforms.data, skin_transforms.length);
+	sync->write(Asset::Uniform::bone_offset);
+	sync->write(RenderDataType::S32);
+	sync->write<s32>(1);
+	sync->write<s32>(bone_offset);
 
 	sync->write(RenderOp::Uniform);
 	sync->write(Asset::Uniform::diffuse_color);
@@ -280,6 +320,7 @@ void SkinnedModel::draw(const RenderParams& params, ObstructingBehavior b)
 	}
 
 #if DEBUG_SKIN
+	const Array<Mat4>& bones = get<Animator>()->bones;
 	for (s32 i = 0; i < bones.length; i++)
 	{
 		Mat4 bone_transform = bones[i] * m;
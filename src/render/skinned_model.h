@@ -20,6 +20,7 @@ struct SkinnedModel : public ComponentType<SkinnedModel>
 	static Bitmask<MAX_ENTITIES> list_alpha_if_obstructing;
 	static Bitmask<MAX_ENTITIES> list_additive;
 
+	static void upload_all(RenderSync*);
 	static void draw_opaque(const RenderParams&);
 	static void draw_alpha(const RenderParams&);
 	static void draw_additive(const RenderParams&);
@@ -33,6 +34,7 @@ struct SkinnedModel : public ComponentType<SkinnedModel>
 	AssetID shader;
 	AssetID texture;
 	RenderMask mask;
+	s32 bone_offset; // start of this frame's skinning palette in the bone buffer, in bones. -1 if there isn't one
 	s8 team;
 
 	SkinnedModel();
@@ -593,10 +593,10 @@ const Vec4& UI::color_ping(r32 p)
 r32 UI::scale = 1.0f;
 AssetID UI::mesh_id = AssetNull;
 AssetID UI::texture_mesh_id = AssetNull;
-Array<Vec3> UI::vertices;
-Array<Vec4> UI::colors;
-Array<s32> UI::indices;
-Array<UI::TextureBlit> UI::texture_blits;
+thread_local Array<Vec3> UI::vertices;
+thread_local Array<Vec4> UI::colors;
+thread_local Array<s32> UI::indices;
+thread_local Array<UI::TextureBlit> UI::texture_blits;
 
 void UI::box(const RenderParams& params, const Rect2& r, const Vec4& color)
 {
@@ -1102,7 +1102,6 @@ void UI::draw(const RenderParams& p)
 		if (project(p, debugs[i], &projected))
 			centered_box(p, { projected, Vec2(4, 4) * scale });
 	}
-	debugs.length = 0;
 #endif
 
 	// draw sprites
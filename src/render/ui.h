@@ -111,10 +111,11 @@ struct UI
 	static r32 scale;
 	static AssetID mesh_id;
 	static AssetID texture_mesh_id;
-	static Array<Vec3> vertices;
-	static Array<Vec4> colors;
-	static Array<s32> indices;
-	static Array<TextureBlit> texture_blits;
+	// filled while a camera records and flushed by draw(), so every recording thread gets its own
+	static thread_local Array<Vec3> vertices;
+	static thread_local Array<Vec4> colors;
+	static thread_local Array<s32> indices;
+	static thread_local Array<TextureBlit> texture_blits;
 	static void init(LoopSync*);
 	static r32 get_scale(s32, s32);
 	static void get_line_width_point_size(const Rect2&, r32*, r32*);
@@ -150,7 +151,7 @@ struct UI
 	static Vec2 indicator(const RenderParams&, const Vec3&, const Vec4&, b8, r32 = 1.0f, r32 = 0.0f);
 
 #if DEBUG
-	static Array<Vec3> debugs;
+	static Array<Vec3> debugs; // drawn by every camera; cleared once the frame is recorded
 	static void debug(const Vec3&);
 #endif
 };
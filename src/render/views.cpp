@@ -17,6 +17,8 @@ namespace VI
 
 Bitmask<MAX_ENTITIES> View::list_alpha;
 Bitmask<MAX_ENTITIES> View::list_additive;
+thread_local Array<View::InstanceEntry> View::instance_queue;
+thread_local Array<View::InstanceEntry> View::instance_queue_sorted;
 #if DEBUG_VIEW
 Array<View::DebugEntry> View::debug_entries;
 #endif
@@ -55,8 +57,9 @@ void View::draw_opaque(const RenderParams& params)
 	for (auto i = list.iterator(); !i.is_last(); i.next())
 	{
 		if (!list_alpha.get(i.index) && !list_additive.get(i.index) && (i.item()->mask & params.camera->mask))
-			i.item()->draw(params);
+			i.item()->draw_queue(params);
 	}
+	instances_flush(params);
 }
 
 void View::draw_additive(const RenderParams& params)
@@ -64,14 +67,16 @@ void View::draw_additive(const RenderParams& params)
 	for (auto i = list.iterator(); !i.is_last(); i.next())
 	{
 		if (list_additive.get(i.index) && (i.item()->mask & params.camera->mask))
-			i.item()->draw(params);
+			i.item()->draw_queue(params);
 	}
+	instances_flush(params);
 }
 
 void View::draw_alpha(const RenderParams& params)
 {
 	for (auto i = list.iterator(); !i.is_last(); i.next())
 	{
+		// alpha blending depends on draw order, so don't batch these
 		if (list_alpha.get(i.index) && (i.item()->mask & params.camera->mask))
 			i.item()->draw(params);
 	}
@@ -92,8 +97,9 @@ void View::draw_filtered(const RenderParams& params, Filter* filter)
 	for (auto i = list.iterator(); !i.is_last(); i.next())
 	{
 		if (filter(params, i.item()))
-			i.item()->draw(params);
+			i.item()->draw_queue(params);
 	}
+	instances_flush(params);
 }
 
 void View::alpha()
@@ -230,34 +236,155 @@ void View::debug(AssetID mesh, const Vec3& pos, const Quat& rot, const Vec3& sca
 }
 #endif
 
-void View::draw(const RenderParams& params) const
+// instanced version of the given shader, or AssetNull if there isn't one
+AssetID shader_instanced(AssetID shader)
+{
+	if (shader == Asset::Shader::standard)
+		return Asset::Shader::standard_instanced;
+	else if (shader == Asset::Shader::culled)
+		return Asset::Shader::culled_instanced;
+	else if (shader == Asset::Shader::flat)
+		return Asset::Shader::flat_instanced;
+	else
+		return AssetNull;
+}
+
+void write_culling_uniforms(const RenderParams& params)
+{
+	RenderSync* sync = params.sync;
+
+	sync->write(RenderOp::Uniform);
+	sync->write(Asset::Uniform::range_center);
+	sync->write(RenderDataType::Vec3);
+	sync->write<s32>(1);
+	sync->write<Vec3>(params.camera->range_center);
+
+	sync->write(RenderOp::Uniform);
+	sync->write(Asset::Uniform::cull_center);
+	sync->write(RenderDataType::Vec3);
+	sync->write<s32>(1);
+	sync->write<Vec3>(params.camera->cull_center);
+
+	sync->write(RenderOp::Uniform);
+	sync->write(Asset::Uniform::cull_radius);
+	sync->write(RenderDataType::R32);
+	sync->write<s32>(1);
+	sync->write<r32>(params.camera->cull_range);
+
+	sync->write(RenderOp::Uniform);
+	sync->write(Asset::Uniform::wall_normal);
+	sync->write(RenderDataType::Vec3);
+	sync->write<s32>(1);
+	sync->write<Vec3>(params.camera->clip_planes[0].normal);
+
+	sync->write(RenderOp::Uniform);
+	sync->write(Asset::Uniform::cull_behind_wall);
+	sync->write(RenderDataType::S32);
+	sync->write<s32>(1);
+	sync->write<s32>(params.camera->flag(CameraFlagCullBehindWall));
+
+	sync->write(RenderOp::Uniform);
+	sync->write(Asset::Uniform::frontface);
+	sync->write(RenderDataType::S32);
+	sync->write<s32>(1);
+	sync->write<s32>(!(params.flags & RenderFlagBackFace));
+}
+
+inline u64 instance_key(AssetID mesh, AssetID shader, AssetID texture)
+{
+	return (u64(u16(mesh)) << 32) | (u64(u16(shader)) << 16) | u64(u16(texture));
+}
+
+inline s32 instance_key_hash(u64 key)
+{
+	return s32((u32(key >> 32) * 73856093u) ^ (u32(key >> 16) * 19349663u) ^ (u32(key) * 83492791u)) & (View::instance_bucket_count - 1);
+}
+
+// returns false if the view is culled
+b8 View::draw_prepare(const RenderParams& params, Mat4* m, AssetID* shader_actual, Vec4* color_final) const
 {
 	if (mesh == AssetNull || shader == AssetNull)
-		return;
+		return false;
 
 	const Mesh* mesh_data = Loader::mesh(mesh);
 
-	Mat4 m;
-	get<Transform>()->mat(&m);
-	m = offset * m;
+	get<Transform>()->mat(m);
+	*m = offset * *m;
 
 	{
 		r32 r = radius == 0.0f ? mesh_data->bounds_radius : radius;
 		Vec3 r3d = (offset * Vec4(r, r, r, 1)).xyz();
-		if (!params.camera->visible_sphere(m.translation(), vi_max(r3d.x, vi_max(r3d.y, r3d.z))))
-			return;
+		if (!params.camera->visible_sphere(m->translation(), vi_max(r3d.x, vi_max(r3d.y, r3d.z))))
+			return false;
 	}
 
 	// if allow_culled_shader is false, replace the culled shader with the standard shader.
 	b8 allow_culled_shader = params.camera->cull_range > 0.0f && !(params.flags & RenderFlagEdges);
-	AssetID shader_actual = allow_culled_shader || shader != Asset::Shader::culled ? shader : Asset::Shader::standard;
+	*shader_actual = allow_culled_shader || shader != Asset::Shader::culled ? shader : Asset::Shader::standard;
 
-	Loader::shader(shader_actual);
+	if (team == s8(AI::TeamNone))
+	{
+		if (params.camera->flag(CameraFlagColors) || list_alpha.get(id()) || list_additive.get(id()))
+			*color_final = color;
+		else if (color.w == MATERIAL_INACCESSIBLE || (params.flags & RenderFlagBackFace))
+			*color_final = PVP_INACCESSIBLE;
+		else if (color.w == MATERIAL_NO_OVERRIDE)
+			*color_final = PVP_ACCESSIBLE_NO_OVERRIDE;
+		else
+			*color_final = PVP_ACCESSIBLE;
+	}
+	else
+	{
+		if (params.flags & RenderFlagBackFace)
+			*color_final = PVP_INACCESSIBLE;
+		else if (list_alpha.get(id()) || list_additive.get(id()))
+			*color_final = Vec4(Team::color_alpha(AI::Team(team), AI::Team(params.camera->team)), color.w);
+		else
+			*color_final = Team::color(AI::Team(team), AI::Team(params.camera->team));
+	}
+	if (params.flags & RenderFlagAlphaOverride)
+		color_final->w = 0.7f;
+
+	return true;
+}
+
+void View::draw(const RenderParams& params) const
+{
+	Mat4 m;
+	AssetID shader_actual;
+	Vec4 color_final;
+	if (draw_prepare(params, &m, &shader_actual, &color_final))
+		draw_single(params, mesh, shader_actual, texture, m, color_final);
+}
+
+// draws now if there's no instanced version of the shader, otherwise waits for instances_flush
+void View::draw_queue(const RenderParams& params) const
+{
+	Mat4 m;
+	AssetID shader_actual;
+	Vec4 color_final;
+	if (!draw_prepare(params, &m, &shader_actual, &color_final))
+		return;
+
+	if (shader_instanced(shader_actual) == AssetNull)
+		draw_single(params, mesh, shader_actual, texture, m, color_final);
+	else
+	{
+		InstanceEntry* entry = instance_queue.add();
+		entry->instance.world_matrix = m;
+		entry->instance.color = color_final;
+		entry->key = instance_key(mesh, shader_actual, texture);
+	}
+}
+
+void View::draw_single(const RenderParams& params, AssetID mesh, AssetID shader, AssetID texture, const Mat4& m, const Vec4& color)
+{
+	Loader::shader(shader);
 	Loader::texture(texture);
 
 	RenderSync* sync = params.sync;
 	sync->write(RenderOp::Shader);
-	sync->write(shader_actual);
+	sync->write(shader);
 	sync->write(params.technique);
 
 	Mat4 mvp = m * params.view_projection;
@@ -278,73 +405,87 @@ void View::draw(const RenderParams& params) const
 	sync->write(Asset::Uniform::diffuse_color);
 	sync->write(RenderDataType::Vec4);
 	sync->write<s32>(1);
+	sync->write(color);
 
-	{
-		Vec4 color_final;
-		if (team == s8(AI::TeamNone))
-		{
-			if (params.camera->flag(CameraFlagColors) || list_alpha.get(id()) || list_additive.get(id()))
-				color_final = color;
-			else if (color.w == MATERIAL_INACCESSIBLE || (params.flags & RenderFlagBackFace))
-				color_final = PVP_INACCESSIBLE;
-			else if (color.w == MATERIAL_NO_OVERRIDE)
-				color_final = PVP_ACCESSIBLE_NO_OVERRIDE;
-			else
-				color_final = PVP_ACCESSIBLE;
-		}
-		else
-		{
-			if (params.flags & RenderFlagBackFace)
-				color_final = PVP_INACCESSIBLE;
-			else if (list_alpha.get(id()) || list_additive.get(id()))
-				color_final = Vec4(Team::color_alpha(AI::Team(team), AI::Team(params.camera->team)), color.w);
-			else
-				color_final = Team::color(AI::Team(team), AI::Team(params.camera->team));
-		}
-		if (params.flags & RenderFlagAlphaOverride)
-			color_final.w = 0.7f;
-		sync->write(color_final);
-	}
+	if (shader == Asset::Shader::culled)
+		write_culling_uniforms(params);
 
-	if (shader_actual == Asset::Shader::culled)
+	if (texture != AssetNull)
 	{
-		// write culling info
 		sync->write(RenderOp::Uniform);
-		sync->write(Asset::Uniform::range_center);
-		sync->write(RenderDataType::Vec3);
+		sync->write(Asset::Uniform::diffuse_map);
+		sync->write(RenderDataType::Texture);
 		sync->write<s32>(1);
-		sync->write<Vec3>(params.camera->range_center);
+		sync->write(RenderTextureType::Texture2D);
+		sync->write<AssetID>(texture);
+	}
 
-		sync->write(RenderOp::Uniform);
-		sync->write(Asset::Uniform::cull_center);
-		sync->write(RenderDataType::Vec3);
-		sync->write<s32>(1);
-		sync->write<Vec3>(params.camera->cull_center);
+	if (params.flags & RenderFlagEdges)
+	{
+		sync->write(RenderOp::MeshEdges);
+		sync->write(mesh);
+	}
+	else
+	{
+		sync->write(RenderOp::Mesh);
+		sync->write(RenderPrimitiveMode::Triangles);
+		sync->write(mesh);
+	}
+}
 
-		sync->write(RenderOp::Uniform);
-		sync->write(Asset::Uniform::cull_radius);
-		sync->write(RenderDataType::R32);
-		sync->write<s32>(1);
-		sync->write<r32>(params.camera->cull_range);
+// one draw for every queued view sharing this mesh, shader and texture.
+// the instance buffer is uploaded right before every draw, since the same mesh can show up in several passes and buckets
+void View::draw_instances(const RenderParams& params, u64 key, const InstanceEntry* entries, s32 count)
+{
+	AssetID mesh = AssetID(u16(key >> 32));
+	AssetID shader = AssetID(u16(key >> 16));
+	AssetID texture = AssetID(u16(key));
 
-		sync->write(RenderOp::Uniform);
-		sync->write(Asset::Uniform::wall_normal);
-		sync->write(RenderDataType::Vec3);
-		sync->write<s32>(1);
-		sync->write<Vec3>(params.camera->clip_planes[0].normal);
+	if (count == 1)
+	{
+		// not worth the instance buffer upload
+		draw_single(params, mesh, shader, texture, entries[0].instance.world_matrix, entries[0].instance.color);
+		return;
+	}
 
-		sync->write(RenderOp::Uniform);
-		sync->write(Asset::Uniform::cull_behind_wall);
-		sync->write(RenderDataType::S32);
-		sync->write<s32>(1);
-		sync->write<s32>(params.camera->flag(CameraFlagCullBehindWall));
+	AssetID shader_actual = shader_instanced(shader);
+	Loader::mesh_instanced(mesh);
+	Loader::shader(shader_actual);
+	Loader::texture(texture);
 
-		sync->write(RenderOp::Uniform);
-		sync->write(Asset::Uniform::frontface);
-		sync->write(RenderDataType::S32);
-		sync->write<s32>(1);
-		sync->write<s32>(!(params.flags & RenderFlagBackFace));
-	}
+	RenderSync* sync = params.sync;
+
+	sync->write(RenderOp::UpdateInstances);
+	sync->write(mesh);
+	sync->write(count);
+	for (s32 i = 0; i < count; i++)
+		sync->write<InstanceVertex>(entries[i].instance);
+
+	sync->write(RenderOp::Shader);
+	sync->write(shader_actual);
+	sync->write(params.technique);
+
+	sync->write(RenderOp::Uniform);
+	sync->write(Asset::Uniform::vp);
+	sync->write(RenderDataType::Mat4);
+	sync->write<s32>(1);
+	sync->write<Mat4>(params.view_projection);
+
+	sync->write(RenderOp::Uniform);
+	sync->write(Asset::Uniform::v);
+	sync->write(RenderDataType::Mat4);
+	sync->write<s32>(1);
+	sync->write<Mat4>(params.view);
+
+	// the per-instance color gets multiplied by this
+	sync->write(RenderOp::Uniform);
+	sync->write(Asset::Uniform::diffuse_color);
+	sync->write(RenderDataType::Vec4);
+	sync->write<s32>(1);
+	sync->write<Vec4>(Vec4(1));
+
+	if (shader == Asset::Shader::culled)
+		write_culling_uniforms(params);
 
 	if (texture != AssetNull)
 	{
@@ -356,16 +497,58 @@ void View::draw(const RenderParams& params) const
 		sync->write<AssetID>(texture);
 	}
 
-	if (params.flags & RenderFlagEdges)
+	sync->write(params.flags & RenderFlagEdges ? RenderOp::InstancesEdges : RenderOp::Instances);
+	sync->write(mesh);
+}
+
+// groups everything queued by draw_queue by mesh, shader and texture, and draws each group
+void View::instances_flush(const RenderParams& params)
+{
+	if (instance_queue.length == 0)
+		return;
+
+	// counting sort into hash buckets, same as SpatialGrid
+	s32 bucket_start[instance_bucket_count + 1];
+	memset(bucket_start, 0, sizeof(bucket_start));
+	for (s32 i = 0; i < instance_queue.length; i++)
+		bucket_start[instance_key_hash(instance_queue[i].key) + 1]++;
+	for (s32 i = 0; i < instance_bucket_count; i++)
+		bucket_start[i + 1] += bucket_start[i];
+
+	instance_queue_sorted.resize(instance_queue.length);
 	{
-		sync->write(RenderOp::MeshEdges);
-		sync->write(mesh);
+		s32 cursor[instance_bucket_count];
+		memcpy(cursor, bucket_start, sizeof(cursor));
+		for (s32 i = 0; i < instance_queue.length; i++)
+		{
+			const InstanceEntry& e = instance_queue[i];
+			instance_queue_sorted[cursor[instance_key_hash(e.key)]++] = e;
+		}
 	}
-	else
+	instance_queue.length = 0;
+
+	// different keys can share a bucket; pull them out one at a time
+	for (s32 bucket = 0; bucket < instance_bucket_count; bucket++)
 	{
-		sync->write(RenderOp::Mesh);
-		sync->write(RenderPrimitiveMode::Triangles);
-		sync->write(mesh);
+		s32 start = bucket_start[bucket];
+		s32 end = bucket_start[bucket + 1];
+		while (start < end)
+		{
+			u64 key = instance_queue_sorted[start].key;
+			s32 group_end = start + 1;
+			for (s32 i = group_end; i < end; i++)
+			{
+				if (instance_queue_sorted[i].key == key)
+				{
+					InstanceEntry tmp = instance_queue_sorted[group_end];
+					instance_queue_sorted[group_end] = instance_queue_sorted[i];
+					instance_queue_sorted[i] = tmp;
+					group_end++;
+				}
+			}
+			draw_instances(params, key, &instance_queue_sorted[start], group_end - start);
+			start = group_end;
+		}
 	}
 }
 
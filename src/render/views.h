@@ -22,8 +22,20 @@ struct View : public ComponentType<View>
 		Vec3 scale;
 	};
 
+	// views waiting to be drawn in one instanced draw per mesh/shader/texture
+	struct InstanceEntry
+	{
+		InstanceVertex instance;
+		u64 key;
+	};
+
+	static const s32 instance_bucket_count = 256; // must be a power of two
+
 	static Bitmask<MAX_ENTITIES> list_alpha;
 	static Bitmask<MAX_ENTITIES> list_additive;
+	// scratch, one set per recording thread
+	static thread_local Array<InstanceEntry> instance_queue;
+	static thread_local Array<InstanceEntry> instance_queue_sorted;
 #if DEBUG_VIEW
 	static Array<DebugEntry> debug_entries;
 #endif
@@ -44,6 +56,9 @@ struct View : public ComponentType<View>
 	static void draw_filtered(const RenderParams&, Filter*);
 
 	static void draw_mesh(const RenderParams&, AssetID, AssetID, AssetID, const Mat4&, const Vec4&, r32 = 0.0f);
+	static void draw_single(const RenderParams&, AssetID, AssetID, AssetID, const Mat4&, const Vec4&);
+	static void draw_instances(const RenderParams&, u64, const InstanceEntry*, s32);
+	static void instances_flush(const RenderParams&);
 
 #if DEBUG_VIEW
 	static void debug(AssetID, const Vec3&, const Quat& = Quat::identity, const Vec3& = Vec3(1), const Vec4& = Vec4(1, 1, 1, 0.5f));
@@ -59,7 +74,9 @@ struct View : public ComponentType<View>
 	void alpha();
 	void additive();
 	void alpha_disable();
+	b8 draw_prepare(const RenderParams&, Mat4*, AssetID*, Vec4*) const;
 	void draw(const RenderParams&) const;
+	void draw_queue(const RenderParams&) const;
 };
 
 struct Skybox
@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <thread>
+
+#include <glew/include/GL/glew.h>
+#include <sdl/include/SDL.h>
+#undef main
+
+#include "types.h"
+#include "vi_assert.h"
+#include "data/array.h"
+#include "platform/util.h"
+#include "render/glvm.h"
+#include "render/render_filter.h"
+#include "render/render_capture.h"
+
+// plays back a capture recorded by the client with "record_render": 1 in its config file,
+// through the same filter and GL VM the render thread uses, and reports how long each took.
+// with --null, ops are decoded and validated but never handed to GL, so no GPU (or window) is needed.
+
+namespace VI
+{
+
+namespace platform
+{
+
+	u64 timestamp()
+	{
+		time_t t;
+		::time(&t);
+		return u64(t);
+	}
+
+	r64 time()
+	{
+		return r64(std::chrono::high_resolution_clock::now().time_since_epoch().count()) / 1000000000.0;
+	}
+
+	void sleep(r32 time)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(s64(time * 1000.0f)));
+	}
+
+}
+
+// same as import_common.cpp, which drags in recast and friends
+const char* TechniquePrefixes::all[(s32)RenderTechnique::count] =
+{
+	"", // Default
+	"#define SHADOW\n", // Shadow
+};
+
+s32 usage()
+{
+	fprintf(stderr, "%s", "Usage: render_replay <capture> [--null]\n");
+	return 1;
+}
+
+s32 proc(s32 argc, char* argv[])
+{
+	const char* path = nullptr;
+	b8 null_backend = false;
+	for (s32 i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--null") == 0)
+			null_backend = true;
+		else if (!path)
+			path = argv[i];
+		else
+			return usage();
+	}
+
+	if (!path)
+		return usage();
+
+	RenderCapture capture;
+	if (!capture.read_open(path))
+	{
+		fprintf(stderr, "Error: '%s' is missing, or isn't a render capture from this version\n", path);
+		return 1;
+	}
+
+	s32 width = capture.header.width;
+	s32 height = capture.header.height;
+
+	SDL_Window* window = nullptr;
+	SDL_GLContext context = nullptr;
+	if (!null_backend)
+	{
+		if (SDL_Init(SDL_INIT_VIDEO) < 0)
+		{
+			fprintf(stderr, "Error: Failed to initialize SDL: %s\n", SDL_GetError());
+			return 1;
+		}
+
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
+		SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+
+		window = SDL_CreateWindow("render_replay", 0, 0, width, height, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+		if (!window)
+		{
+			fprintf(stderr, "Error: Failed to open SDL window: %s\n", SDL_GetError());
+			SDL_Quit();
+			return 1;
+		}
+
+		context = SDL_GL_CreateContext(window);
+		if (!context)
+		{
+			fprintf(stderr, "Error: Failed to create GL context: %s\n", SDL_GetError());
+			SDL_DestroyWindow(window);
+			SDL_Quit();
+			return 1;
+		}
+
+		SDL_GL_SetSwapInterval(0); // we're measuring, not presenting
+
+		glewExperimental = true; // needed for core profile
+		GLenum glew_result = glewInit();
+		if (glew_result != GLEW_OK)
+		{
+			fprintf(stderr, "Error: Failed to initialize GLEW: %s\n", glewGetErrorString(glew_result));
+			SDL_GL_DeleteContext(context);
+			SDL_DestroyWindow(window);
+			SDL_Quit();
+			return 1;
+		}
+		glGetError(); // clear initial error caused by GLEW
+
+		render_init();
+	}
+
+	RenderFilter filter;
+	RenderSync sync;
+	s64 ops_in = 0;
+	s64 ops_out = 0;
+	r64 time_decode = 0.0;
+	r64 time_decode_max = 0.0;
+	r64 time_submit = 0.0;
+	r64 time_submit_max = 0.0;
+	b8 success = true;
+	s32 frame_count = 0;
+	// frames are streamed one at a time so captures can be bigger than memory.
+	// reads happen between the timed sections, so disk access stays out of the timings
+	while (capture.read(&sync))
+	{
+		s32 i = frame_count;
+		frame_count++;
+
+		RenderFilterStats stats;
+		r64 start = platform::time();
+		b8 valid = filter.filter(&sync, &stats);
+		r64 elapsed = platform::time() - start;
+		time_decode += elapsed;
+		time_decode_max = vi_max(time_decode_max, elapsed);
+		ops_in += stats.ops_in;
+		ops_out += stats.ops_out;
+
+		if (!valid)
+		{
+			fprintf(stderr, "Error: frame %d is malformed after %d good ops\n", i, stats.ops_in);
+			success = false;
+			break;
+		}
+
+		if (!null_backend)
+		{
+			start = platform::time();
+			render(&sync);
+			SDL_GL_SwapWindow(window);
+			elapsed = platform::time() - start;
+			time_submit += elapsed;
+			time_submit_max = vi_max(time_submit_max, elapsed);
+		}
+	}
+
+	capture.close();
+
+	if (!null_backend)
+	{
+		r64 start = platform::time();
+		glFinish();
+		time_submit += platform::time() - start;
+
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+	}
+
+	if (!success)
+		return 1;
+
+	// frames early in a capture carry resource loads, so max is usually one of those
+	r64 per_frame = frame_count > 0 ? 1000.0 / r64(frame_count) : 0.0;
+	printf("%d frames at %dx%d | %lld ops | %lld after filter\n", frame_count, width, height, (long long)ops_in, (long long)ops_out);
+	printf("decode: %.3fms total | %.3fms per frame | %.3fms max\n", time_decode * 1000.0, time_decode * per_frame, time_decode_max * 1000.0);
+	if (!null_backend)
+		printf("submit: %.3fms total | %.3fms per frame | %.3fms max\n", time_submit * 1000.0, time_submit * per_frame, time_submit_max * 1000.0);
+
+	return 0;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	return VI::proc(argc, argv);
+}
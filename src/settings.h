@@ -51,6 +51,8 @@ namespace Settings
 	extern Gamepad gamepads[MAX_GAMEPADS];
 	extern s32 framerate_limit;
 	extern s32 display_mode_index;
+	extern s32 ai_workers; // pathfinding threads; -1 picks a count from the number of cores
+	extern s32 worker_threads; // update task graph threads besides the update thread; -1 picks a count from the number of cores
 #if SERVER
 	extern u64 secret;
 	extern u16 port;
@@ -84,6 +86,7 @@ namespace Settings
 	extern b8 subtitles;
 	extern b8 scan_lines;
 	extern b8 record;
+	extern b8 record_render;
 	extern b8 ssao;
 	extern b8 expo;
 	extern b8 shell_casings;
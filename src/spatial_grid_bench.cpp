@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cfloat>
+#include <chrono>
+
+#include "types.h"
+#include "vi_assert.h"
+#include "lmath.h"
+#include "data/array.h"
+#include "data/spatial_grid.h"
+#include "game/constants.h"
+
+// times the server's per-tick target queries against SpatialGrid and against the linear scans it replaced,
+// with MAX_MINIONS minions plus drones and turrets, a swarm of bolts, and a field of force fields.
+// every query is run both ways and the results have to match, so this doubles as a correctness check.
+// positions are random; no level, assets or game loop needed.
+
+namespace VI
+{
+
+#define BENCH_LEVEL_SIZE 120.0f
+#define BENCH_LEVEL_HEIGHT 30.0f
+#define BENCH_TICK 0.05f
+#define BENCH_WALK_SPEED 3.0f // same as minion.cpp
+
+struct BenchTarget
+{
+	Vec3 pos;
+	r32 radius;
+	AI::Team team;
+};
+
+struct BenchBolt
+{
+	Vec3 pos;
+	Vec3 velocity;
+	AI::Team team;
+};
+
+u32 bench_random_state = 1;
+
+// deterministic, so runs are comparable
+r32 bench_randf()
+{
+	bench_random_state = bench_random_state * 1664525u + 1013904223u;
+	return r32(bench_random_state >> 8) * (1.0f / 16777216.0f);
+}
+
+Vec3 bench_random_pos()
+{
+	return Vec3
+	(
+		(bench_randf() - 0.5f) * BENCH_LEVEL_SIZE,
+		bench_randf() * BENCH_LEVEL_HEIGHT,
+		(bench_randf() - 0.5f) * BENCH_LEVEL_SIZE
+	);
+}
+
+Vec3 bench_random_dir()
+{
+	Vec3 dir(bench_randf() - 0.5f, (bench_randf() - 0.5f) * 0.25f, bench_randf() - 0.5f);
+	if (dir.length_squared() < 0.0001f)
+		return Vec3(1, 0, 0);
+	return Vec3::normalize(dir);
+}
+
+r64 bench_time()
+{
+	return r64(std::chrono::high_resolution_clock::now().time_since_epoch().count()) / 1000000000.0;
+}
+
+// same closest-hit test as Bolt::raycast; returns the target index or -1
+s32 bench_bolt_target(const BenchTarget* target, s32 index, const Vec3& a, const Vec3& b, AI::Team team, s32 closest, r32* closest_distance_sq)
+{
+	if (target->team == team)
+		return closest;
+
+	Vec3 intersection;
+	if (LMath::ray_sphere_intersect(a, b, target->pos, target->radius, &intersection))
+	{
+		r32 distance_sq = (intersection - a).length_squared();
+		if (distance_sq < *closest_distance_sq)
+		{
+			*closest_distance_sq = distance_sq;
+			return index;
+		}
+	}
+	return closest;
+}
+
+s32 usage()
+{
+	fprintf(stderr, "%s", "Usage: spatial_grid_bench [bolts] [ticks]\n");
+	return 1;
+}
+
+s32 proc(s32 argc, char* argv[])
+{
+	s32 bolt_count = 256;
+	s32 tick_count = 1000;
+	if (argc > 3)
+		return usage();
+	if (argc > 1)
+		bolt_count = atoi(argv[1]);
+	if (argc > 2)
+		tick_count = atoi(argv[2]);
+	if (bolt_count <= 0 || tick_count <= 0)
+		return usage();
+
+	Array<BenchTarget> targets;
+	for (s32 i = 0; i < MAX_MINIONS; i++)
+		targets.add({ bench_random_pos(), MINION_HEAD_RADIUS, AI::Team(i % 2) });
+	for (s32 i = 0; i < MAX_PLAYERS; i++)
+		targets.add({ bench_random_pos(), DRONE_SHIELD_RADIUS, AI::Team(i % 2) });
+	for (s32 i = 0; i < 16; i++)
+		targets.add({ bench_random_pos(), TURRET_RADIUS, AI::Team(i % 2) });
+
+	Array<BenchTarget> force_fields;
+	for (s32 i = 0; i < 32; i++)
+		force_fields.add({ bench_random_pos(), FORCE_FIELD_RADIUS, AI::Team(i % 2) });
+
+	Array<BenchBolt> bolts;
+	for (s32 i = 0; i < bolt_count; i++)
+		bolts.add({ bench_random_pos(), bench_random_dir() * BOLT_SPEED_DRONE_BOLTER, AI::Team(i % 2) });
+
+	SpatialGrid target_grid;
+	SpatialGrid force_field_grid(FORCE_FIELD_RADIUS * 2.0f);
+	for (s32 i = 0; i < force_fields.length; i++)
+		force_field_grid.add(i, force_fields[i].pos, force_fields[i].radius, force_fields[i].team);
+	force_field_grid.build();
+
+	r64 time_build = 0.0;
+	r64 time_bolt_grid = 0.0;
+	r64 time_bolt_linear = 0.0;
+	r64 time_field_grid = 0.0;
+	r64 time_field_linear = 0.0;
+	s64 candidates = 0;
+	s64 hits = 0;
+	s64 mismatches = 0;
+
+	Array<Vec3> next_pos;
+	Array<s32> hit_grid;
+	Array<s32> hit_linear;
+	Array<s32> field_grid;
+	Array<s32> field_linear;
+	next_pos.resize(bolt_count);
+	hit_grid.resize(bolt_count);
+	hit_linear.resize(bolt_count);
+	field_grid.resize(bolt_count);
+	field_linear.resize(bolt_count);
+
+	for (s32 tick = 0; tick < tick_count; tick++)
+	{
+		// minions wander a little every tick, like they would between snapshots
+		for (s32 i = 0; i < targets.length; i++)
+			targets[i].pos += bench_random_dir() * (BENCH_WALK_SPEED * BENCH_TICK);
+
+		r64 start = bench_time();
+		target_grid.clear();
+		for (s32 i = 0; i < targets.length; i++)
+			target_grid.add(i, targets[i].pos, targets[i].radius, targets[i].team);
+		target_grid.build();
+		time_build += bench_time() - start;
+
+		// each pass is timed as a whole so the clock doesn't dominate
+		for (s32 i = 0; i < bolts.length; i++)
+			next_pos[i] = bolts[i].pos + bolts[i].velocity * BENCH_TICK;
+
+		// bolts vs. targets
+		start = bench_time();
+		for (s32 i = 0; i < bolts.length; i++)
+		{
+			const BenchBolt& bolt = bolts[i];
+			s32 hit = -1;
+			r32 closest_distance_sq = FLT_MAX;
+			SpatialGrid::Query query = target_grid.segment(bolt.pos, next_pos[i], 0.0f);
+			ID id;
+			while (target_grid.next(&query, &id))
+			{
+				candidates++;
+				hit = bench_bolt_target(&targets[id], id, bolt.pos, next_pos[i], bolt.team, hit, &closest_distance_sq);
+			}
+			hit_grid[i] = hit;
+		}
+		time_bolt_grid += bench_time() - start;
+
+		start = bench_time();
+		for (s32 i = 0; i < bolts.length; i++)
+		{
+			const BenchBolt& bolt = bolts[i];
+			s32 hit = -1;
+			r32 closest_distance_sq = FLT_MAX;
+			for (s32 j = 0; j < targets.length; j++)
+				hit = bench_bolt_target(&targets[j], j, bolt.pos, next_pos[i], bolt.team, hit, &closest_distance_sq);
+			hit_linear[i] = hit;
+		}
+		time_bolt_linear += bench_time() - start;
+
+		// same query minions run every tick: am I inside an enemy force field?
+		start = bench_time();
+		for (s32 i = 0; i < bolts.length; i++)
+		{
+			s32 field = -1;
+			SpatialGrid::Query query = force_field_grid.sphere(next_pos[i], 0.0f, AI::TeamMask(~(1 << bolts[i].team)));
+			ID id;
+			while (force_field_grid.next(&query, &id))
+			{
+				if ((field == -1 || id < field) && (force_fields[id].pos - next_pos[i]).length_squared() < FORCE_FIELD_RADIUS * FORCE_FIELD_RADIUS)
+					field = id;
+			}
+			field_grid[i] = field;
+		}
+		time_field_grid += bench_time() - start;
+
+		start = bench_time();
+		for (s32 i = 0; i < bolts.length; i++)
+		{
+			s32 field = -1;
+			for (s32 j = 0; j < force_fields.length; j++)
+			{
+				if (force_fields[j].team != bolts[i].team && (force_fields[j].pos - next_pos[i]).length_squared() < FORCE_FIELD_RADIUS * FORCE_FIELD_RADIUS)
+				{
+					field = j;
+					break;
+				}
+			}
+			field_linear[i] = field;
+		}
+		time_field_linear += bench_time() - start;
+
+		for (s32 i = 0; i < bolts.length; i++)
+		{
+			if (hit_grid[i] != hit_linear[i] || field_grid[i] != field_linear[i])
+				mismatches++;
+
+			BenchBolt* bolt = &bolts[i];
+			const Vec3& p = next_pos[i];
+			if (hit_grid[i] != -1 || p.x < -BENCH_LEVEL_SIZE || p.x > BENCH_LEVEL_SIZE || p.z < -BENCH_LEVEL_SIZE || p.z > BENCH_LEVEL_SIZE)
+			{
+				// respawn
+				if (hit_grid[i] != -1)
+					hits++;
+				bolt->pos = bench_random_pos();
+				bolt->velocity = bench_random_dir() * BOLT_SPEED_DRONE_BOLTER;
+			}
+			else
+				bolt->pos = p;
+		}
+	}
+
+	r64 per_tick = 1000.0 / r64(tick_count);
+	printf("%d targets | %d force fields | %d bolts | %d ticks | %lld hits\n", targets.length, force_fields.length, bolts.length, tick_count, (long long)hits);
+	printf("grid build: %.4fms per tick\n", time_build * per_tick);
+	printf("bolts: grid %.4fms | linear %.4fms per tick | %.1f candidates per bolt\n", time_bolt_grid * per_tick, time_bolt_linear * per_tick, r64(candidates) / (r64(tick_count) * r64(bolt_count)));
+	printf("force fields: grid %.4fms | linear %.4fms per tick\n", time_field_grid * per_tick, time_field_linear * per_tick);
+
+	if (mismatches > 0)
+	{
+		fprintf(stderr, "Error: grid and linear scan disagreed %lld times\n", (long long)mismatches);
+		return 1;
+	}
+
+	return 0;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	return VI::proc(argc, argv);
+}
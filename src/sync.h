@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include "data/array.h"
@@ -9,63 +10,90 @@
 namespace VI
 {
 
+// single-consumer ring buffer.
+// producers bracket each message with lock()/unlock(); the message becomes visible to the consumer all at once on unlock().
+// the producer mutex only serializes producers against each other; the consumer never takes it.
+// the consumer reads without locking, and blocks in wait_read() until a producer wakes it.
 template<s32 size> struct SyncRingBuffer
 {
-	s32 read_pos;
-	s32 write_pos;
+	std::atomic<s32> read_pos;
+	std::atomic<s32> write_pos; // published write position
+	s32 write_cursor; // in-progress write position; protected by mutex
+	std::atomic<b8> consumer_waiting;
 	mutable std::mutex mutex;
+	std::mutex wait_mutex;
 	Array<u8> data;
 	std::condition_variable condition;
 
 	SyncRingBuffer() :
-		read_pos(),
-		write_pos(),
+		read_pos(0),
+		write_pos(0),
+		write_cursor(),
+		consumer_waiting(false),
 		mutex(),
+		wait_mutex(),
 		data(size, size),
 		condition()
 	{
 	}
 
-	void lock_wait_read()
+	// consumer only
+	void wait_read()
 	{
-		while (true)
+		while (!can_read())
 		{
-			mutex.lock();
-			b8 can_read = read_pos != write_pos;
-			if (can_read)
-				break;
-			else
+			std::unique_lock<std::mutex> lock(wait_mutex);
+			// this store and the write_pos load below pair with the write_pos store and consumer_waiting load in unlock().
+			// all four have to be seq_cst; with an acquire load here, the load can move above the store,
+			// both sides miss each other, and the consumer sleeps through the notify
+			consumer_waiting.store(true, std::memory_order_seq_cst);
+			if (read_pos.load(std::memory_order_relaxed) != write_pos.load(std::memory_order_seq_cst))
 			{
-				mutex.unlock();
-				platform::sleep(1.0f / 60.0f);
+				consumer_waiting.store(false);
+				break;
 			}
+			condition.wait(lock);
+			consumer_waiting.store(false);
 		}
 	}
 
+	// consumer only
 	inline b8 can_read() const
 	{
-		return read_pos != write_pos;
+		return read_pos.load(std::memory_order_relaxed) != write_pos.load(std::memory_order_acquire);
 	}
 
+	// producer only
 	inline void lock()
 	{
 		mutex.lock();
+		write_cursor = write_pos.load(std::memory_order_relaxed);
 	}
 
+	// producer only; publishes everything written since lock()
 	inline void unlock()
 	{
+		write_pos.store(write_cursor, std::memory_order_seq_cst);
 		mutex.unlock();
+		if (consumer_waiting.load(std::memory_order_seq_cst)) // see wait_read()
+		{
+			std::lock_guard<std::mutex> lock(wait_mutex);
+			condition.notify_one();
+		}
 	}
 
 	template<typename T> void write(const T* t, s32 count)
 	{
 		s32 write_size = sizeof(T) * count;
-		s32 write_end = write_pos + write_size;
+		s32 write_end = write_cursor + write_size;
 
-		if (read_pos < write_pos)
-			vi_assert(write_end - data.length < read_pos);
-		else if (read_pos > write_pos)
-			vi_assert(write_end < read_pos);
+		{
+			s32 r = read_pos.load(std::memory_order_acquire);
+			if (r < write_cursor)
+				vi_assert(write_end - data.length < r);
+			else if (r > write_cursor)
+				vi_assert(write_end < r);
+		}
 
 #if defined(__clang__)
 		// get ready to do gross things
@@ -74,15 +102,15 @@ template<s32 size> struct SyncRingBuffer
 #endif
 		if (write_end < data.length)
 		{
-			memcpy(&data[write_pos], t, write_size);
-			write_pos = write_end;
+			memcpy(&data[write_cursor], t, write_size);
+			write_cursor = write_end;
 		}
 		else
 		{
-			s32 partition = data.length - write_pos;
-			memcpy(&data[write_pos], t, partition);
-			write_pos = write_end - data.length;
-			memcpy(&data[0], ((u8*)t) + partition, write_pos);
+			s32 partition = data.length - write_cursor;
+			memcpy(&data[write_cursor], t, partition);
+			write_cursor = write_end - data.length;
+			memcpy(&data[0], ((u8*)t) + partition, write_cursor);
 		}
 #if defined(__clang__)
 #pragma clang diagnostic pop
@@ -94,12 +122,15 @@ template<s32 size> struct SyncRingBuffer
 		write<T>(&t, 1);
 	}
 
+	// consumer only
 	template<typename T> void read(T* t, s32 count = 1)
 	{
 		s32 read_len = sizeof(T) * count;
 		if (read_len == 0)
 			return;
-		s32 read_end = read_pos + read_len;
+		s32 r = read_pos.load(std::memory_order_relaxed);
+		s32 w = write_pos.load(std::memory_order_acquire);
+		s32 read_end = r + read_len;
 
 #if defined(__clang__)
 		// get ready to do gross things
@@ -108,31 +139,34 @@ template<s32 size> struct SyncRingBuffer
 #endif
 		if (read_end >= data.length)
 		{
-			vi_assert(write_pos < read_pos);
-			s32 read_partition = data.length - read_pos;
-			vi_assert(read_len - read_partition <= write_pos);
+			vi_assert(w < r);
+			s32 read_partition = data.length - r;
+			vi_assert(read_len - read_partition <= w);
 
-			memcpy(t, &data[read_pos], read_partition);
-			read_pos = read_len - read_partition;
-			memcpy(((u8*)t) + read_partition, &data[0], read_pos);
+			memcpy(t, &data[r], read_partition);
+			r = read_len - read_partition;
+			memcpy(((u8*)t) + read_partition, &data[0], r);
 		}
 		else
 		{
-			vi_assert(read_end <= write_pos == read_pos < write_pos);
-			memcpy(t, &data[read_pos], read_len);
-			read_pos = read_end;
+			vi_assert(read_end <= w == r < w);
+			memcpy(t, &data[r], read_len);
+			r = read_end;
 		}
 #if defined(__clang__)
 #pragma clang diagnostic pop
 #endif
+		read_pos.store(r, std::memory_order_release);
 	}
 
 	s32 length()
 	{
-		if (read_pos <= write_pos)
-			return write_pos - read_pos;
+		s32 r = read_pos.load(std::memory_order_acquire);
+		s32 w = write_pos.load(std::memory_order_acquire);
+		if (r <= w)
+			return w - r;
 		else
-			return write_pos + data.length - read_pos;
+			return w + data.length - r;
 	}
 
 	s32 capacity()
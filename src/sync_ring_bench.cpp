@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+#include "types.h"
+#include "vi_assert.h"
+#include "lmath.h"
+#include "sync.h"
+
+// round-trip latency of an AI::Op::ClosestWalkPoint-shaped request through a pair of SyncRingBuffers:
+// the main thread writes the request to sync_in, a worker thread picks it up, answers on sync_out,
+// and the main thread spins until the answer shows up.
+// the worker either blocks in wait_read() (current) or polls with a 1/60s sleep like the old lock_wait_read().
+// the work itself is a no-op, so this is pure hand-off latency.
+
+namespace VI
+{
+
+#define BENCH_SYNC_SIZE (256 * 1024) // same as AI::SYNC_IN_SIZE / SYNC_OUT_SIZE
+
+// same size as LinkEntryArg<const Vec3&>: vtable pointer plus the ID/revision union
+struct BenchCallback
+{
+	void* vtable;
+	u64 data;
+};
+
+enum class BenchOp : s8
+{
+	ClosestWalkPoint,
+	Quit,
+	count,
+};
+
+SyncRingBuffer<BENCH_SYNC_SIZE> sync_in;
+SyncRingBuffer<BENCH_SYNC_SIZE> sync_out;
+
+r64 bench_time()
+{
+	return r64(std::chrono::high_resolution_clock::now().time_since_epoch().count()) / 1000000000.0;
+}
+
+// the old lock_wait_read(), minus the lock
+void bench_poll_read()
+{
+	while (!sync_in.can_read())
+		std::this_thread::sleep_for(std::chrono::microseconds(1000000 / 60));
+}
+
+void bench_worker(b8 poll)
+{
+	while (true)
+	{
+		if (poll)
+			bench_poll_read();
+		else
+			sync_in.wait_read();
+
+		BenchOp op;
+		sync_in.read(&op);
+		if (op == BenchOp::Quit)
+			break;
+
+		Vec3 pos;
+		BenchCallback callback;
+		sync_in.read(&pos);
+		sync_in.read(&callback);
+
+		sync_out.lock();
+		sync_out.write(callback);
+		sync_out.write(pos);
+		sync_out.unlock();
+	}
+}
+
+// returns the average round trip in microseconds, or -1 if an answer came back wrong
+r64 bench_round_trips(b8 poll, s32 count)
+{
+	std::thread worker(&bench_worker, poll);
+
+	s32 errors = 0;
+	r64 total = 0.0;
+	for (s32 i = 0; i < count; i++)
+	{
+		Vec3 pos(r32(i), r32(i % 7), r32(-i));
+		BenchCallback callback = { nullptr, u64(i) };
+
+		r64 start = bench_time();
+		sync_in.lock();
+		sync_in.write(BenchOp::ClosestWalkPoint);
+		sync_in.write(pos);
+		sync_in.write(callback);
+		sync_in.unlock();
+
+		while (!sync_out.can_read())
+		{
+		}
+
+		BenchCallback callback_out;
+		Vec3 pos_out;
+		sync_out.read(&callback_out);
+		sync_out.read(&pos_out);
+		total += bench_time() - start;
+
+		if (callback_out.data != callback.data || pos_out.x != pos.x || pos_out.y != pos.y || pos_out.z != pos.z)
+			errors++;
+	}
+
+	sync_in.lock();
+	sync_in.write(BenchOp::Quit);
+	sync_in.unlock();
+	worker.join();
+
+	if (errors > 0)
+		return -1.0;
+	return (total * 1000000.0) / r64(count);
+}
+
+s32 usage()
+{
+	fprintf(stderr, "%s", "Usage: sync_ring_bench [round trips] [polling round trips]\n");
+	return 1;
+}
+
+s32 proc(s32 argc, char* argv[])
+{
+	s32 count = 100000;
+	s32 poll_count = 60; // each one takes up to a frame
+	if (argc > 3)
+		return usage();
+	if (argc > 1)
+		count = atoi(argv[1]);
+	if (argc > 2)
+		poll_count = atoi(argv[2]);
+	if (count <= 0 || poll_count < 0)
+		return usage();
+
+	r64 blocking = bench_round_trips(false, count);
+	if (blocking < 0.0)
+	{
+		fprintf(stderr, "%s", "Error: blocking round trip returned the wrong answer\n");
+		return 1;
+	}
+	printf("wait_read: %.2fus per round trip (%d round trips)\n", blocking, count);
+
+	if (poll_count > 0)
+	{
+		r64 polling = bench_round_trips(true, poll_count);
+		if (polling < 0.0)
+		{
+			fprintf(stderr, "%s", "Error: polling round trip returned the wrong answer\n");
+			return 1;
+		}
+		printf("1/60s polling: %.2fus per round trip (%d round trips)\n", polling, poll_count);
+	}
+
+	return 0;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	return VI::proc(argc, argv);
+}
@@ -0,0 +1,188 @@
+#include "task_graph.h"
+#include "lmath.h"
+#include "vi_assert.h"
+#include <string.h>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#define TASK_GRAPH_MAX_WORKERS 7
+#define TASK_GRAPH_MAX_TASKS 64
+
+namespace VI
+{
+
+namespace TaskGraphPool
+{
+	struct Task
+	{
+		TaskGraph::Function function;
+		s32 slice;
+		s32 slice_count;
+	};
+
+	std::thread workers[TASK_GRAPH_MAX_WORKERS];
+	s32 worker_count;
+	std::mutex mutex;
+	std::condition_variable task_available;
+	std::condition_variable task_finished;
+	Task tasks[TASK_GRAPH_MAX_TASKS]; // protected by mutex, along with everything below
+	s32 task_count;
+	s32 task_next;
+	s32 task_done;
+	const Update* update;
+	b8 quit;
+
+	void worker_loop()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			while (!quit && task_next == task_count)
+				task_available.wait(lock);
+
+			if (quit)
+				break;
+
+			Task task = tasks[task_next];
+			task_next++;
+
+			lock.unlock();
+			task.function(*update, task.slice, task.slice_count);
+			lock.lock();
+
+			task_done++;
+			if (task_done == task_count)
+				task_finished.notify_all();
+		}
+	}
+
+	// the calling thread helps out, then blocks until every task is finished
+	void run(const Update& u, const Task* batch, s32 count)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		memcpy(tasks, batch, sizeof(Task) * count);
+		task_count = count;
+		task_next = 0;
+		task_done = 0;
+		update = &u;
+		task_available.notify_all();
+
+		while (task_next < task_count)
+		{
+			Task task = tasks[task_next];
+			task_next++;
+
+			lock.unlock();
+			task.function(u, task.slice, task.slice_count);
+			lock.lock();
+
+			task_done++;
+		}
+
+		while (task_done < task_count)
+			task_finished.wait(lock);
+	}
+}
+
+void TaskGraph::init(s32 count)
+{
+	using namespace TaskGraphPool;
+	if (count == -1)
+	{
+		s32 cores = s32(std::thread::hardware_concurrency());
+		// the render, physics and AI threads already take up cores of their own
+		count = cores / 2 - 1;
+	}
+	worker_count = vi_max(0, vi_min(TASK_GRAPH_MAX_WORKERS, count));
+	quit = false;
+	for (s32 i = 0; i < worker_count; i++)
+		workers[i] = std::thread(worker_loop);
+}
+
+void TaskGraph::term()
+{
+	using namespace TaskGraphPool;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	task_available.notify_all();
+	for (s32 i = 0; i < worker_count; i++)
+		workers[i].join();
+	worker_count = 0;
+}
+
+s32 TaskGraph::thread_count()
+{
+	return TaskGraphPool::worker_count + 1;
+}
+
+void TaskGraph::clear()
+{
+	phases.length = 0;
+}
+
+void TaskGraph::add(Function function, ComponentMask reads, ComponentMask writes, s8 flags)
+{
+	Phase* phase = phases.add();
+	phase->function = function;
+	phase->reads = reads;
+	phase->writes = writes;
+	phase->flags = flags;
+}
+
+void TaskGraph::execute(const Update& u)
+{
+	s32 i = 0;
+	while (i < phases.length)
+	{
+		const Phase& first = phases[i];
+		s32 end = i + 1;
+
+		if (first.flags & FlagConcurrent)
+		{
+			// pull in following phases until one isn't concurrent or conflicts with something already in the run
+			ComponentMask reads = first.reads;
+			ComponentMask writes = first.writes;
+			while (end < phases.length)
+			{
+				const Phase& phase = phases[end];
+				if (!(phase.flags & FlagConcurrent)
+					|| (phase.writes & (reads | writes))
+					|| (phase.reads & writes))
+					break;
+				reads |= phase.reads;
+				writes |= phase.writes;
+				end++;
+			}
+		}
+
+		if (end == i + 1 && !(first.flags & FlagSliced))
+			first.function(u, 0, 1);
+		else
+		{
+			TaskGraphPool::Task batch[TASK_GRAPH_MAX_TASKS];
+			s32 count = 0;
+			for (s32 j = i; j < end; j++)
+			{
+				const Phase& phase = phases[j];
+				s32 slice_count = (phase.flags & FlagSliced) ? thread_count() : 1;
+				for (s32 slice = 0; slice < slice_count; slice++)
+				{
+					vi_assert(count < TASK_GRAPH_MAX_TASKS);
+					TaskGraphPool::Task* task = &batch[count];
+					task->function = phase.function;
+					task->slice = slice;
+					task->slice_count = slice_count;
+					count++;
+				}
+			}
+			TaskGraphPool::run(u, batch, count);
+		}
+
+		i = end;
+	}
+}
+
+}
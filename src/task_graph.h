@@ -0,0 +1,43 @@
+#pragma once
+
+#include "types.h"
+#include "data/array.h"
+
+namespace VI
+{
+
+// runs a list of update phases in declaration order.
+// a run of consecutive FlagConcurrent phases executes at the same time on the worker pool, as long as none of them
+// writes a component family that another phase in the run reads or writes.
+// every other phase runs alone on the calling thread, so side effects (entity removal, network messages, audio)
+// happen in the same order every frame.
+struct TaskGraph
+{
+	typedef void(*Function)(const Update&, s32, s32); // update, slice, slice count
+
+	enum Flags : s8
+	{
+		FlagConcurrent = 1 << 0, // no side effects outside the declared write set; may run alongside other phases
+		FlagSliced = 1 << 1, // phase splits its own work; called once per thread with a different slice
+	};
+
+	struct Phase
+	{
+		Function function;
+		ComponentMask reads;
+		ComponentMask writes;
+		s8 flags;
+	};
+
+	static void init(s32 = -1); // worker thread count; -1 picks one from the number of cores
+	static void term();
+	static s32 thread_count(); // worker threads plus the calling thread
+
+	Array<Phase> phases;
+
+	void clear();
+	void add(Function, ComponentMask, ComponentMask, s8 = 0);
+	void execute(const Update&);
+};
+
+}